@@ -76,6 +76,14 @@ private slots:
         }
     }
 
+    // 选择增量备份的基准备份文件
+    void selectBaseArchive() {
+        QString file = QFileDialog::getOpenFileName(this, "选择基准备份文件", "", "备份文件 (*.backup)");
+        if (!file.isEmpty()) {
+            baseArchiveEdit->setText(file);
+        }
+    }
+
     // 选择保存位置
     void selectSaveLocation() {
         // 1. 定义过滤器：允许显示所有文件 + 筛选.backup文件（用户可切换）
@@ -195,13 +203,22 @@ private slots:
         progressBar->setVisible(true);
         progressBar->setValue(0);
        
+        // 使用全部CPU核心并行压缩、加密
+        data_packet::back_up_options options;
+        options.thread_number = std::max(1, QThread::idealThreadCount());
+        // 大文件按4 MiB分块，分段读写，块之间并行压缩、加密
+        options.chunk_size = 4 * 1024 * 1024;
+        // 选择了基准备份时进行增量备份
+        options.base_archive = baseArchiveEdit->text().toStdString();
+
         std::string backupResult = data_packet::back_up(
             backupDirEdit->text().toStdString(),
             saveLocationEdit->text().toStdString(),
             huffmanRadio->isChecked()?"HUFFMAN":"LZ77",
             passwordEdit->text().toStdString().empty()?"NONE":"AES_256_CBC",
             passwordEdit->text().toStdString(),
-            strFilteredFiles
+            strFilteredFiles,
+            options
         );
         // 模拟进度
         
@@ -234,11 +251,39 @@ private slots:
         QMessageBox::information(this, "提示", "备份文件加载成功");
     }
 
-    // 恢复备份（仅前端框架）
+    // 恢复备份
     void restoreBackup() {
+        restore(false);
+    }
+
+    // 只恢复备份中指定的文件
+    void restoreSelected() {
+        restore(true);
+    }
+
+private:
+    // 恢复备份的公共流程，selective为true时只恢复用户输入的路径或通配符匹配的文件
+    void restore(bool selective) {
         QString backupFile = QFileDialog::getOpenFileName(this, "选择备份文件", "", "备份文件 (*.backup)");
         if (backupFile.isEmpty()) return;
 
+        std::string includingFiles;
+        if (selective) {
+            bool ok;
+            QString patterns = QInputDialog::getMultiLineText(
+                this,
+                "选择恢复文件",
+                "请输入需要恢复的相对路径或通配符（如 docs/*.txt），每行一个:",
+                "",
+                &ok
+            );
+            if (!ok || patterns.trimmed().isEmpty()) {
+                QMessageBox::warning(this, "取消", "恢复操作已取消");
+                return;
+            }
+            includingFiles = patterns.toStdString();
+        }
+
         QString restoreDir = QFileDialog::getExistingDirectory(this, "选择恢复目录");
         if (restoreDir.isEmpty()) return;
         
@@ -251,7 +296,7 @@ private slots:
 
         // 解析加密方式
         std::string password;
-        bool isEncrypted = (infoStr.find("encryption method:AES 256 CBC") != std::string::npos);
+        bool isEncrypted = (infoStr.find("encryption method:AES 256") != std::string::npos);
 
         if (isEncrypted) {
             bool ok;
@@ -268,16 +313,38 @@ private slots:
                 return;
             }
             password = qPassword.toStdString();
+
+            // 包中有密码校验值时，在还原任何文件之前检查密码
+            if (infoStr.find("password check:yes") != std::string::npos) {
+                std::string checkResult = data_packet::verify_password(backupFile.toStdString(), password);
+                if (checkResult != "OK") {
+                    QMessageBox::critical(this, "错误", QString::fromStdString(checkResult));
+                    return;
+                }
+            }
         }
 
         progressBar->setVisible(true);
         progressBar->setValue(0);
 
-        std::string restoreResult=data_packet::restore_backup(
-            backupFile.toStdString(),    // 备份文件路径
-            restoreDir.toStdString(),    // 恢复目录
-            password
-        );
+        // 分块编码的大文件使用全部CPU核心并行解密、解压
+        data_packet::back_up_options options;
+        options.thread_number = std::max(1, QThread::idealThreadCount());
+
+        std::string restoreResult = selective
+            ? data_packet::restore_selected(
+                backupFile.toStdString(),    // 备份文件路径
+                restoreDir.toStdString(),    // 恢复目录
+                password,
+                includingFiles,              // 需要恢复的文件
+                options
+            )
+            : data_packet::restore_backup(
+                backupFile.toStdString(),    // 备份文件路径
+                restoreDir.toStdString(),    // 恢复目录
+                password,
+                options
+            );
         // 模拟进度
         for (int i = 0; i <= 100; i += 10) {
             progressBar->setValue(i);
@@ -300,6 +367,7 @@ private:
     QListWidget *fullFileList;
     QLineEdit *backupDirEdit;
     QLineEdit *saveLocationEdit;
+    QLineEdit *baseArchiveEdit;
     QLineEdit *fileFilterEdit;
     QLineEdit *passwordEdit;
     QCheckBox *showHiddenCheckBox;
@@ -403,6 +471,17 @@ private:
         saveLayout->addWidget(saveLocationEdit);
         saveLayout->addWidget(browseSaveBtn);
 
+        // 增量备份的基准备份，为空时进行完整备份
+        QHBoxLayout *baseLayout = new QHBoxLayout();
+        baseArchiveEdit = new QLineEdit();
+        baseArchiveEdit->setPlaceholderText("增量备份时选择上一次的备份文件（为空则完整备份）");
+        baseArchiveEdit->setClearButtonEnabled(true);
+        QPushButton *browseBaseBtn = new QPushButton("浏览...");
+        connect(browseBaseBtn, &QPushButton::clicked, this, &BackupGUI::selectBaseArchive);
+        baseLayout->addWidget(new QLabel("基准备份:"));
+        baseLayout->addWidget(baseArchiveEdit);
+        baseLayout->addWidget(browseBaseBtn);
+
         // 压缩算法选择
         QHBoxLayout *compressionLayout = new QHBoxLayout();
         huffmanRadio = new QRadioButton("Huffman压缩");
@@ -422,6 +501,7 @@ private:
         encryptionLayout->addWidget(passwordEdit);
 
         layout->addLayout(saveLayout);
+        layout->addLayout(baseLayout);
         layout->addLayout(compressionLayout);
         layout->addLayout(encryptionLayout);
 
@@ -453,16 +533,19 @@ private:
         QPushButton *backupBtn = new QPushButton("执行备份");
         QPushButton *loadBtn = new QPushButton("加载备份文件");
         QPushButton *restoreBtn = new QPushButton("恢复备份");
+        QPushButton *restoreSelectedBtn = new QPushButton("部分恢复");
         QPushButton *exitBtn = new QPushButton("退出");
 
         connect(backupBtn, &QPushButton::clicked, this, &BackupGUI::performBackup);
         connect(loadBtn, &QPushButton::clicked, this, &BackupGUI::loadBackupFile);
         connect(restoreBtn, &QPushButton::clicked, this, &BackupGUI::restoreBackup);
+        connect(restoreSelectedBtn, &QPushButton::clicked, this, &BackupGUI::restoreSelected);
         connect(exitBtn, &QPushButton::clicked, qApp, &QApplication::quit);
 
         buttonLayout->addWidget(backupBtn);
         buttonLayout->addWidget(loadBtn);
         buttonLayout->addWidget(restoreBtn);
+        buttonLayout->addWidget(restoreSelectedBtn);
         buttonLayout->addWidget(exitBtn);
 
         mainLayout->addLayout(buttonLayout);
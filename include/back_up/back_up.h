@@ -9,14 +9,59 @@
 
 namespace data_packet
 {
+    /**
+     * @struct back_up_options
+     * @brief 备份的可选参数，均有默认值
+     */
+    struct back_up_options
+    {
+        /// 内存预算（字节）：同一批读入内存的原始文件数据总量不超过该值，单个超出预算的文件单独成批
+        size_t memory_budget = 64 * 1024 * 1024;
+
+        /// 遍历目录、压缩与加密的工作线程数：1为单线程顺序处理，0为使用全部硬件线程
+        unsigned int thread_number = 1;
+
+        /// 分块编码的块大小（字节）：大于该值的常规文件按块独立压缩、加密，分段读写且块之间可并行处理；
+        /// 0表示不分块，否则需在MIN_CHUNK_SIZE与MAX_CHUNK_SIZE（64 KiB ~ 16 MiB）之间
+        size_t chunk_size = 0;
+
+        /// 压缩比上限：压缩后与原始大小之比超过该值的文件（或块）改为不压缩存储；
+        /// 较大的数据先抽样试压缩，样本超过该值时直接跳过完整压缩。取无穷大时总是保留压缩结果
+        double max_compression_ratio = 0.95;
+
+        /// LZ77长距离匹配窗口大小的对数：0为不启用，否则需在20与31之间（1 MiB ~ 2 GiB）。
+        /// 启用后完整读入内存的文件（及分块编码的每一块）可以引用窗口内任意远的重复内容，
+        /// 索引的内存占用有上限；使用了长距离匹配的文件在中央目录中记录窗口大小
+        unsigned int long_distance_window_log = 0;
+
+        /// LZ77压缩级别：1~9，默认为3。1~3为贪心匹配，4~6为惰性匹配，7~9为二叉树查找与最优划分，
+        /// 级别越高压缩率越好、压缩越慢，解压速度不受影响。压缩级别记录在中央目录中
+        unsigned int compression_level = 3;
+
+        /// 增量备份的基准备份包：非空时只写入相对基准有变化的文件，未变化的文件只记录头部，
+        /// 已删除的文件记录为not_found类型。还原时需先还原基准备份，再在同一目录上还原增量备份
+        std::filesystem::path base_archive;
+
+        /// 去重的块存储目录：非空时常规文件的内容按内容定义分块，每个不同的块压缩、加密后只在块存储中保存一次，
+        /// 备份包中只记录块引用列表，此时不使用chunk_size分块编码。还原这样的备份包时需指定同一块存储
+        std::filesystem::path chunk_store;
+
+        /// 加密时由密码派生备份包密钥所用的PBKDF2-HMAC-SHA256迭代次数：1000~100000000，默认为200000。
+        /// 每次备份、还原只派生一次，迭代次数与随机盐记录在包扩展字段中，各文件使用由其随机盐计算的子密钥。
+        /// 块存储第一次保存加密的块时也以此生成其密钥派生参数，记录在块存储的根目录中
+        unsigned int kdf_iterations = 200000;
+    };
+
     /**
      * @brief 将指定路径下的文件进行打包备份，并将备份包写入指定目录
      * @param source 需要打包的指定目录
      * @param destination 打包后输出的指定目录
      * @param compression_method 压缩方法，提供三种：NONE，LZ77，HUFFMAN
-     * @param encryption_method 加密方法，提供两种：NONE，AES_256_CBC
+     * @param encryption_method 加密方法，提供三种：NONE，AES_256_CBC，AES_256_GCM（分块并行加密并认证）
      * @param password 加密用的密码
-     * @param not_including_files 不需要打包的多个文件，用换行分割，传相对路径，相对路径是相对于source的
+     * @param not_including_files 不需要打包的多个文件，用换行分割，传相对于source的相对路径或通配符模式（见path_matcher）。
+     * 匹配的目录在遍历时即被跳过，其下的全部内容都不会被读取或打包
+     * @param options 可选参数，见back_up_options
      * @return 两种返回值，一是“OK”，表示没有问题；二是报错信息。所有不是“OK”的都是有问题的，报错信息在返回值里。
      */
     std::string back_up(const std::filesystem::path& source,
@@ -24,7 +69,8 @@ namespace data_packet
                         const std::string& compression_method,
                         const std::string& encryption_method,
                         const std::string& password,
-                        const std::string& not_including_files);
+                        const std::string& not_including_files,
+                        const back_up_options& options = {});
 
     /**
      * @brief 获取指定目录的备份包的信息
@@ -39,11 +85,38 @@ namespace data_packet
      * @param source 备份包的目录
      * @param destination 需要还原的指定位置，即展开备份包的路径
      * @param password 解密用的密钥，如果没有加密这个就为空
+     * @param options 可选参数，分块编码的文件按其中的内存预算与线程数并行解密、解压，去重备份从其中的块存储读取文件内容
      * @return 两种返回值，一是“OK”，表示没有问题；二是报错信息。所有不是“OK”的都是有问题的，报错信息在返回值里。
      */
     std::string restore_backup(const std::filesystem::path& source,
                                const std::filesystem::path& destination,
-                               const std::string& password);
+                               const std::string& password,
+                               const back_up_options& options = {});
+
+    /**
+     * @brief 只还原备份包中指定的文件，未选中的文件数据直接跳过，不解密也不解压
+     * @param source 备份包的目录
+     * @param destination 需要还原的指定位置，即展开备份包的路径
+     * @param password 解密用的密钥，如果没有加密这个就为空
+     * @param including_files 需要还原的多个文件，用换行分割，传相对路径或通配符模式（*、?、[...]，其中*可匹配'/'），
+     * 选中目录时还原其下全部内容；所需的上级目录与硬链接目标会一并还原
+     * @param options 可选参数，分块编码的文件按其中的内存预算与线程数并行解密、解压，去重备份从其中的块存储读取文件内容
+     * @return 两种返回值，一是“OK”，表示没有问题；二是报错信息。所有不是“OK”的都是有问题的，报错信息在返回值里。
+     */
+    std::string restore_selected(const std::filesystem::path& source,
+                                 const std::filesystem::path& destination,
+                                 const std::string& password,
+                                 const std::string& including_files,
+                                 const back_up_options& options = {});
+
+    /**
+     * @brief 检查备份包的密码，只读取包的头部与中央目录，不解密任何文件数据
+     * @param source 备份包的目录
+     * @param password 需要检查的密码
+     * @return 两种返回值，一是“OK”，表示密码正确或备份包没有加密；二是报错信息，如密码错误，
+     * 或旧版本的加密包没有保存密码校验值、只能在还原时发现错误的密码。
+     */
+    std::string verify_password(const std::filesystem::path& source, const std::string& password);
 }
 
 
@@ -7,7 +7,7 @@
 #include <vector>
 #include <string>
 #include <cstring>
-#include <bitset>
+#include <algorithm>
 namespace data_packet
 {
 
@@ -27,6 +27,24 @@ namespace data_packet
     class Huffman
     {
     public:
+        /**
+         * @brief 整数形式的哈夫曼编码
+         * @struct Huffman_code
+         * @param code 编码，低length位有效，高位在前
+         * @param length 编码长度，0表示该字符未出现
+         */
+        struct Huffman_code
+        {
+            qword code = 0;
+            uint8_t length = 0;
+        };
+
+        /// 编码的最大长度，超过时无法存入qword（需要远超TB级的数据才会出现）
+        static constexpr unsigned int MAX_CODE_LENGTH = 64;
+
+        /// 范式哈夫曼编码的最大码长，码长以4位存储
+        static constexpr unsigned int MAX_CANONICAL_CODE_LENGTH = 15;
+
         /**
          * @brief 哈夫曼树 树节点的结构
          * @struct Huffman_tn
@@ -106,14 +124,144 @@ namespace data_packet
         /**
          * @brief 对哈夫曼树进行编码，递归函数
          * @param node 哈夫曼树节指针，用unique_ptr的get获取
-         * @param prefix 该节点的哈夫曼编码
+         * @param code 该节点的哈夫曼编码
+         * @param length 该节点的哈夫曼编码长度
+         * @throws std::runtime_error 编码长度超过MAX_CODE_LENGTH时抛出
          */
-        void encoding_dfs(Huffman_tn* node, std::string prefix);
+        void encoding_dfs(Huffman_tn* node, qword code = 0, unsigned int length = 0);
 
         qword times[256];//词频表
-        std::string Huffman_coding[256];//字母对应的Huffman编码
+        Huffman_code Huffman_coding[256];//字母对应的Huffman编码
     };
 
+    namespace detail
+    {
+        /**
+         * @brief 按大端字节序写入8字节
+         * @param out 输出位置
+         * @param value 写入的四字
+         */
+        inline void store_big_endian(byte* out, qword value)
+        {
+            for (int i = 7; i >= 0; --i)
+            {
+                out[i] = static_cast<byte>(value & 0xff);
+                value >>= 8;
+            }
+        }
+
+        /**
+         * @brief 高位在前的位写入器，使用64位累加器缓存，写满后按大端字节序整字写出
+         * @details 调用方需保证输出缓冲区足够容纳全部位，写入器不检查边界
+         */
+        class bit_writer
+        {
+        public:
+            /**
+             * @brief 构造写入器
+             * @param out 输出起始位置
+             */
+            explicit bit_writer(byte* out) : _out(out) {}
+
+            /**
+             * @brief 写入编码
+             * @param code 编码，仅低length位有效且其余位为0
+             * @param length 编码长度，不超过64
+             */
+            void write(qword code, unsigned int length)
+            {
+                if (_fill + length < 64)
+                {
+                    _accumulator |= code << (64 - _fill - length);
+                    _fill += length;
+                    return;
+                }
+
+                //累加器写满：先写入能放下的高位部分，剩余低位放入新的累加器
+                const unsigned int rest = _fill + length - 64;
+                _accumulator |= code >> rest;
+                store_big_endian(_out, _accumulator);
+                _out += 8;
+                _accumulator = rest == 0 ? 0 : code << (64 - rest);
+                _fill = rest;
+            }
+
+            /**
+             * @brief 写出累加器中剩余的位，不足一字节的部分低位补0
+             */
+            void flush()
+            {
+                for (unsigned int i = 0; i * 8 < _fill; ++i)
+                {
+                    *_out++ = static_cast<byte>(_accumulator >> (56 - i * 8));
+                }
+                _accumulator = 0;
+                _fill = 0;
+            }
+
+        private:
+            byte* _out;
+            qword _accumulator = 0;   ///< 高位对齐的待写出位
+            unsigned int _fill = 0;   ///< 累加器中的有效位数
+        };
+
+        /**
+         * @brief 对连续内存中的哈夫曼压缩数据解压
+         * @details 按词频表重建与压缩时相同的哈夫曼树，生成查找表后通过64位位缓冲区逐符号查表解码，
+         * 码长不超过查找表位数的符号一次查表即可解码，更长的编码在查表后沿树继续逐位解码。
+         * 解压结果直接写入按词频总和预先分配的缓冲区。
+         * @param data 压缩数据起始位置
+         * @param size 压缩数据长度
+         * @return 已解压的数据及其长度
+         * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> Huffman_decode(const uint8_t* data, size_t size);
+
+        /**
+         * @brief 对连续内存中的数据进行范式哈夫曼压缩
+         * @details 输出格式：原始长度(LEB128变长整数) + 最大字符 + 各字符码长 + 编码数据。
+         * 码长从字符0到最大字符依次以4位存储，高4位在前，连续未出现的字符以 0 + (个数-1) 两个4位表示，
+         * 至多16个，不足一字节时低4位补0。码长超过MAX_CANONICAL_CODE_LENGTH时将词频减半后重建哈夫曼树。
+         * 编码由码长唯一确定：按（码长，字符）排序后依次分配，因此无需保存词频表。
+         * @param data 待压缩数据起始位置
+         * @param size 待压缩数据长度
+         * @return 已压缩的数据及其长度
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> canonical_Huffman_encode(const uint8_t* data, size_t size);
+
+        /**
+         * @brief 对连续内存中的范式哈夫曼压缩数据解压，由码长重建编码后通过查找表解码，一次查表可解码两个短编码
+         * @param data 压缩数据起始位置
+         * @param size 压缩数据长度
+         * @return 已解压的数据及其长度
+         * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> canonical_Huffman_decode(const uint8_t* data, size_t size);
+
+        /**
+         * @brief 对任意单字节迭代器区间调用处理连续内存的函数，非连续内存先复制到连续缓冲区
+         * @param begin 区间起始位置
+         * @param buffer_size 区间大小
+         * @param func 处理连续内存的函数
+         * @return func的返回值
+         */
+        template<typename Iter, typename Func>
+        std::pair<std::unique_ptr<byte[]>, size_t> with_contiguous(const Iter& begin, size_t buffer_size, Func&& func)
+        {
+            static_assert(sizeof(typename std::iterator_traits<Iter>::value_type) == sizeof(uint8_t), "Element type must be 1 byte");
+            if constexpr (std::contiguous_iterator<Iter>)
+            {
+                return func(reinterpret_cast<const uint8_t*>(std::to_address(begin)), buffer_size);
+            }
+            else
+            {
+                std::vector<uint8_t> buffer(buffer_size);
+                std::copy_n(begin, buffer_size, buffer.begin());
+                return func(buffer.data(), buffer.size());
+            }
+        }
+    }
+
     /**
   * @brief 进行哈夫曼压缩算法，传入待压缩数据迭代器的头尾
   * @param begin 闭区间起始位置
@@ -149,6 +297,32 @@ namespace data_packet
     std::pair<std::unique_ptr<byte[]>, size_t> Huffman_decompress(const Iter& begin, size_t buffer_size);
 
 
+    /**
+      * @brief 进行范式哈夫曼压缩，只保存出现字符的码长，头部通常只有几十字节
+      * @param begin 闭区间起始位置
+      * @param end 开区间结束位置
+      * @return 已压缩的数据及其长度
+      */
+    template<typename Iter>
+    std::pair<std::unique_ptr<byte[]>, size_t> canonical_Huffman_compress(const Iter& begin, const Iter& end)
+    {
+        return detail::with_contiguous(begin, static_cast<size_t>(std::distance(begin, end)),
+                                       detail::canonical_Huffman_encode);
+    }
+
+    /**
+      * @brief 进行范式哈夫曼解压
+      * @param begin 闭区间起始位置
+      * @param end 开区间结束位置
+      * @return 已解压的数据及其长度
+      * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
+      */
+    template<typename Iter>
+    std::pair<std::unique_ptr<byte[]>, size_t> canonical_Huffman_decompress(const Iter& begin, const Iter& end)
+    {
+        return detail::with_contiguous(begin, static_cast<size_t>(std::distance(begin, end)),
+                                       detail::canonical_Huffman_decode);
+    }
 
     template<typename Iter>
     std::pair<std::unique_ptr<data_packet::byte[]>, size_t>data_packet::Huffman_compress(const Iter& begin, const Iter& end)
@@ -168,62 +342,43 @@ namespace data_packet
             huffman.times[(uint8_t)*it++]++;
         }
 
-        //建Huffman树
-        std::unique_ptr<data_packet::Huffman::Huffman_tn> huffman_tree_head = huffman.Create_Huffman_Tree();
-
-        //遍历获取字符序列
-        huffman.encoding_dfs(huffman_tree_head.get(), std::string());
-
-        //释放Huffman树空间
-        huffman_tree_head.release();
+        //建Huffman树并遍历获取每个字符的编码
+        huffman.encoding_dfs(huffman.Create_Huffman_Tree().get());
 
-        //用字符串暂存编码后的01序列
-        std::string encoding_stream;
-
-        it = begin;
-        for (size_t i=0;i<buffer_size;i++)
+        //由词频与码长计算编码总位数，无需暂存01序列
+        qword bit_count = 0;
+        for (size_t i = 0; i < 256; i++)
         {
-            encoding_stream += huffman.Huffman_coding[(uint8_t)*it++];
+            bit_count += huffman.times[i] * huffman.Huffman_coding[i].length;
         }
 
         //计算补位长度
-        byte padding_length = (encoding_stream.size() % 8 == 0 ? 0 : 8 - encoding_stream.size() % 8);
+        byte padding_length = (bit_count % 8 == 0 ? 0 : 8 - bit_count % 8);
 
         //计算长度
-        const size_t compressed_data_length = (8 + 64 * 256 + encoding_stream.size() + padding_length) / 8;//2049个byte存头文件，string/8+[1]
+        const size_t compressed_data_length = 1 + 256 * 8 + (bit_count + padding_length) / 8;//2049个byte存头文件
 
-        std::unique_ptr<byte[]> compressed_data = std::make_unique<byte[]>(compressed_data_length);
+        std::unique_ptr<byte[]> compressed_data = std::make_unique_for_overwrite<byte[]>(compressed_data_length);
 
         //写入文件头及压缩数据
         compressed_data[0] = padding_length;
 
         //定长词频表
-        for (uint32_t i = 1; i <= 256 * 8; i += 8)
+        for (uint32_t i = 0; i < 256; i++)
         {
-            compressed_data[i] |= (byte)(huffman.times[(i - 1) >> 3] >> 56 & 0xff);
-            compressed_data[i + 1] |= (byte)(huffman.times[(i - 1) >> 3] >> 48 & 0xff);
-            compressed_data[i + 2] |= (byte)(huffman.times[(i - 1) >> 3] >> 40 & 0xff);
-            compressed_data[i + 3] |= (byte)(huffman.times[(i - 1) >> 3] >> 32 & 0xff);
-            compressed_data[i + 4] |= (byte)(huffman.times[(i - 1) >> 3] >> 24 & 0xff);
-            compressed_data[i + 5] |= (byte)(huffman.times[(i - 1) >> 3] >> 16 & 0xff);
-            compressed_data[i + 6] |= (byte)(huffman.times[(i - 1) >> 3] >> 8 & 0xff);
-            compressed_data[i + 7] |= (byte)(huffman.times[(i - 1) >> 3] & 0xff);
+            detail::store_big_endian(compressed_data.get() + 1 + i * 8, huffman.times[i]);
         }
 
-        size_t i = 0, j = 256 * 8 + 1;
-        //压缩数据
-        if(encoding_stream.size()>=8)
-        for (; i < encoding_stream.size() + (padding_length==0?8:padding_length) - 8; i += 8, j++)
-        {
-            std::bitset<8> tmp(encoding_stream.substr(i, 8));
-            compressed_data[j] = (byte)tmp.to_ullong();
-        }
-        //补位
-        if (padding_length != 0)
+        //压缩数据：编码高位在前依次写入64位累加器，写满后整字写出
+        detail::bit_writer writer(compressed_data.get() + 1 + 256 * 8);
+        it = begin;
+        for (size_t i = 0; i < buffer_size; i++)
         {
-            std::bitset<8> tmp(encoding_stream.substr(i, 8 - padding_length));
-            compressed_data[j] = (byte)((tmp << padding_length).to_ullong());
+            const Huffman::Huffman_code& code = huffman.Huffman_coding[(uint8_t)*it++];
+            writer.write(code.code, code.length);
         }
+        //补位，剩余位数不足一字节时低位补0
+        writer.flush();
 
         return std::make_pair(std::move(compressed_data), compressed_data_length);
     }
@@ -231,84 +386,14 @@ namespace data_packet
     template <typename Iter>
     std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::Huffman_decompress(const Iter& begin, const Iter& end)
     {
-        return Huffman_decompress(begin, size_t(end - begin));
+        return Huffman_decompress(begin, static_cast<size_t>(std::distance(begin, end)));
     }
 
     template <typename Iter>
     std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::Huffman_decompress(const Iter& begin, size_t buffer_size)
     {
-        //传入迭代器的类型检查
-        static_assert(sizeof(typename std::iterator_traits<Iter>::value_type) == sizeof(uint8_t), "Element type must be 1 byte");
-        
-        Huffman decoding_huffman;
-        
-        auto it = begin;
-        //压缩数据流第一字节为padding_length,解码
-        byte padding_length = *it++;
-        
-        //从压缩数据流中还原解压表
-        for (size_t i = 0; i < 256; i++)
-        {
-            for (size_t j = 0; j < 8; j++)
-            {
-                decoding_huffman.times[i] <<= 8;
-                decoding_huffman.times[i] |= (uint8_t)*it++;
-            }
-        }
-        
-        //暂存压缩数据的哈弗曼编码序列
-        std::string encoded_stream;
-        
-        //特判，如果大小 小于等于2049，说明压缩数据为空。
-        if(buffer_size>=2050)
-        {
-            for (size_t i = 0; i < buffer_size - 2049-1; i++)
-            {
-                std::bitset<8> tmp = *it++;
-                encoded_stream += tmp.to_string();
-            }
-            {
-                std::bitset<8> tmp = *it;
-                encoded_stream += tmp.to_string().substr(0,8-padding_length);
-            }
-        }
-        //建哈夫曼树
-        std::unique_ptr<Huffman::Huffman_tn> huffman_tree_head = decoding_huffman.Create_Huffman_Tree();
-        
-        //解码流
-        std::string decoding_stream;
-        //遍历树指针
-        Huffman::Huffman_tn* huffman_tree_node = huffman_tree_head.get();
-        
-        //解码数据，通过移动哈夫曼树的指针找到该编码的字符
-        for (size_t i = 0; i < encoded_stream.size(); i++)
-        {
-            if (encoded_stream[i] == '0')
-            {
-                huffman_tree_node = huffman_tree_node->lson.get();
-            }
-            else
-            {
-                huffman_tree_node = huffman_tree_node->rson.get();
-            }
-            if (huffman_tree_node->word != -1)
-            {
-                decoding_stream += (byte)(huffman_tree_node->word);
-                huffman_tree_node = huffman_tree_head.get();
-            }
-        }
-        //释放哈夫曼树资源
-        huffman_tree_node = nullptr;
-        huffman_tree_head.release();
-        
-        //返回值赋值
-        std::unique_ptr<byte[]> decompressed_data = std::make_unique<byte[]>(decoding_stream.size());
-        for (size_t i = 0; i < decoding_stream.size(); i++)
-        {
-            decompressed_data[i] = (byte)decoding_stream[i];
-        }
-
-        return std::pair<std::unique_ptr<byte[]>, size_t>(std::move(decompressed_data), decoding_stream.size());
+        //连续内存直接解码，其它迭代器先复制到连续缓冲区
+        return detail::with_contiguous(begin, buffer_size, detail::Huffman_decode);
     }
 
 }
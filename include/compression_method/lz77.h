@@ -4,8 +4,9 @@
 
 #ifndef DATA_BACK_UP_LZ77_H
 #define DATA_BACK_UP_LZ77_H
-#include <chrono>
 #include <cstring>
+#include <iterator>
+#include <utility>
 #include <memory>
 #include <vector>
 
@@ -15,23 +16,258 @@ namespace data_packet
 {
     constexpr unsigned short FRONT_SIZE = 255;
     constexpr unsigned short BACK_SIZE = 65535;
+    constexpr unsigned int SEQUENCE_MIN_MATCH = 4;         ///< 序列格式的最短匹配长度
+    constexpr unsigned int SEQUENCE_MAX_MATCH = 1u << 24;  ///< 序列格式单个匹配的最大长度
+    constexpr unsigned int MIN_WINDOW_LOG = 20;           ///< 长距离匹配窗口大小对数的下限（1 MiB）
+    constexpr unsigned int MAX_WINDOW_LOG = 31;           ///< 长距离匹配窗口大小对数的上限（2 GiB）
+    constexpr unsigned int MIN_LEVEL = 1;                 ///< 最低（最快）的压缩级别
+    constexpr unsigned int MAX_LEVEL = 9;                 ///< 最高（压缩率最好）的压缩级别
+    constexpr unsigned int DEFAULT_LEVEL = 3;             ///< 默认的压缩级别
+
+    /**
+     * @struct lz77_parameters
+     * @brief 序列格式lz77压缩的参数，不影响解压
+     */
+    struct lz77_parameters
+    {
+        /// 长距离匹配窗口大小的对数：0为不启用，否则在MIN_WINDOW_LOG与MAX_WINDOW_LOG之间，
+        /// 超出BACK_SIZE的重复内容在该窗口内通过长距离匹配查找
+        unsigned int window_log = 0;
+
+        /// 压缩级别，在MIN_LEVEL与MAX_LEVEL之间：1~3为贪心匹配，哈希链逐级加深；4~6为惰性匹配；
+        /// 7~9使用二叉树匹配查找器，按编码后的字节数选择代价最小的序列划分
+        unsigned int level = DEFAULT_LEVEL;
+    };
+
     namespace detail
     {
         /**
-         * @brief 找到前缓冲区中与扫描缓冲区的最长匹配串位置，并返回扫描缓冲区已匹配串的下一个字符
-         * @param data 前缓冲区
-         * @param pattern 扫描缓冲区
-         * @param last 匹配结束后最后一个字符
-         * @return 匹配位置，匹配长度，下一个字符
+         * @class match_finder
+         * @brief 基于哈希链的匹配查找器，直接在连续的输入区间上查找，不复制窗口与前缓冲区
+         *
+         * 长度不小于3的匹配通过3字节哈希链查找，链长受max_chain限制；长度为1、2的匹配通过
+         * 记录每个单字节/双字节最近出现位置的表查找。默认的匹配满足lz77_decompress的要求：
+         * 偏移不超过BACK_SIZE，长度不超过FRONT_SIZE，且长度不超过偏移（匹配源不与当前位置重叠）；
+         * 序列格式可以指定更大的最大长度并允许匹配源与当前位置重叠。
+         */
+        class match_finder
+        {
+        public:
+            /// 默认哈希链最大查找深度
+            static constexpr unsigned int DEFAULT_CHAIN = 64;
+
+            /**
+             * @brief 构造查找器
+             * @param begin 输入数据起始位置
+             * @param end 输入数据结束位置
+             * @param max_chain 哈希链最大查找深度
+             * @param max_length 匹配的最大长度
+             * @param overlap 是否允许匹配长度超过偏移
+             */
+            match_finder(const byte* begin, const byte* end, unsigned int max_chain = DEFAULT_CHAIN,
+                         unsigned int max_length = FRONT_SIZE, bool overlap = false);
+
+            /**
+             * @brief 将指定位置加入索引，位置需按从前到后的顺序逐个加入
+             * @param position 输入区间内的位置
+             */
+            void insert(const byte* position);
+
+            /**
+             * @brief 在已加入索引的历史数据中查找指定位置的最长匹配，长度相同时取最近的匹配
+             * @param position 输入区间内的位置
+             * @return 匹配偏移（向前的距离）与匹配长度，无匹配时均为0
+             */
+            [[nodiscard]] std::pair<unsigned int, unsigned int> find(const byte* position) const;
+
+        private:
+            static constexpr size_t WINDOW_SIZE = 65536;   ///< prev表大小，需为2的幂且大于BACK_SIZE
+            static constexpr uint32_t REBASE = 1u << 30;  ///< 位置超过2*REBASE时整体平移
+
+            [[nodiscard]] uint32_t hash(const byte* position) const;
+            [[nodiscard]] size_t position_of(uint32_t stored) const;
+            void rebase();
+
+            const byte* _begin;
+            const byte* _end;
+            unsigned int _max_chain;
+            unsigned int _max_length;
+            bool _overlap;
+            unsigned int _hash_bits;
+            size_t _base{0};                 ///< 表中位置的基准，表中存储(位置 - _base + 1)，0表示空
+            std::vector<uint32_t> _head;     ///< 3字节哈希到最近位置
+            std::vector<uint32_t> _prev;     ///< 同一哈希的上一个位置，按位置对WINDOW_SIZE取模索引
+            std::vector<uint32_t> _last2;    ///< 双字节到最近位置
+            uint32_t _last1[256]{};          ///< 单字节到最近位置
+        };
+
+        /**
+         * @class binary_tree_finder
+         * @brief 基于二叉树的匹配查找器，每个位置给出所有更长的候选匹配，供最优划分使用
+         *
+         * 以4字节哈希为根，窗口内相同哈希的位置按其后的数据排序组织为二叉树，查找当前位置的同时将其插入为新的根，
+         * 沿途得到长度递增的候选匹配。树的节点按位置对窗口大小取模存放，偏移不超过BACK_SIZE，匹配允许重叠。
+         */
+        class binary_tree_finder
+        {
+        public:
+            /**
+             * @brief 构造查找器
+             * @param begin 输入数据起始位置
+             * @param end 输入数据结束位置
+             * @param depth 每次查找最多访问的节点数
+             * @param nice_length 候选匹配达到该长度时停止查找
+             */
+            binary_tree_finder(const byte* begin, const byte* end, unsigned int depth, unsigned int nice_length);
+
+            /**
+             * @brief 查找指定位置的候选匹配并将该位置加入树，位置需按从前到后的顺序逐个给出
+             * @param position 输入区间内的位置
+             * @param matches 输出的候选匹配（偏移，长度），长度严格递增，长度不超过nice_length
+             */
+            void find(const byte* position, std::vector<std::pair<unsigned int, unsigned int>>& matches);
+
+            /**
+             * @brief 只将指定位置加入树，用于跳过已被匹配覆盖的位置
+             * @param position 输入区间内的位置
+             */
+            void insert(const byte* position);
+
+        private:
+            static constexpr size_t WINDOW_SIZE = 65536;   ///< 树的节点数，需为2的幂且大于BACK_SIZE
+
+            [[nodiscard]] uint32_t hash(const byte* position) const;
+            void update(const byte* position, std::vector<std::pair<unsigned int, unsigned int>>* matches);
+
+            const byte* _begin;
+            const byte* _end;
+            unsigned int _depth;
+            unsigned int _nice_length;
+            unsigned int _hash_bits;
+            std::vector<uint64_t> _head;   ///< 4字节哈希到树根位置（位置 + 1，0表示空）
+            std::vector<uint64_t> _tree;   ///< 每个位置的左右子节点
+        };
+
+        /**
+         * @class long_distance_finder
+         * @brief 长距离匹配查找器，在远超BACK_SIZE的窗口内查找较长的重复内容
+         *
+         * 对每个位置开始的LONG_MATCH字节计算Gear滚动哈希，哈希满足采样条件的位置（约1/128）记入分桶的哈希表，
+         * 表的大小由窗口与输入大小决定并有上限，因此内存占用有界。只有采样位置会被查找，
+         * 一段足够长的重复内容中总有采样位置，匹配在此基础上向后延伸，由调用方向前延伸。
+         */
+        class long_distance_finder
+        {
+        public:
+            static constexpr unsigned int LONG_MATCH = 64;   ///< 滚动哈希覆盖的字节数，也是长距离匹配的最短长度
+
+            /**
+             * @brief 构造查找器
+             * @param begin 输入数据起始位置
+             * @param end 输入数据结束位置
+             * @param window_log 窗口大小的对数
+             */
+            long_distance_finder(const byte* begin, const byte* end, unsigned int window_log);
+
+            /**
+             * @brief 将指定位置加入索引，位置需按从前到后的顺序逐个加入
+             * @param position 输入区间内的位置
+             */
+            void insert(const byte* position);
+
+            /**
+             * @brief 查找指定位置的长距离匹配，需在该位置加入索引之前调用
+             * @param position 输入区间内的位置
+             * @return 匹配偏移与匹配长度，无匹配时均为0
+             */
+            [[nodiscard]] std::pair<size_t, size_t> find(const byte* position);
+
+        private:
+            static constexpr unsigned int BUCKET_SIZE = 4;   ///< 每个桶保存的位置数
+            static constexpr unsigned int SAMPLE_LOG = 7;    ///< 采样率的对数
+
+            /**
+             * @brief 计算指定位置的滚动哈希，位置连续递增时增量计算
+             * @param position 输入区间内的位置，之后需至少有LONG_MATCH个字节
+             * @return 哈希值
+             */
+            uint64_t hash(const byte* position);
+
+            [[nodiscard]] static bool sampled(uint64_t value) { return (value >> 32 & ((1u << SAMPLE_LOG) - 1)) == 0; }
+
+            const byte* _begin;
+            const byte* _end;
+            size_t _window;
+            unsigned int _bucket_log;
+            const byte* _hashed{nullptr};       ///< _hash对应的位置
+            uint64_t _hash{0};
+            std::vector<uint64_t> _positions;   ///< 每个桶的位置（位置 + 1，0表示空），最近的在前
+            std::vector<uint32_t> _checks;      ///< 对应位置的哈希校验值
+        };
+
+        /**
+         * @brief 对连续内存区间执行lz77压缩
+         * @param begin 压缩数据开始闭区间
+         * @param end 压缩数据结束开区间
+         * @return First: 压缩后数据 Second: 压缩后数据长度
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> lz77_compress_range(const byte* begin, const byte* end);
+
+        /**
+         * @brief 由各压缩单元的匹配长度计算lz77压缩数据的原始长度
+         * @param begin 压缩数据开始闭区间
+         * @param end 压缩数据结束开区间
+         * @return 原始长度
+         * @throws std::runtime_error 压缩数据不完整时抛出
          */
-        std::tuple<unsigned int, unsigned int,char> compression_tuple(
-            const std::vector<char>& data, const std::vector<char>& pattern, char last);
+        size_t lz77_original_size(const byte* begin, const byte* end);
 
+        /**
+         * @brief 对连续内存中的lz77压缩数据解压
+         * @details 输出缓冲区按原始长度加上少量余量一次分配，解压结果直接写入其中而不再复制；
+         * 偏移不小于8的匹配按8或16字节整块复制，较短的偏移先展开为不小于8字节的周期。
+         * 每个压缩单元都检查偏移与长度，匹配源不能早于数据开头，还原的长度需恰好等于原始长度。
+         * @param begin 压缩数据开始闭区间
+         * @param end 压缩数据结束开区间
+         * @param original_size 原始长度
+         * @return 解压数据与解压数据大小
+         * @throws std::runtime_error 压缩数据不完整、已损坏或与原始长度不符时抛出
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> lz77_decompress_range(const byte* begin, const byte* end,
+                                                                        size_t original_size);
+
+        /**
+         * @brief 对连续内存区间执行序列格式的lz77压缩
+         * @details 输出格式：原始长度(LEB128变长整数) + 若干序列。每个序列为
+         * 标记字节[高4位字面量长度，低4位匹配长度-SEQUENCE_MIN_MATCH] + 字面量长度扩展 + 字面量
+         * + 偏移(LEB128，0表示沿用上一个偏移) + 匹配长度扩展。
+         * 标记中的长度为15时后接扩展字节，逐个累加直到某个字节不为255；最后一个序列只有字面量，
+         * 输出达到原始长度时结束。匹配源可以与当前位置重叠。
+         * 偏移没有上限，启用长距离匹配时可以远超BACK_SIZE。
+         * @param begin 压缩数据开始闭区间
+         * @param end 压缩数据结束开区间
+         * @param parameters 压缩参数
+         * @return First: 压缩后数据 Second: 压缩后数据长度
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> lz77_sequence_compress_range(const byte* begin, const byte* end,
+                                                                              const lz77_parameters& parameters);
+
+        /**
+         * @brief 对连续内存中序列格式的lz77压缩数据解压
+         * @param begin 压缩数据开始闭区间
+         * @param end 压缩数据结束开区间
+         * @return 解压数据与解压数据大小
+         * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
+         */
+        std::pair<std::unique_ptr<byte[]>, size_t> lz77_sequence_decompress_range(const byte* begin, const byte* end);
     }
 
     /**
      * @brief 压缩算法，返回压缩后的数据
-     * @tparam Iter 前向迭代器
+     *
+     * 每个压缩单元为4字节：偏移(2字节，大端) + 匹配长度(1字节) + 下一个字符(1字节)，
+     * 最后一个单元的下一个字符为填充字符，解压时丢弃。
+     * @tparam Iter 前向迭代器，连续迭代器（指针、std::string::iterator等）不会复制输入
      * @param begin 压缩数据开始闭区间
      * @param end 压缩数据结束开区间
      * @return First: 压缩后数据 Second: 压缩后数据长度
@@ -42,97 +278,105 @@ namespace data_packet
         static_assert(std::is_same_v<typename std::iterator_traits<Iter>::value_type,char>,
             "Iterator value_t must be type 'char'.");
 
-        // 分割点
-        Iter separator = begin;
-
-        int front_buffer_size = 0, // 前缓冲区大小
-            back_buffer_size = 0;  // 后缓冲区大小
-
-        Iter pattern_end = separator,  // 后缓冲区结束位置
-            content_begin = separator; // 前缓冲区开始位置
-
-        // 初始化前缓冲区
-        while (pattern_end != end && front_buffer_size < FRONT_SIZE)
+        if constexpr (std::contiguous_iterator<Iter>)
         {
-            ++pattern_end;
-            ++front_buffer_size;
+            const byte* first = std::to_address(begin);
+            return detail::lz77_compress_range(first, first + std::distance(begin, end));
         }
+        else
+        {
+            const std::vector<byte> buffer(begin, end);
+            return detail::lz77_compress_range(buffer.data(), buffer.data() + buffer.size());
+        }
+    }
 
-        std::vector<std::tuple<unsigned int,unsigned int,char>> results;
-
-        bool need_padding = true;
+    /**
+     * @brief 序列格式的压缩算法，字面量按游程存放，匹配长度不受FRONT_SIZE限制，并可沿用上一个偏移
+     * @tparam Iter 前向迭代器，连续迭代器（指针、std::string::iterator等）不会复制输入
+     * @param begin 压缩数据开始闭区间
+     * @param end 压缩数据结束开区间
+     * @param parameters 压缩参数
+     * @return First: 压缩后数据 Second: 压缩后数据长度
+     */
+    template<typename Iter>
+    std::pair<std::unique_ptr<byte[]>, size_t> lz77_sequence_compress(const Iter& begin, const Iter& end,
+                                                                       const lz77_parameters& parameters = {})
+    {
+        static_assert(std::is_same_v<typename std::iterator_traits<Iter>::value_type,char>,
+            "Iterator value_t must be type 'char'.");
 
-        while (separator != end)
+        if constexpr (std::contiguous_iterator<Iter>)
         {
-            // 压缩信息
-            auto info = detail::compression_tuple(
-                {content_begin,separator},{separator,pattern_end} , '\0');
-
-            results.emplace_back(info);
-
-            // 更新分界点，前缓冲区大小与后缓冲区大小
-            for (unsigned int i = 0; i <= std::get<1>(info); ++i)
-            {
-                if (separator == end)
-                {
-                    need_padding = false;
-                    break;
-                }
-                ++separator;
-                --front_buffer_size;
-                ++back_buffer_size;
-            }
-
-            // 更新后缓冲区起点
-            for (;back_buffer_size > BACK_SIZE; --back_buffer_size)
-            {
-                if (content_begin == separator)
-                    break;
-                ++content_begin;
-            }
-
-            // 更新前缓冲区终点
-            for (;front_buffer_size < FRONT_SIZE; ++front_buffer_size)
-            {
-                if (pattern_end == end)
-                    break;
-                ++pattern_end;
-            }
+            const byte* first = std::to_address(begin);
+            return detail::lz77_sequence_compress_range(first, first + std::distance(begin, end), parameters);
         }
-
-        if (need_padding)
+        else
         {
-            results.emplace_back(0,0,'\0');
+            const std::vector<byte> buffer(begin, end);
+            return detail::lz77_sequence_compress_range(buffer.data(), buffer.data() + buffer.size(), parameters);
         }
+    }
 
-        auto ret = std::make_unique<byte[]>(results.size() * 4);
-        byte* write_posi = ret.get();
+    /**
+     * @brief 对序列格式的lz77压缩数据解压
+     * @tparam Iter 前向迭代器，连续迭代器不会复制输入
+     * @param begin 解压初始位置闭区间
+     * @param end 解压结束位置开区间
+     * @return 解压数据与解压数据大小
+     * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
+     */
+    template<typename Iter>
+    std::pair<std::unique_ptr<byte[]>, size_t> lz77_sequence_decompress(const Iter& begin, const Iter& end)
+    {
+        static_assert(std::is_same_v<typename std::iterator_traits<Iter>::value_type,char>,
+            "Iterator value_t must be type 'char'.");
 
-        for (const auto& [posi,match,last] : results)
+        if constexpr (std::contiguous_iterator<Iter>)
         {
-            auto posi_bytes = to_bytes(posi);
-            auto match_bytes = to_bytes(match);
-
-            *write_posi = std::get<2>(posi_bytes);
-            *(write_posi + 1) = std::get<3>(posi_bytes);
-            write_posi += 2;
+            const byte* first = std::to_address(begin);
+            return detail::lz77_sequence_decompress_range(first, first + std::distance(begin, end));
+        }
+        else
+        {
+            const std::vector<byte> buffer(begin, end);
+            return detail::lz77_sequence_decompress_range(buffer.data(), buffer.data() + buffer.size());
+        }
+    }
 
-            *write_posi = std::get<3>(match_bytes);
-            write_posi += 1;
+    /**
+     * @brief 对lz77压缩的数据解压，输出缓冲区按原始长度一次分配，匹配按整块复制
+     * @tparam Iter 前向迭代器，连续迭代器不会复制输入
+     * @param begin 解压初始位置闭区间
+     * @param end 解压结束位置开区间
+     * @param original_size 原始数据长度（如本地文件头记录的原始大小）
+     * @return 解压数据与解压数据大小
+     * @throws std::runtime_error 压缩数据不完整、已损坏或与原始长度不符时抛出
+     */
+    template<typename Iter>
+    std::pair<std::unique_ptr<byte[]>,size_t> lz77_decompress(const Iter& begin, const Iter& end, size_t original_size)
+    {
+        static_assert(std::is_same_v<typename std::iterator_traits<Iter>::value_type,char>,
+            "Iterator value_t must be type 'char'.");
 
-            *write_posi = last;
-            write_posi += 1;
+        if constexpr (std::contiguous_iterator<Iter>)
+        {
+            const byte* first = std::to_address(begin);
+            return detail::lz77_decompress_range(first, first + std::distance(begin, end), original_size);
+        }
+        else
+        {
+            const std::vector<byte> buffer(begin, end);
+            return detail::lz77_decompress_range(buffer.data(), buffer.data() + buffer.size(), original_size);
         }
-
-        return std::make_pair(std::move(ret), results.size() * 4);
     }
 
     /**
-     * @brief 对lz77压缩的数据解压
-     * @tparam Iter 输入迭代器
+     * @brief 对lz77压缩的数据解压，原始长度由各压缩单元的匹配长度累加得到
+     * @tparam Iter 前向迭代器，连续迭代器不会复制输入
      * @param begin 解压初始位置闭区间
      * @param end 解压结束位置开区间
      * @return 解压数据与解压数据大小
+     * @throws std::runtime_error 压缩数据不完整或已损坏时抛出
      */
     template<typename Iter>
     std::pair<std::unique_ptr<byte[]>,size_t> lz77_decompress(const Iter& begin, const Iter& end)
@@ -140,33 +384,18 @@ namespace data_packet
         static_assert(std::is_same_v<typename std::iterator_traits<Iter>::value_type,char>,
             "Iterator value_t must be type 'char'.");
 
-        auto it = begin;
-
-        std::vector<byte> sequence;
-
-        while (it != end)
+        if constexpr (std::contiguous_iterator<Iter>)
         {
-            byte bytes[4];
-            for (unsigned short i = 0;i<4&& it!= end;++i)
-            {
-                bytes[i] = *it;
-                ++it;
-            }
-
-            unsigned short back_posi = make_word({bytes[0],bytes[1]});
-            unsigned char front_posi = bytes[2];
-            char last = bytes[3];
-
-            sequence.insert(sequence.end(), sequence.end() - back_posi, sequence.end() - back_posi + front_posi);
-            sequence.emplace_back(last);
+            const byte* first = std::to_address(begin);
+            const byte* last = first + std::distance(begin, end);
+            return detail::lz77_decompress_range(first, last, detail::lz77_original_size(first, last));
+        }
+        else
+        {
+            const std::vector<byte> buffer(begin, end);
+            const byte* last = buffer.data() + buffer.size();
+            return detail::lz77_decompress_range(buffer.data(), last, detail::lz77_original_size(buffer.data(), last));
         }
-
-        sequence.pop_back();
-
-        auto ret = std::make_unique<byte[]>(sequence.size());
-        memcpy(ret.get(), sequence.data(), sequence.size());
-
-        return std::make_pair(std::move(ret), sequence.size());
     }
 
 }
@@ -0,0 +1,157 @@
+//
+// Created by hyh on 2026/1/25.
+//
+
+#ifndef DATA_BACK_UP_CHUNK_STORE_H
+#define DATA_BACK_UP_CHUNK_STORE_H
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../header/local_file_header.h"
+
+namespace data_packet
+{
+    using chunk_id = std::array<uint8_t, 32>;   ///< 块标识：块原始数据的SHA-256
+
+    /**
+     * @struct chunk_reference
+     * @brief 块引用：块标识与块的原始大小
+     *
+     * 去重存储的文件数据是块引用列表，每项序列化为 块标识(32字节) + 原始大小(4字节，大端)，
+     * 各块的原始数据按顺序拼接即为原始文件
+     */
+    struct chunk_reference
+    {
+        static constexpr size_t SIZE = 32 + 4;   ///< 序列化后的大小
+
+        chunk_id id{};        ///< 块标识
+        dword size{0};        ///< 块的原始大小
+
+        /**
+         * @brief 序列化块引用列表
+         * @param references 块引用列表
+         * @return 序列化后的数据
+         */
+        static std::vector<byte> serialize(const std::vector<chunk_reference>& references);
+
+        /**
+         * @brief 反序列化块引用列表，并检查各块原始大小之和与原始文件大小一致
+         * @param in 序列化后的数据
+         * @param size 数据大小
+         * @param original_size 原始文件大小
+         * @return 块引用列表
+         * @throws std::runtime_error 数据不完整或与原始文件大小不符时抛出
+         */
+        static std::vector<chunk_reference> parse(const byte* in, size_t size, qword original_size);
+    };
+
+    /**
+     * @struct stored_chunk
+     * @brief 从块存储中读出的一个块：压缩、加密后的数据及其处理方法
+     */
+    struct stored_chunk
+    {
+        local_file_header::compression_method compression{local_file_header::compression_method::None};
+        local_file_header::encryption_method encryption{local_file_header::encryption_method::None};
+        dword original_size{0};              ///< 块的原始大小
+        std::unique_ptr<byte[]> data;        ///< 压缩、加密后的数据
+        size_t size{0};                      ///< 压缩、加密后的大小
+    };
+
+    /**
+     * @class chunk_store
+     * @brief 本地目录中的内容寻址块存储，每个不同的块只保存一次
+     *
+     * 块以 <根目录>/<标识前两位十六进制>/<标识的十六进制> 的文件保存，文件格式：
+     * "PKCH"(4字节) + 压缩方法(1字节) + 加密方法(1字节) + 原始大小(4字节) + CRC32(4字节) + 压缩、加密后的数据，均为大端。
+     * 每个块各自独立压缩、加密，处理方法记录在块文件中，因此同一存储可以被不同压缩方法的备份共享。
+     * 块先写入临时文件再重命名，多个线程或进程同时写入同一个块也不会留下不完整的块文件。
+     * 加密的块使用由密码与根目录中的密钥派生参数（文件 <根目录>/kdf）派生的密钥，同一存储的所有备份共用一份参数。
+     */
+    class chunk_store
+    {
+    public:
+        /**
+         * @brief 打开块存储，目录不存在时创建
+         * @param root 块存储的根目录
+         * @throws std::filesystem::filesystem_error 无法创建目录时抛出
+         */
+        explicit chunk_store(std::filesystem::path root);
+
+        /**
+         * @brief 计算块标识：不加密时为 SHA-256(数据)，加密时为 HMAC-SHA256(密钥, 数据)
+         *
+         * 加密的块以由块存储的密钥派生的密钥计算标识，不同密码的备份不会共享块（否则无法解密），
+         * 也避免仅凭块存储中的文件名判断其是否包含某段已知数据
+         * @param data 块的原始数据
+         * @param size 块的原始大小
+         * @param key 密钥，不加密时为空
+         * @return 块标识
+         */
+        static chunk_id make_id(const byte* data, size_t size, std::string_view key = {});
+
+        /**
+         * @brief 判断块存储中是否已有指定的块
+         * @param id 块标识
+         * @return true 已有
+         */
+        [[nodiscard]] bool contains(const chunk_id& id) const;
+
+        /**
+         * @brief 写入一个块，已存在时不做任何事
+         * @param id 块标识
+         * @param compression 压缩方法
+         * @param encryption 加密方法
+         * @param original_size 块的原始大小
+         * @param data 压缩、加密后的数据
+         * @param size 压缩、加密后的大小
+         * @throws std::runtime_error 写入失败时抛出
+         */
+        void put(const chunk_id& id, local_file_header::compression_method compression,
+                 local_file_header::encryption_method encryption, dword original_size,
+                 const byte* data, size_t size) const;
+
+        /**
+         * @brief 读取一个块并校验CRC32
+         * @param id 块标识
+         * @return 块的数据与处理方法
+         * @throws std::runtime_error 块不存在、不完整或已损坏时抛出
+         */
+        [[nodiscard]] stored_chunk get(const chunk_id& id) const;
+
+        /**
+         * @brief 读取根目录中保存的密钥派生参数
+         * @return 序列化的密钥派生参数，没有保存时为空
+         * @throws std::runtime_error 读取失败时抛出
+         */
+        [[nodiscard]] std::optional<std::string> load_key_derivation() const;
+
+        /**
+         * @brief 在根目录中保存密钥派生参数，已有参数时不覆盖
+         *
+         * 参数先写入临时文件再以硬链接发布，多个进程同时保存时只有最先发布的一份生效
+         * @param parameters 序列化的密钥派生参数
+         * @return 块存储实际使用的参数：已有参数时为已有的参数
+         * @throws std::runtime_error 写入失败时抛出
+         */
+        std::string save_key_derivation(std::string_view parameters) const;
+
+        /**
+         * @brief 获取块文件的路径
+         * @param id 块标识
+         * @return 块文件的路径
+         */
+        [[nodiscard]] std::filesystem::path path_of(const chunk_id& id) const;
+
+    private:
+        std::filesystem::path _root;
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_CHUNK_STORE_H
@@ -0,0 +1,62 @@
+//
+// Created by hyh on 2026/1/25.
+//
+
+#ifndef DATA_BACK_UP_CONTENT_CHUNKER_H
+#define DATA_BACK_UP_CONTENT_CHUNKER_H
+
+#include <cstddef>
+
+#include "../utils/byte_conversion.h"
+
+namespace data_packet
+{
+    constexpr size_t CDC_MIN_SIZE = 16 * 1024;       ///< 内容定义分块的默认最小块大小
+    constexpr size_t CDC_AVERAGE_SIZE = 64 * 1024;   ///< 内容定义分块的默认平均块大小
+    constexpr size_t CDC_MAX_SIZE = 256 * 1024;      ///< 内容定义分块的默认最大块大小
+
+    /**
+     * @class content_chunker
+     * @brief 基于Gear滚动哈希的内容定义分块（FastCDC）
+     *
+     * 块边界只取决于边界附近的数据，文件中插入或删除数据后，其余位置的块边界保持不变，
+     * 因此相似的文件能切分出大量相同的块。采用归一化分块：平均大小之前使用更严格的掩码，
+     * 之后使用更宽松的掩码，使块大小集中在平均大小附近。
+     */
+    class content_chunker
+    {
+    public:
+        /**
+         * @brief 构造分块器
+         * @param min_size 最小块大小
+         * @param average_size 平均块大小，需为2的幂
+         * @param max_size 最大块大小
+         * @throws std::invalid_argument 参数不满足 64 <= min_size < average_size < max_size 或平均大小不是2的幂时抛出
+         */
+        explicit content_chunker(size_t min_size = CDC_MIN_SIZE, size_t average_size = CDC_AVERAGE_SIZE,
+                                 size_t max_size = CDC_MAX_SIZE);
+
+        /**
+         * @brief 计算从data开始的下一块的长度
+         * @param data 数据
+         * @param size 数据大小；除最后一段数据外，调用方需至少提供max_size()字节，否则块边界会受到数据分段的影响
+         * @return 块长度，不超过min(size, max_size())，size不超过最小块大小时为size
+         */
+        [[nodiscard]] size_t cut(const byte* data, size_t size) const;
+
+        /**
+         * @brief 获取最大块大小
+         * @return 最大块大小
+         */
+        [[nodiscard]] size_t max_size() const { return _max_size; }
+
+    private:
+        size_t _min_size;
+        size_t _average_size;
+        size_t _max_size;
+        uint64_t _mask_small;   ///< 平均大小之前使用的掩码，置位更多
+        uint64_t _mask_large;   ///< 平均大小之后使用的掩码，置位更少
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_CONTENT_CHUNKER_H
@@ -5,9 +5,14 @@
 #include <string>
 #include <cstring>
 #include "../utils/byte_conversion.h"
+#include "../utils/parallel.h"
 #include <memory>
 #include <utility>
 #include <iterator>
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include <openssl/evp.h>
 #include <openssl/sha.h>
@@ -47,6 +52,87 @@ bool generate_aes_key(const std::string& password, unsigned char* key);
 // 生成随机IV（16字节）
 bool generate_iv(unsigned char* iv) ;
 
+/// AES-256密钥
+using aes_key = std::array<unsigned char, AES_KEY_SIZE_256>;
+
+/**
+ * @brief 由密码直接生成密钥（SHA-256），用于没有记录密钥派生参数的旧版本包
+ * @param password 密码
+ * @return 密钥
+ */
+aes_key password_key(const std::string& password);
+
+constexpr size_t KDF_SALT_SIZE = 16;                        ///< 密钥派生与每个文件的子密钥所用盐的大小
+constexpr uint32_t MIN_KDF_ITERATIONS = 1000;                ///< PBKDF2迭代次数的下限
+constexpr uint32_t DEFAULT_KDF_ITERATIONS = 200000;          ///< PBKDF2默认的迭代次数
+constexpr uint32_t MAX_KDF_ITERATIONS = 100000000;           ///< PBKDF2迭代次数的上限
+
+/**
+ * @struct kdf_parameters
+ * @brief 一个备份包的密钥派生参数
+ *
+ * 序列化格式：算法(1字节，1为PBKDF2-HMAC-SHA256) + 迭代次数(4字节，大端) + 盐(16字节)
+ */
+struct kdf_parameters
+{
+    static constexpr uint8_t PBKDF2_SHA256 = 1;                 ///< PBKDF2-HMAC-SHA256
+    static constexpr size_t SIZE = 1 + 4 + KDF_SALT_SIZE;      ///< 序列化后的大小
+
+    uint32_t iterations{DEFAULT_KDF_ITERATIONS};     ///< 迭代次数
+    std::array<unsigned char, KDF_SALT_SIZE> salt{};  ///< 随机盐
+
+    /**
+     * @brief 生成使用随机盐的参数
+     * @param iterations 迭代次数，MIN_KDF_ITERATIONS到MAX_KDF_ITERATIONS
+     * @return 参数
+     * @throws std::invalid_argument 迭代次数超出范围时抛出
+     * @throws std::runtime_error 生成随机盐失败时抛出
+     */
+    static kdf_parameters generate(uint32_t iterations = DEFAULT_KDF_ITERATIONS);
+
+    /**
+     * @brief 序列化参数
+     * @return 序列化后的参数
+     */
+    [[nodiscard]] std::string serialize() const;
+
+    /**
+     * @brief 反序列化参数
+     * @param data 序列化后的参数
+     * @return 参数
+     * @throws std::runtime_error 格式不正确、算法未知或迭代次数超出范围时抛出
+     */
+    static kdf_parameters parse(std::string_view data);
+};
+
+/**
+ * @brief 使用PBKDF2-HMAC-SHA256由密码派生备份包的密钥，每个备份、还原只需执行一次
+ * @param password 密码
+ * @param parameters 密钥派生参数
+ * @return 备份包的密钥
+ * @throws std::runtime_error 派生失败时抛出
+ */
+aes_key derive_key(const std::string& password, const kdf_parameters& parameters);
+
+/**
+ * @brief 由备份包的密钥与文件的盐计算该文件的子密钥：HMAC-SHA256(密钥, "entry" + 盐)
+ * @details 密码校验值与各用途的子密钥使用不同的标签，保存在包中的校验值不会泄露任何子密钥
+ * @param key 备份包的密钥
+ * @param salt 文件的随机盐
+ * @return 子密钥
+ * @throws std::runtime_error 计算HMAC失败时抛出
+ */
+aes_key derive_subkey(const aes_key& key, std::span<const unsigned char, KDF_SALT_SIZE> salt);
+
+/**
+ * @brief 由密钥与用途标签计算子密钥：HMAC-SHA256(密钥, 标签)
+ * @param key 密钥
+ * @param label 用途标签，不能与文件子密钥、密码校验值的标签（"entry"、"check"）相同
+ * @return 子密钥
+ * @throws std::runtime_error 计算HMAC失败时抛出
+ */
+aes_key derive_subkey(const aes_key& key, std::string_view label);
+
 /**
  * AES-256-CBC加密（使用OpenSSL 3.x EVP高级接口）
  * @param plaintext 明文（字符流）
@@ -64,57 +150,522 @@ bool aes_encrypt(const std::string& plaintext, const std::string& password, std:
  * @return 成功返回true，失败返回false
  */
 bool aes_decrypt(const std::string& ciphertext, const std::string& password, std::string& plaintext);
+
+constexpr size_t CIPHER_CHUNK_SIZE = 64 * 1024;   ///< 流式加密、解密每次交给OpenSSL的数据量
+
+/**
+ * @brief 计算AES-256-CBC加密后的大小
+ * @details 密文格式：IV(16字节) + 密文。明文先按PKCS7补齐到16字节的整数倍，
+ * 再追加一个全为16的填充块（即OpenSSL的EVP填充），共两层填充，与旧版本的包兼容。
+ * @param plaintext_size 明文大小
+ * @return IV与密文的总大小
+ */
+constexpr size_t encrypted_size(size_t plaintext_size)
+{
+    return AES_BLOCK_SIZE + (plaintext_size / AES_BLOCK_SIZE + 2) * AES_BLOCK_SIZE;
+}
+
+/**
+ * @class cipher_context
+ * @brief 借用当前线程的EVP_CIPHER_CTX
+ *
+ * 每个线程缓存一个上下文，依次进行的加密、解密复用它而不必每次分配；
+ * 同一线程中同时存在多个借用者时，后来者各自分配新的上下文。
+ */
+class cipher_context
+{
+public:
+    /**
+     * @brief 借用当前线程的上下文，已被借用时分配新的上下文
+     * @throws std::runtime_error 无法分配上下文时抛出
+     */
+    cipher_context();
+
+    ~cipher_context();
+
+    cipher_context(const cipher_context& other) = delete;
+
+    cipher_context& operator=(const cipher_context& other) = delete;
+
+    /**
+     * @brief 获取上下文
+     * @return EVP上下文
+     */
+    [[nodiscard]] EVP_CIPHER_CTX* get() const { return _context; }
+
+private:
+    EVP_CIPHER_CTX* _context{nullptr};
+    bool _borrowed{false};   ///< 是否借用的线程缓存的上下文
+};
+
+/**
+ * @class cbc_encryptor
+ * @brief 流式AES-256-CBC加密
+ *
+ * 明文可以分多次交给update，密文直接写入调用方提供的缓冲区，除一个不完整的块外不缓存数据；
+ * finish输出最后一个块与填充块。IV由构造函数随机生成，调用方负责将其写在密文之前。
+ */
+class cbc_encryptor
+{
+public:
+    /**
+     * @brief 使用指定的密钥并随机生成IV
+     * @param key 密钥
+     * @throws std::runtime_error 生成IV或初始化加密失败时抛出
+     */
+    explicit cbc_encryptor(const aes_key& key);
+
+    /**
+     * @brief 由密码生成密钥（见password_key）并随机生成IV
+     * @param password 密码
+     * @throws std::runtime_error 生成IV或初始化加密失败时抛出
+     */
+    explicit cbc_encryptor(const std::string& password) : cbc_encryptor(password_key(password)) {}
+
+    /**
+     * @brief 获取IV
+     * @return 16字节的IV
+     */
+    [[nodiscard]] std::span<const unsigned char, AES_BLOCK_SIZE> iv() const { return _iv; }
+
+    /**
+     * @brief 加密一段明文
+     * @param in 明文
+     * @param out 输出位置，需至少in.size() + 15字节
+     * @return 写入的字节数
+     * @throws std::runtime_error 加密失败时抛出
+     */
+    size_t update(std::span<const data_packet::byte> in, data_packet::byte* out);
+
+    /**
+     * @brief 结束加密，输出剩余的数据与两层填充
+     * @param out 输出位置，需至少32字节
+     * @return 写入的字节数，总为32
+     * @throws std::runtime_error 加密失败时抛出
+     */
+    size_t finish(data_packet::byte* out);
+
+private:
+    cipher_context _context;
+    unsigned char _iv[AES_BLOCK_SIZE]{};
+    size_t _size{0};   ///< 已加密的明文大小
+};
+
+/**
+ * @class cbc_decryptor
+ * @brief 流式AES-256-CBC解密
+ *
+ * 密文可以分多次交给update，明文直接写入调用方提供的缓冲区。
+ * 最后32字节的密文含有填充，始终保留到finish时才解密并校验。
+ */
+class cbc_decryptor
+{
+public:
+    /**
+     * @brief 由密钥与IV初始化解密
+     * @param key 密钥
+     * @param iv 密文开头的16字节IV
+     * @throws std::runtime_error 初始化解密失败时抛出
+     */
+    cbc_decryptor(const aes_key& key, std::span<const data_packet::byte, AES_BLOCK_SIZE> iv);
+
+    /**
+     * @brief 由密码（见password_key）与IV初始化解密
+     * @param password 密码
+     * @param iv 密文开头的16字节IV
+     * @throws std::runtime_error 初始化解密失败时抛出
+     */
+    cbc_decryptor(const std::string& password, std::span<const data_packet::byte, AES_BLOCK_SIZE> iv)
+        : cbc_decryptor(password_key(password), iv) {}
+
+    /**
+     * @brief 解密一段密文（不含IV）
+     * @param in 密文
+     * @param out 输出位置，需至少in.size() + 15字节
+     * @return 写入的字节数
+     * @throws std::runtime_error 解密失败时抛出
+     */
+    size_t update(std::span<const data_packet::byte> in, data_packet::byte* out);
+
+    /**
+     * @brief 结束解密，校验并去除两层填充后输出剩余的明文
+     * @param out 输出位置，需至少15字节
+     * @return 写入的字节数
+     * @throws std::runtime_error 密文长度不正确或填充不合法（密码错误、数据损坏）时抛出
+     */
+    size_t finish(data_packet::byte* out);
+
+private:
+    static constexpr size_t TAIL_SIZE = 2 * AES_BLOCK_SIZE;   ///< 含有填充的末尾密文大小
+
+    cipher_context _context;
+    data_packet::byte _tail[TAIL_SIZE]{};   ///< 保留的末尾密文
+    size_t _tail_size{0};
+};
+
+/**
+ * @brief 加密连续内存中的明文，直接写入调用方提供的缓冲区
+ * @param plaintext 明文
+ * @param key 密钥
+ * @param out 输出位置，需至少encrypted_size(plaintext.size())字节
+ * @return 写入的字节数
+ * @throws std::runtime_error 加密失败时抛出
+ */
+size_t encrypt_to(std::span<const data_packet::byte> plaintext, const aes_key& key, data_packet::byte* out);
+
+/**
+ * @brief 使用由密码生成的密钥（见password_key）加密，其余同encrypt_to(std::span, const aes_key&, byte*)
+ */
+inline size_t encrypt_to(std::span<const data_packet::byte> plaintext, const std::string& password,
+                         data_packet::byte* out)
+{
+    return encrypt_to(plaintext, password_key(password), out);
+}
+
+/**
+ * @brief 解密连续内存中的IV与密文，直接写入调用方提供的缓冲区
+ * @param ciphertext IV与密文
+ * @param key 密钥
+ * @param out 输出位置，需至少ciphertext.size() - 16字节
+ * @return 明文大小
+ * @throws std::runtime_error 密文不完整、密码错误或数据损坏时抛出
+ */
+size_t decrypt_to(std::span<const data_packet::byte> ciphertext, const aes_key& key, data_packet::byte* out);
+
+/**
+ * @brief 使用由密码生成的密钥（见password_key）解密，其余同decrypt_to(std::span, const aes_key&, byte*)
+ */
+inline size_t decrypt_to(std::span<const data_packet::byte> ciphertext, const std::string& password,
+                         data_packet::byte* out)
+{
+    return decrypt_to(ciphertext, password_key(password), out);
+}
+
+constexpr size_t GCM_CHUNK_SIZE = 1024 * 1024;        ///< AES-256-GCM默认的块大小
+constexpr size_t GCM_MAX_CHUNK_SIZE = 1ull << 30;     ///< AES-256-GCM允许的最大块大小
+constexpr size_t GCM_NONCE_SIZE = 12;                 ///< 每块的随机nonce大小
+constexpr size_t GCM_TAG_SIZE = 16;                   ///< 每块的认证标签大小
+constexpr size_t GCM_HEADER_SIZE = 4;                 ///< 开头记录块大小的字节数
+
+/**
+ * @brief 计算AES-256-GCM分块加密后的大小
+ * @details 格式：块大小(4字节，大端) + 每块[nonce(12字节) + 密文 + 标签(16字节)]。
+ * 明文按块大小切分，最后一块可以较短，空明文也有一个空块。每块使用独立的随机nonce，
+ * 附加认证数据为块序号(8字节，大端)与是否最后一块(1字节)，块被调换、删除或截断时认证失败。
+ * @param plaintext_size 明文大小
+ * @param chunk_size 块大小
+ * @return 加密后的总大小
+ */
+constexpr size_t gcm_encrypted_size(size_t plaintext_size, size_t chunk_size = GCM_CHUNK_SIZE)
+{
+    const size_t chunk_count = plaintext_size == 0 ? 1 : (plaintext_size + chunk_size - 1) / chunk_size;
+    return GCM_HEADER_SIZE + plaintext_size + chunk_count * (GCM_NONCE_SIZE + GCM_TAG_SIZE);
+}
+
+/**
+ * @brief 由AES-256-GCM分块加密的数据计算明文大小
+ * @param ciphertext 加密后的数据
+ * @return 明文大小
+ * @throws std::runtime_error 数据不完整或块大小不合法时抛出
+ */
+size_t gcm_plaintext_size(std::span<const data_packet::byte> ciphertext);
+
+/**
+ * @brief 使用AES-256-GCM分块加密，各块在多个线程上并行加密，直接写入调用方提供的缓冲区
+ * @param plaintext 明文
+ * @param key 密钥
+ * @param out 输出位置，需至少gcm_encrypted_size(plaintext.size(), chunk_size)字节
+ * @param thread_number 线程数，0表示使用全部硬件线程
+ * @param chunk_size 块大小，1到GCM_MAX_CHUNK_SIZE
+ * @return 写入的字节数
+ * @throws std::runtime_error 加密失败时抛出
+ * @throws std::invalid_argument 块大小不合法时抛出
+ */
+size_t gcm_encrypt_to(std::span<const data_packet::byte> plaintext, const aes_key& key,
+                      data_packet::byte* out, unsigned int thread_number = 1, size_t chunk_size = GCM_CHUNK_SIZE);
+
+/**
+ * @brief 使用由密码生成的密钥（见password_key）分块加密，其余同gcm_encrypt_to(std::span, const aes_key&, ...)
+ */
+inline size_t gcm_encrypt_to(std::span<const data_packet::byte> plaintext, const std::string& password,
+                             data_packet::byte* out, unsigned int thread_number = 1,
+                             size_t chunk_size = GCM_CHUNK_SIZE)
+{
+    return gcm_encrypt_to(plaintext, password_key(password), out, thread_number, chunk_size);
+}
+
+/**
+ * @brief 解密AES-256-GCM分块加密的数据，各块在多个线程上并行解密与认证，直接写入调用方提供的缓冲区
+ * @param ciphertext 加密后的数据
+ * @param key 密钥
+ * @param out 输出位置，需至少gcm_plaintext_size(ciphertext)字节
+ * @param thread_number 线程数，0表示使用全部硬件线程
+ * @return 明文大小
+ * @throws std::runtime_error 数据不完整、密码错误或数据被篡改时抛出
+ */
+size_t gcm_decrypt_to(std::span<const data_packet::byte> ciphertext, const aes_key& key,
+                      data_packet::byte* out, unsigned int thread_number = 1);
+
+/**
+ * @brief 使用由密码生成的密钥（见password_key）分块解密，其余同gcm_decrypt_to(std::span, const aes_key&, ...)
+ */
+inline size_t gcm_decrypt_to(std::span<const data_packet::byte> ciphertext, const std::string& password,
+                             data_packet::byte* out, unsigned int thread_number = 1)
+{
+    return gcm_decrypt_to(ciphertext, password_key(password), out, thread_number);
+}
+
+constexpr size_t KEY_CHECK_SALT_SIZE = 16;                    ///< 密码校验值中随机盐的大小
+constexpr size_t KEY_CHECK_SIZE = KEY_CHECK_SALT_SIZE + 16;   ///< 密码校验值的大小
+
+/**
+ * @brief 生成密码校验值，保存在包中用于在解密任何数据之前判断密码是否正确
+ * @details 格式：随机盐(16字节) + HMAC-SHA256(密钥, "check" + 盐)的前16字节，密钥为备份包的密钥。
+ * 校验值不能用于还原密钥，随机盐使相同密码的包的校验值互不相同。
+ * @param key 备份包的密钥
+ * @return 密码校验值
+ * @throws std::runtime_error 生成随机盐或计算HMAC失败时抛出
+ */
+std::string make_key_check(const aes_key& key);
+
+/**
+ * @brief 使用由密码生成的密钥（见password_key）生成密码校验值
+ */
+inline std::string make_key_check(const std::string& password)
+{
+    return make_key_check(password_key(password));
+}
+
+/**
+ * @brief 用密码校验值判断密钥是否正确
+ * @param key_check 包中保存的密码校验值
+ * @param key 由密码派生的备份包密钥
+ * @return true 密钥正确
+ * @throws std::runtime_error 校验值格式不正确时抛出
+ */
+bool verify_key_check(std::string_view key_check, const aes_key& key);
+
+/**
+ * @brief 用密码校验值判断由密码生成的密钥（见password_key）是否正确
+ */
+inline bool verify_key_check(std::string_view key_check, const std::string& password)
+{
+    return verify_key_check(key_check, password_key(password));
+}
 }
 
 namespace data_packet
 {
+    /**
+     * @brief 使用AES-256-CBC加密
+     * @tparam Iter 前向迭代器，连续迭代器不会复制输入
+     * @param begin 明文开始位置
+     * @param buffer_size 明文大小
+     * @param password 密码
+     * @return IV与密文及其大小，失败时为空指针
+     */
     template<typename Iter>
     std::pair<std::unique_ptr<byte[]>,size_t> encrypt(const Iter& begin,size_t buffer_size,const std::string& password={})
     {
         static_assert(sizeof(typename std::iterator_traits<Iter>::value_type) == sizeof(uint8_t), "Element type must be 1 byte");
 
-        std::string plaintext(begin,std::next(begin,buffer_size));
-        std::string ciphertext;
-        if(!encryption::aes_encrypt(plaintext,password,ciphertext))
+        const size_t size = encryption::encrypted_size(buffer_size);
+        auto encrypted_data = std::make_unique_for_overwrite<byte[]>(size);
+        try
         {
-            std::cerr<<"fail to encrypt"<<std::endl;
-            return std::pair<std::unique_ptr<byte[]>,size_t>(nullptr,0);
+            if constexpr (std::contiguous_iterator<Iter>)
+            {
+                const auto* first = reinterpret_cast<const byte*>(std::to_address(begin));
+                encryption::encrypt_to({first, buffer_size}, password, encrypted_data.get());
+            }
+            else
+            {
+                const std::vector<byte> plaintext(begin, std::next(begin, buffer_size));
+                encryption::encrypt_to(plaintext, password, encrypted_data.get());
+            }
         }
-        std::unique_ptr<byte[]> encrypted_data=std::make_unique<byte[]>(ciphertext.size());
-        const byte* ciphertext_tmp=ciphertext.data();
-        std::memcpy(encrypted_data.get(),ciphertext_tmp,ciphertext.size());
-        return std::pair<std::unique_ptr<byte[]>,size_t>(std::move(encrypted_data),ciphertext.size());
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to encrypt: "<<e.what()<<std::endl;
+            return {nullptr, 0};
+        }
+        return {std::move(encrypted_data), size};
     }
-    
+
     template<typename Iter>
     std::pair<std::unique_ptr<byte[]>,size_t> encrypt(const Iter& begin,const Iter& end,const std::string& password={})
     {
         return encrypt(begin,size_t(end-begin),password);
     }
 
-
+    /**
+     * @brief 解密AES-256-CBC加密的数据
+     * @tparam Iter 前向迭代器，连续迭代器不会复制输入
+     * @param begin IV与密文开始位置
+     * @param buffer_size IV与密文大小
+     * @param password 密码
+     * @return 明文及其大小，密码错误或数据损坏时为空指针
+     */
     template<typename Iter>
     std::pair<std::unique_ptr<byte[]>,size_t> decrypt(const Iter& begin,size_t buffer_size,const std::string& password={})
     {
         static_assert(sizeof(typename std::iterator_traits<Iter>::value_type) == sizeof(uint8_t), "Element type must be 1 byte");
-        std::string ciphertext(begin,std::next(begin,buffer_size));
-        std::string plaintext;
-        if(!encryption::aes_decrypt(ciphertext,password,plaintext))
+        if (buffer_size < encryption::encrypted_size(0))
+        {
+            std::cerr<<"fail to decrypt: ciphertext is incomplete"<<std::endl;
+            return {nullptr, 0};
+        }
+
+        auto decrypted_data = std::make_unique_for_overwrite<byte[]>(buffer_size - AES_BLOCK_SIZE);
+        size_t size = 0;
+        try
         {
-            std::cerr<<"fail to decrypt"<<std::endl;
+            if constexpr (std::contiguous_iterator<Iter>)
+            {
+                const auto* first = reinterpret_cast<const byte*>(std::to_address(begin));
+                size = encryption::decrypt_to({first, buffer_size}, password, decrypted_data.get());
+            }
+            else
+            {
+                const std::vector<byte> ciphertext(begin, std::next(begin, buffer_size));
+                size = encryption::decrypt_to(ciphertext, password, decrypted_data.get());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to decrypt: "<<e.what()<<std::endl;
             return {nullptr, 0};
         }
-        std::unique_ptr<byte[]> decrypted_data=std::make_unique<byte[]>(plaintext.size());
-        const byte* plaintext_tmp=plaintext.data();
-        std::memcpy(decrypted_data.get(),plaintext_tmp,plaintext.size());
-        return std::pair<std::unique_ptr<byte[]>,size_t>(std::move(decrypted_data),plaintext.size());
+        return {std::move(decrypted_data), size};
     }
-    
+
     template<typename Iter>
     std::pair<std::unique_ptr<byte[]>,size_t> decrypt(const Iter& begin,const Iter& end,const std::string& password={})
     {
         return decrypt(begin,size_t(end-begin),password);
     }
+
+    /**
+     * @brief 使用指定的密钥以AES-256-CBC加密连续内存中的数据
+     * @param data 明文
+     * @param size 明文大小
+     * @param key 密钥
+     * @return IV与密文及其大小，失败时为空指针
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> encrypt(const byte* data,size_t size,const encryption::aes_key& key)
+    {
+        const size_t encrypted_size = encryption::encrypted_size(size);
+        auto encrypted_data = std::make_unique_for_overwrite<byte[]>(encrypted_size);
+        try
+        {
+            encryption::encrypt_to({data, size}, key, encrypted_data.get());
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to encrypt: "<<e.what()<<std::endl;
+            return {nullptr, 0};
+        }
+        return {std::move(encrypted_data), encrypted_size};
+    }
+
+    /**
+     * @brief 使用指定的密钥解密AES-256-CBC加密的连续内存中的数据
+     * @param data IV与密文
+     * @param size IV与密文大小
+     * @param key 密钥
+     * @return 明文及其大小，密钥错误或数据损坏时为空指针
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> decrypt(const byte* data,size_t size,const encryption::aes_key& key)
+    {
+        if (size < encryption::encrypted_size(0))
+        {
+            std::cerr<<"fail to decrypt: ciphertext is incomplete"<<std::endl;
+            return {nullptr, 0};
+        }
+        auto decrypted_data = std::make_unique_for_overwrite<byte[]>(size - AES_BLOCK_SIZE);
+        try
+        {
+            const size_t decrypted_size = encryption::decrypt_to({data, size}, key, decrypted_data.get());
+            return {std::move(decrypted_data), decrypted_size};
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to decrypt: "<<e.what()<<std::endl;
+            return {nullptr, 0};
+        }
+    }
+
+    /**
+     * @brief 使用AES-256-GCM分块并行加密连续内存中的数据
+     * @param data 明文
+     * @param size 明文大小
+     * @param key 密钥
+     * @param thread_number 线程数，0表示使用全部硬件线程
+     * @return 加密后的数据及其大小，失败时为空指针
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> gcm_encrypt(const byte* data,size_t size,
+                                                                 const encryption::aes_key& key,
+                                                                 unsigned int thread_number=1)
+    {
+        const size_t encrypted_size = encryption::gcm_encrypted_size(size);
+        auto encrypted_data = std::make_unique_for_overwrite<byte[]>(encrypted_size);
+        try
+        {
+            encryption::gcm_encrypt_to({data, size}, key, encrypted_data.get(), thread_number);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to encrypt: "<<e.what()<<std::endl;
+            return {nullptr, 0};
+        }
+        return {std::move(encrypted_data), encrypted_size};
+    }
+
+    /**
+     * @brief 分块并行解密AES-256-GCM加密的数据
+     * @param data 加密后的数据
+     * @param size 加密后的数据大小
+     * @param key 密钥
+     * @param thread_number 线程数，0表示使用全部硬件线程
+     * @return 明文及其大小，数据不完整、密码错误或数据被篡改时为空指针
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> gcm_decrypt(const byte* data,size_t size,
+                                                                 const encryption::aes_key& key,
+                                                                 unsigned int thread_number=1)
+    {
+        try
+        {
+            const size_t plaintext_size = encryption::gcm_plaintext_size({data, size});
+            auto decrypted_data = std::make_unique_for_overwrite<byte[]>(plaintext_size);
+            encryption::gcm_decrypt_to({data, size}, key, decrypted_data.get(), thread_number);
+            return {std::move(decrypted_data), plaintext_size};
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr<<"fail to decrypt: "<<e.what()<<std::endl;
+            return {nullptr, 0};
+        }
+    }
+
+    /**
+     * @brief 使用由密码生成的密钥（见encryption::password_key）分块并行加密
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> gcm_encrypt(const byte* data,size_t size,
+                                                                 const std::string& password={},
+                                                                 unsigned int thread_number=1)
+    {
+        return gcm_encrypt(data, size, encryption::password_key(password), thread_number);
+    }
+
+    /**
+     * @brief 使用由密码生成的密钥（见encryption::password_key）分块并行解密
+     */
+    inline std::pair<std::unique_ptr<byte[]>,size_t> gcm_decrypt(const byte* data,size_t size,
+                                                                 const std::string& password={},
+                                                                 unsigned int thread_number=1)
+    {
+        return gcm_decrypt(data, size, encryption::password_key(password), thread_number);
+    }
 }
 
 #endif
@@ -6,8 +6,8 @@
 #define DATA_BACK_UP_GET_ENTRIES_H
 
 #include <filesystem>
-#include <set>
 #include <functional>
+#include <vector>
 
 namespace data_packet
 {
@@ -26,22 +26,34 @@ namespace data_packet
 
     /**
      * @brief 根据输入的指定路径输出路径下所有文件（包括隐藏文件）
+     *
+     * 多个线程并行遍历：每个线程从自己的队列中取目录读取，发现的子目录放回自己的队列，
+     * 自己的队列为空时从其他线程的队列中窃取目录。结果最后按路径排序一次，与线程数及遍历顺序无关，
+     * 父目录总在其中的文件之前。
      * @param path 指定路径
-     * @return 文件集合
+     * @param thread_number 遍历的线程数，0表示使用全部硬件线程
+     * @return 按路径排序的文件列表
+     * @throws std::filesystem::filesystem_error 无法读取某个目录时抛出
      */
-    auto get_entries(const std::filesystem::path& path) -> std::multiset<std::filesystem::directory_entry>;
+    auto get_entries(const std::filesystem::path& path, unsigned int thread_number = 1)
+    -> std::vector<std::filesystem::directory_entry>;
 
     using filter_t = std::function<bool(const std::filesystem::directory_entry&)>;
 
     /**
      * @brief 根据输入的指定路径输出路径下筛选过的所有文件
+     *
+     * 过滤器在遍历时调用：返回true的文件不会出现在结果中，返回true的目录不会被读取，其下的全部内容都被排除。
+     * 多线程遍历时过滤器会被多个线程同时调用。
      * @param path 指定路径
-     * @param filter 过滤器
-     * @return 文件集合
+     * @param filter 过滤器，返回true的文件被排除
+     * @param thread_number 遍历的线程数，0表示使用全部硬件线程
+     * @return 按路径排序的文件列表
      */
     auto get_entries(const std::filesystem::path& path,
-                     const std::function<bool(const std::filesystem::directory_entry&)>& filter)
-    -> std::multiset<std::filesystem::directory_entry>;
+                     const std::function<bool(const std::filesystem::directory_entry&)>& filter,
+                     unsigned int thread_number = 1)
+    -> std::vector<std::filesystem::directory_entry>;
 
     /**
      * @brief 判断当前路径是否为硬链接
@@ -0,0 +1,66 @@
+//
+// Created by hyh on 2026/1/22.
+//
+
+#ifndef DATA_BACK_UP_PATH_MATCHER_H
+#define DATA_BACK_UP_PATH_MATCHER_H
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace data_packet
+{
+    /**
+     * @class path_matcher
+     * @brief 相对路径匹配器，支持精确路径与通配符模式
+     *
+     * 不含通配符的模式按相对路径精确匹配；含有 *、?、[...] 的模式使用fnmatch匹配完整相对路径，
+     * 其中 * 可以匹配 '/'，因此 "*.txt" 匹配任意层级下的txt文件，"dir/?*" 匹配dir下的全部内容。
+     * 模式开头的 "./" 与末尾的 '/' 会被忽略。
+     */
+    class path_matcher
+    {
+    public:
+        path_matcher() = default;
+
+        /**
+         * @brief 由多个模式构造匹配器
+         * @param patterns 多个相对路径或通配符模式，用换行分割，空行被忽略
+         */
+        explicit path_matcher(std::string_view patterns);
+
+        /**
+         * @brief 添加一个模式
+         * @param pattern 相对路径或通配符模式，为空时被忽略
+         */
+        void add(std::string_view pattern);
+
+        /**
+         * @brief 判断是否没有任何模式
+         * @return true 没有模式
+         */
+        [[nodiscard]] bool empty() const { return _literals.empty() && _globs.empty(); }
+
+        /**
+         * @brief 判断相对路径是否匹配任一模式
+         * @param relative_path 相对路径，以 '/' 分隔
+         * @return true 匹配
+         */
+        [[nodiscard]] bool match(std::string_view relative_path) const;
+
+        /**
+         * @brief 判断相对路径本身或其任一上级目录是否匹配任一模式，用于选中目录时包含其下全部内容
+         * @param relative_path 相对路径，以 '/' 分隔
+         * @return true 匹配
+         */
+        [[nodiscard]] bool match_self_or_parent(std::string_view relative_path) const;
+
+    private:
+        std::unordered_set<std::string> _literals;  ///< 不含通配符的模式
+        std::vector<std::string> _globs;            ///< 通配符模式
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_PATH_MATCHER_H
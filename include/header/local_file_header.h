@@ -34,7 +34,9 @@ namespace data_packet
         {
             None = 0,  ///< 无压缩
             LZ77 = 1,  ///< 使用LZ77压缩算法
-            HUFFMAN = 2  ///< 使用哈夫曼压缩
+            HUFFMAN = 2,  ///< 使用哈夫曼压缩，头部为完整的词频表
+            CANONICAL_HUFFMAN = 3,  ///< 使用范式哈夫曼压缩，头部只有出现字符的码长
+            LZ77_SEQUENCE = 4  ///< 使用序列格式的LZ77压缩：字面量游程、变长匹配长度与重复偏移
         };
 
         /**
@@ -45,7 +47,8 @@ namespace data_packet
         {
             None = 0,   ///< 不加密
             my_method = 1,   ///< 自定义加密方法
-            AES_256_CBC = 2 ///< AES 256加密
+            AES_256_CBC = 2, ///< AES 256加密
+            AES_256_GCM = 3  ///< AES 256 GCM分块加密，各块可并行加密、解密并各自认证
         };
 
         /**
@@ -178,7 +181,7 @@ namespace data_packet
         [[nodiscard]] std::filesystem::file_type get_file_type() const;
 
         /**
-         * @brief 设置文件类型
+         * @brief 设置文件类型，增量备份中用std::filesystem::file_type::not_found表示该文件已被删除
          * @param file_type 要设置的文件类型
          */
         void set_file_type(const std::filesystem::file_type& file_type);
@@ -218,6 +221,18 @@ namespace data_packet
          */
         void set_compression_method(compression_method compression_method);
 
+        /**
+         * @brief 判断文件数据是否为分块编码，即由块表与各自独立压缩、加密的数据块组成
+         * @return true 分块编码
+         */
+        [[nodiscard]] bool is_chunked() const;
+
+        /**
+         * @brief 设置文件数据是否为分块编码
+         * @param chunked 是否分块编码
+         */
+        void set_chunked(bool chunked);
+
         /**
          * @brief 获取文件使用的加密方法
          * @return 加密方法枚举值
@@ -341,7 +356,8 @@ namespace data_packet
         std::unique_ptr<byte[]> link_name_{nullptr}; ///< 链接名数据
         std::unique_ptr<byte[]> file_name_{nullptr}; ///< 文件名数据
 
-        static constexpr byte compression_method_mask = static_cast<byte>(0xf0); ///< 压缩方法掩码
+        static constexpr byte compression_method_mask = 0x70;                    ///< 压缩方法掩码
+        static constexpr byte chunked_mask = static_cast<byte>(0x80);            ///< 分块编码标志位
         static constexpr byte encryption_method_mask = 0xf;                      ///< 加密方法掩码
         static constexpr word permission_mask = 0x1ff;                           ///< 权限掩码
         static constexpr byte file_type_mask = static_cast<byte>(0xfe);          ///< 文件类型掩码
@@ -0,0 +1,96 @@
+//
+// Created by hyh on 2026/1/24.
+//
+
+#ifndef DATA_BACK_UP_BLOCK_TABLE_H
+#define DATA_BACK_UP_BLOCK_TABLE_H
+
+#include <algorithm>
+#include <vector>
+
+#include "../utils/byte_conversion.h"
+
+namespace data_packet
+{
+    constexpr dword MIN_CHUNK_SIZE = 64 * 1024;          ///< 分块编码的最小块大小
+    constexpr dword MAX_CHUNK_SIZE = 16 * 1024 * 1024;   ///< 分块编码的最大块大小
+
+    /**
+     * @struct block_table
+     * @brief 分块编码的文件数据开头的块表
+     *
+     * 分块编码的文件数据 = 块表 + 各数据块，原始文件按chunk_size切分，最后一块可以较短，
+     * 每块各自独立压缩、加密，难以压缩的块不压缩存储。本地文件头的CRC32只覆盖块表，块表中的CRC32覆盖各块处理后的数据。
+     * 序列化格式：块大小(4字节) + 块数量(4字节) + 每块[处理后大小(4字节) + CRC32(4字节) + 标志(1字节)]，均为大端，
+     * 标志为1表示该块不压缩存储（仍按本地文件头的方法加密），为0表示按本地文件头的方法压缩
+     */
+    struct block_table
+    {
+        /**
+         * @struct block
+         * @brief 一个数据块的信息
+         */
+        struct block
+        {
+            dword stored_size{0};   ///< 压缩、加密后的大小
+            dword crc_32{0};        ///< 压缩、加密后数据的CRC32
+            bool stored{false};     ///< 该块不压缩存储
+        };
+
+        dword chunk_size{0};         ///< 原始数据的块大小
+        std::vector<block> blocks;   ///< 各数据块
+
+        /**
+         * @brief 计算原始文件切分后的块数量
+         * @param original_size 原始文件大小
+         * @param chunk_size 块大小
+         * @return 块数量
+         */
+        static size_t block_count(qword original_size, dword chunk_size)
+        {
+            return static_cast<size_t>((original_size + chunk_size - 1) / chunk_size);
+        }
+
+        /**
+         * @brief 计算块表序列化后的大小
+         * @param block_count 块数量
+         * @return 字节数
+         */
+        static size_t size_of(size_t block_count) { return 8 + 9 * block_count; }
+
+        /**
+         * @brief 获取块表序列化后的大小
+         * @return 字节数
+         */
+        [[nodiscard]] size_t size() const { return size_of(blocks.size()); }
+
+        /**
+         * @brief 获取第index块的原始大小
+         * @param index 块下标
+         * @param original_size 原始文件大小
+         * @return 原始大小
+         */
+        [[nodiscard]] size_t original_size_of(size_t index, qword original_size) const
+        {
+            return static_cast<size_t>(std::min<qword>(chunk_size, original_size - qword{chunk_size} * index));
+        }
+
+        /**
+         * @brief 序列化块表
+         * @param out 输出位置，需至少size()字节
+         */
+        void serialize(byte* out) const;
+
+        /**
+         * @brief 从分块编码的文件数据开头反序列化块表，并检查各块大小之和与文件数据大小一致
+         * @param in 文件数据
+         * @param size 文件数据大小
+         * @param original_size 原始文件大小，用于检查块大小与块数量
+         * @return 块表
+         * @throws std::runtime_error 块表不完整或与文件大小不符时抛出
+         */
+        static block_table parse(const byte* in, qword size, qword original_size);
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_BLOCK_TABLE_H
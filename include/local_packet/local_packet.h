@@ -172,6 +172,20 @@ namespace data_packet
             _header->set_encryption_method(method);
         }
 
+        /**
+         * @brief 设置文件数据是否为分块编码
+         * @param chunked 是否分块编码
+         * @note 直接转发到底层local_file_header的对应方法
+         */
+        void set_chunked(bool chunked) { _header->set_chunked(chunked); }
+
+        /**
+         * @brief 直接设置CRC32校验值，用于文件数据不在内存中（如分块写出）的情况
+         * @param crc_32 CRC32校验值
+         * @note 直接转发到底层local_file_header的对应方法
+         */
+        void set_crc_32(uint32_t crc_32) { _header->set_crc_32(crc_32); }
+
         /**
          * @brief 设置加密使用的盐值
          * @param salt 16字节的盐值数组
@@ -0,0 +1,171 @@
+//
+// Created by hyh on 2026/1/20.
+//
+
+#ifndef DATA_BACK_UP_DIRECTORY_H
+#define DATA_BACK_UP_DIRECTORY_H
+
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../header/file_header.h"
+#include "../header/local_file_header.h"
+
+namespace data_packet
+{
+    /**
+     * @brief 带中央目录的包格式版本
+     *
+     * 版本1：总文件头 + 本地文件包序列。
+     * 版本2：在版本1之后追加中央目录与定长尾部，本地文件包部分与版本1完全相同，
+     * 因此只按file_number读取本地文件包的旧读取方式仍然可用。
+     */
+    constexpr word DIRECTORY_VERSION = 2;
+
+    /**
+     * @brief 带包扩展字段的包格式版本
+     *
+     * 版本3：中央目录在各记录之后追加包扩展字段：长度(2字节，大端) + 若干项，格式与记录的扩展字段相同。
+     * 按版本2读取时只解析file_number条记录，其后的内容被忽略，因此版本3的包仍可按版本2读取。
+     */
+    constexpr word ARCHIVE_EXTRA_VERSION = 3;
+
+    /**
+     * @enum extra_tag
+     * @brief 中央目录记录扩展字段中各项的标签
+     *
+     * 扩展字段由若干项依次组成，每项为：标签(1字节) + 内容长度(2字节，大端) + 内容，读取时忽略不认识的标签。
+     * 记录的扩展字段与包扩展字段共用同一组标签
+     */
+    enum class extra_tag : uint8_t
+    {
+        in_base = 1,   ///< 增量备份中未变化的文件：只记录文件头，文件数据位于基准备份包中，内容为空
+        in_store = 2,  ///< 文件内容保存在块存储中：文件数据为块引用列表，内容为空
+        window_log = 3,  ///< 文件使用了LZ77长距离匹配：内容为窗口大小的对数(1字节)
+        level = 4,  ///< 文件使用序列格式的LZ77压缩：内容为压缩级别(1字节)
+        key_check = 5,  ///< 包扩展字段：加密包的密码校验值，见encryption::make_key_check
+        kdf = 6,  ///< 包扩展字段：加密包的密钥派生参数，见encryption::kdf_parameters
+    };
+
+    /**
+     * @brief 向扩展字段追加一项
+     * @param extra 扩展字段
+     * @param tag 标签
+     * @param value 内容
+     */
+    void append_extra_field(std::string& extra, extra_tag tag, std::string_view value = {});
+
+    /**
+     * @brief 在扩展字段中查找一项
+     * @param extra 扩展字段
+     * @param tag 标签
+     * @return 找到时为该项的内容，否则为空
+     * @throws std::runtime_error 扩展字段格式错误时抛出
+     */
+    std::optional<std::string_view> find_extra_field(std::string_view extra, extra_tag tag);
+
+    /**
+     * @struct directory_record
+     * @brief 中央目录中的一条记录：本地文件头的副本及其在包内的位置
+     *
+     * 序列化格式：offset(8字节，大端) + extra长度(2字节，大端) + extra + 本地文件头(含变长字段)
+     */
+    struct directory_record
+    {
+        qword offset{0};                              ///< 本地文件头相对包起始位置的偏移
+        std::unique_ptr<local_file_header> header;    ///< 本地文件头
+        std::string extra;                            ///< 扩展字段，供后续格式修订使用
+
+        /**
+         * @brief 判断扩展字段中是否含有指定标签的项
+         * @param tag 标签
+         * @return true 含有
+         */
+        [[nodiscard]] bool has(extra_tag tag) const
+        {
+            return find_extra_field(extra, tag).has_value();
+        }
+
+        /**
+         * @brief 获取该记录对应的本地文件包（头部与数据）在包内的结束位置
+         * @return 结束位置相对包起始位置的偏移
+         */
+        [[nodiscard]] qword end() const
+        {
+            return offset + header->header_size() + header->get_file_size();
+        }
+    };
+
+    /**
+     * @struct directory_footer
+     * @brief 包末尾的定长尾部，指向中央目录
+     *
+     * 序列化格式：签名(4字节) + 中央目录偏移(8字节) + 中央目录大小(8字节) + 中央目录CRC32(4字节)，均为大端
+     */
+    struct directory_footer
+    {
+        static constexpr dword SIGNATURE = 0x504b4344;   ///< "PKCD"
+        static constexpr size_t SIZE = 4 + 8 + 8 + 4;     ///< 尾部大小
+
+        qword offset{0};     ///< 中央目录相对包起始位置的偏移
+        qword size{0};       ///< 中央目录大小
+        dword crc_32{0};     ///< 中央目录的CRC32校验值
+
+        /**
+         * @brief 序列化尾部
+         * @param out 输出位置，需至少SIZE字节
+         */
+        void serialize(byte* out) const;
+
+        /**
+         * @brief 反序列化尾部
+         * @param in 输入位置，需至少SIZE字节
+         * @return 签名是否正确
+         */
+        bool parse(const byte* in);
+    };
+
+    /**
+     * @brief 序列化一条中央目录记录并追加到缓冲区
+     * @param buffer 中央目录缓冲区
+     * @param offset 本地文件头相对包起始位置的偏移
+     * @param header 本地文件头
+     * @param extra 扩展字段
+     */
+    void append_directory_record(std::vector<byte>& buffer, qword offset, const local_file_header& header,
+                                 std::string_view extra = {});
+
+    /**
+     * @brief 读取包的总文件头与全部本地文件头，不读取文件数据
+     *
+     * 版本2及以上的包只读取尾部与中央目录；旧版本的包逐个读取本地文件头并跳过文件数据。
+     * 流需支持seekg，调用后流的位置不确定。
+     * @param is 指定输入流，当前位置为包的起始位置
+     * @param header 输出：总文件头
+     * @param archive_extra 输出：包扩展字段，不为空指针时写入，版本3之前的包为空
+     * @return 按写入顺序排列的中央目录记录
+     * @throws std::runtime_error 包不完整或校验失败时抛出
+     */
+    std::vector<directory_record> read_directory(std::istream& is, file_header& header,
+                                                 std::string* archive_extra = nullptr);
+
+    /**
+     * @brief 从内存中的完整包读取总文件头与全部本地文件头，不访问文件数据
+     *
+     * 与read_directory(std::istream&, file_header&)的结果相同，且保证每条记录的本地文件包位于包内。
+     * @param data 包的起始位置
+     * @param size 包的大小
+     * @param header 输出：总文件头
+     * @param archive_extra 输出：包扩展字段，不为空指针时写入，版本3之前的包为空
+     * @return 按写入顺序排列的中央目录记录
+     * @throws std::runtime_error 包不完整或校验失败时抛出
+     */
+    std::vector<directory_record> read_directory(const byte* data, size_t size, file_header& header,
+                                                 std::string* archive_extra = nullptr);
+} // data_packet
+
+#endif //DATA_BACK_UP_DIRECTORY_H
@@ -0,0 +1,82 @@
+//
+// Created by hyh on 2026/1/23.
+//
+
+#ifndef DATA_BACK_UP_MAPPED_PACKET_H
+#define DATA_BACK_UP_MAPPED_PACKET_H
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "directory.h"
+
+namespace data_packet
+{
+    /**
+     * @class mapped_packet
+     * @brief 基于只读内存映射的包读取器
+     *
+     * 构造时映射整个包并读取中央目录（旧版本包逐个解析本地文件头），文件数据以指向映射区的视图给出，
+     * 解密、解压与CRC32校验可以直接在映射的数据上进行而无需复制。
+     * 同一包的多个读取器共享操作系统的页缓存。映射在读取器析构时解除，视图不能在此之后使用。
+     */
+    class mapped_packet
+    {
+    public:
+        /**
+         * @brief 映射指定的包并读取中央目录
+         * @param path 包的路径
+         * @throws std::runtime_error 无法打开、映射，或包不完整、校验失败时抛出
+         */
+        explicit mapped_packet(const std::filesystem::path& path);
+
+        ~mapped_packet();
+
+        mapped_packet(const mapped_packet& other) = delete;
+
+        mapped_packet& operator=(const mapped_packet& other) = delete;
+
+        /**
+         * @brief 获取总文件头信息
+         * @return 总文件头
+         */
+        [[nodiscard]] const file_header& info() const { return _header; }
+
+        /**
+         * @brief 获取全部中央目录记录
+         * @return 按写入顺序排列的中央目录记录
+         */
+        [[nodiscard]] const std::vector<directory_record>& records() const { return _records; }
+
+        /**
+         * @brief 获取包扩展字段
+         * @return 包扩展字段，版本3之前的包为空
+         */
+        [[nodiscard]] std::string_view archive_extra() const { return _archive_extra; }
+
+        /**
+         * @brief 获取第index个本地文件包的文件数据视图
+         * @param index 记录下标
+         * @return 指向映射区的文件数据
+         */
+        [[nodiscard]] std::span<const byte> data(size_t index) const;
+
+        /**
+         * @brief 校验第index个本地文件包：包内的本地文件头与中央目录一致，且文件数据的CRC32正确，
+         * 分块编码时校验块表及每个数据块的CRC32
+         * @param index 记录下标
+         * @throws std::runtime_error 校验失败时抛出
+         */
+        void verify(size_t index) const;
+
+    private:
+        const byte* _data{nullptr};             ///< 映射区起始位置
+        size_t _size{0};                        ///< 映射区大小
+        file_header _header{};
+        std::vector<directory_record> _records;
+        std::string _archive_extra;
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_MAPPED_PACKET_H
@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <functional>
+#include <map>
 #include <set>
 
 #include "../header/file_header.h"
@@ -144,9 +145,33 @@ namespace data_packet
 
 
     /***/
-    using get_entries_t = std::function<std::multiset<std::filesystem::directory_entry>(const std::filesystem::path& path,
+    using get_entries_t = std::function<std::vector<std::filesystem::directory_entry>(const std::filesystem::path& path,
                      const std::function<bool(const std::filesystem::directory_entry&)>& filter)>;
 
+    /// 硬链接映射表，inode号到首次出现的相对路径
+    using hard_link_map_t = std::map<std::uint64_t, std::filesystem::path>;
+
+    /**
+     * @brief 将单个目录项打包为包文件，常规文件内容在此时读入内存
+     * @param root_path 打包根路径
+     * @param entry 需要打包的目录项
+     * @param hard_links 硬链接映射表，同一次打包过程中需复用同一张表
+     * @param read_content 是否读入常规文件的内容；为false时常规文件只填写头部，文件数据为空，
+     * 由调用方自行分段读取（硬链接的数据不受影响）
+     * @return 包文件
+     */
+    local_packet make_local_packet(const std::filesystem::path& root_path,
+                                   const std::filesystem::directory_entry& entry,
+                                   hard_link_map_t& hard_links,
+                                   bool read_content = true);
+
+    /**
+     * @brief 读入常规文件的内容作为本地文件包的文件数据，读取的长度取自本地文件头的文件大小
+     * @param local_pkt 由make_local_packet(..., false)得到的本地文件包
+     * @param path 文件的绝对路径
+     */
+    void read_file_content(local_packet& local_pkt, const std::filesystem::path& path);
+
     /**
      * @brief 将指定路径下的文件打包
      * @param path 指定路径
@@ -154,6 +179,56 @@ namespace data_packet
      */
     packet make_packet(const std::filesystem::path& path);
 
+    /**
+     * @class unpacker
+     * @brief 逐个还原本地文件包的解包器
+     *
+     * 目录、常规文件、设备文件与管道在unpack时立即写出；硬链接与软链接只记录名称，
+     * 在finish时先还原硬链接再还原软链接；目录权限在finish时最后设置，避免只读目录阻止写入其中的文件。
+     * 调用方需保证父目录先于其中的文件传入（get_entries的顺序满足该要求）。
+     */
+    class unpacker
+    {
+    public:
+        /**
+         * @brief 构造解包器
+         * @param path 还原的目标路径
+         */
+        explicit unpacker(std::filesystem::path path) : _path(std::move(path)) {}
+
+        /**
+         * @brief 还原一个已解密、解压的本地文件包，若目标已存在则先删除，已存在的目录保留并合并其中内容
+         * @param local_pkt 本地文件包
+         */
+        void unpack(const local_packet& local_pkt);
+
+        /**
+         * @brief 还原一个本地文件，数据可以来自任意位置（如映射区），不要求属于local_packet
+         * @param info 本地文件头
+         * @param data 已解密、解压的文件数据
+         * @param size 文件数据大小
+         */
+        void unpack(const local_file_header& info, const byte* data, size_t size);
+
+        /**
+         * @brief 分段还原一个常规文件，文件内容由调用方写入，用于分块编码等无法一次得到全部数据的情况
+         * @param info 本地文件头，需为常规文件
+         * @param write 向已打开的目标文件写入全部内容的函数
+         */
+        void unpack(const local_file_header& info, const std::function<void(std::ostream&)>& write);
+
+        /**
+         * @brief 还原延后处理的硬链接、软链接与目录权限
+         */
+        void finish();
+
+    private:
+        std::filesystem::path _path;
+        std::vector<std::pair<std::string, std::string>> _hard_links;             ///< (目标, 链接名)
+        std::vector<std::pair<std::string, std::string>> _symlinks;               ///< (目标, 链接名)
+        std::vector<std::pair<std::filesystem::path, std::filesystem::perms>> _directories; ///< 目录及其权限
+    };
+
     /**
      * @brief 将指定路径的已打包文件解包
      * @param path 指定路径
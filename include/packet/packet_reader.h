@@ -0,0 +1,96 @@
+//
+// Created by hyh on 2026/1/14.
+//
+
+#ifndef DATA_BACK_UP_PACKET_READER_H
+#define DATA_BACK_UP_PACKET_READER_H
+
+#include <istream>
+#include <vector>
+
+#include "../header/file_header.h"
+#include "../local_packet/local_packet.h"
+
+namespace data_packet
+{
+    /**
+     * @class packet_reader
+     * @brief 流式包读取器，每次只读取一个本地文件包（文件头与文件数据）
+     *
+     * 与operator>>(std::istream&, packet&)读取相同的格式，但不会一次性把所有文件数据载入内存，
+     * 调用方处理完一个本地文件包后再读取下一个。
+     */
+    class packet_reader
+    {
+    public:
+        /**
+         * @brief 构造读取器并读取、校验总文件头
+         * @param is 指定输入流
+         * @throws std::runtime_error 流状态错误或总文件头校验失败时抛出
+         */
+        explicit packet_reader(std::istream& is);
+
+        ~packet_reader() = default;
+
+        packet_reader(const packet_reader& other) = delete;
+
+        packet_reader& operator=(const packet_reader& other) = delete;
+
+        /**
+         * @brief 读取下一个本地文件包
+         * @param local_pkt 输出：读取到的本地文件包，原有内容被替换
+         * @return true 读取成功，false 已读完所有文件
+         * @throws std::runtime_error 数据不完整或本地文件头校验失败时抛出
+         */
+        bool next(local_packet& local_pkt);
+
+        /**
+         * @brief 读取下一个本地文件头并跳过其文件数据，要求输入流可定位(seekg)
+         * @param local_pkt 输出：只包含本地文件头的本地文件包，原有内容被替换
+         * @return true 读取成功，false 已读完所有文件
+         * @throws std::runtime_error 数据不完整或本地文件头校验失败时抛出
+         */
+        bool skip(local_packet& local_pkt);
+
+        /**
+         * @brief 读取位于指定偏移处的本地文件包，要求输入流可定位(seekg)，不影响next与skip的计数
+         * @param offset 本地文件头相对包起始位置的偏移，通常来自中央目录
+         * @param local_pkt 输出：读取到的本地文件包，原有内容被替换
+         * @throws std::runtime_error 偏移越界、数据不完整或本地文件头校验失败时抛出
+         */
+        void read(qword offset, local_packet& local_pkt);
+
+        /**
+         * @brief 获取总文件头信息
+         * @return 总文件头
+         */
+        [[nodiscard]] const file_header& info() const { return _header; }
+
+        /**
+         * @brief 获取已读取的本地文件包数量
+         * @return 已读取数量
+         */
+        [[nodiscard]] dword read_number() const { return _read_number; }
+
+    private:
+        /**
+         * @brief 从当前位置读取并校验本地文件头
+         * @param local_pkt 输出：只包含本地文件头的本地文件包
+         */
+        void read_header(local_packet& local_pkt);
+
+        /**
+         * @brief 从当前位置读取本地文件头之后的文件数据
+         * @param local_pkt 本地文件包，读取到的数据写入其中
+         */
+        void read_data(local_packet& local_pkt);
+
+        std::istream& _is;
+        std::streampos _begin;       ///< 包的起始位置
+        file_header _header{};
+        dword _read_number{0};
+        std::vector<byte> _buffer;   ///< 本地文件头缓冲区，跨文件复用
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_PACKET_READER_H
@@ -0,0 +1,107 @@
+//
+// Created by hyh on 2026/1/12.
+//
+
+#ifndef DATA_BACK_UP_PACKET_WRITER_H
+#define DATA_BACK_UP_PACKET_WRITER_H
+
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../header/file_header.h"
+#include "../local_packet/local_packet.h"
+
+namespace data_packet
+{
+    /**
+     * @class packet_writer
+     * @brief 流式包写入器，逐个写入本地文件包，不在内存中保留整个数据包
+     *
+     * 构造时先写入占位的总文件头，每写入一个本地文件包便累加文件数量、大小与CRC，并记录中央目录。
+     * finish时在末尾写出中央目录与尾部，再回到起始位置重写总文件头，因此要求输出流可定位(seekp)。
+     * 本地文件包部分与operator<<(std::ostream&, const packet&)的格式完全一致，格式版本为ARCHIVE_EXTRA_VERSION。
+     */
+    class packet_writer
+    {
+    public:
+        /**
+         * @brief 构造写入器并写入占位的总文件头
+         * @param os 指定输出流，需支持seekp
+         */
+        explicit packet_writer(std::ostream& os);
+
+        /**
+         * @brief 析构函数，不会自动调用finish
+         */
+        ~packet_writer() = default;
+
+        packet_writer(const packet_writer& other) = delete;
+
+        packet_writer& operator=(const packet_writer& other) = delete;
+
+        /**
+         * @brief 写入一个本地文件包（文件头与文件数据）
+         * @param local_pkt 需要写入的本地文件包，其头部校验信息需已刷新
+         * @param extra 该文件在中央目录记录中的扩展字段
+         */
+        void write(const local_packet& local_pkt, std::string_view extra = {});
+
+        /**
+         * @brief 开始分段写入一个本地文件包，用于文件数据无法一次放入内存的情况：先写出占位的本地文件头
+         * @param info 本地文件头，文件名与链接名需已确定，其余字段在end时重写
+         */
+        void begin(const local_file_header& info);
+
+        /**
+         * @brief 追加当前本地文件包的一段文件数据
+         * @param data 文件数据
+         * @param size 数据大小
+         */
+        void append(const byte* data, size_t size);
+
+        /**
+         * @brief 结束当前本地文件包：回到开头重写最终的本地文件头，以及文件数据开头的若干字节（如块表）
+         * @param info 最终的本地文件头，头部大小需与begin时相同，文件大小需等于已追加的数据总量，校验信息需已刷新
+         * @param prefix 重写在文件数据开头的字节，begin之后追加的第一段数据需为其占位
+         * @param extra 该文件在中央目录记录中的扩展字段
+         */
+        void end(const local_file_header& info, std::span<const byte> prefix = {}, std::string_view extra = {});
+
+        /**
+         * @brief 结束写入，写出中央目录（含包扩展字段）与尾部并回填总文件头
+         * @param archive_extra 包扩展字段，格式与记录的扩展字段相同
+         */
+        void finish(std::string_view archive_extra = {});
+
+        /**
+         * @brief 获取当前已写入的总文件头信息
+         * @return 总文件头
+         */
+        [[nodiscard]] const file_header& info() const { return _header; }
+
+    private:
+        /**
+         * @brief 记录一个已写出的本地文件包：追加中央目录记录并累加文件数量、大小与CRC
+         * @param info 本地文件头
+         * @param extra 中央目录记录的扩展字段
+         */
+        void record(const local_file_header& info, std::string_view extra = {});
+
+        std::ostream& _os;
+        std::streampos _begin;            ///< 总文件头在输出流中的位置
+        file_header _header{};
+        dword _file_number{0};            ///< 已写入的文件数量
+        qword _file_size{0};              ///< 已写入的处理后总大小（包含头部）
+        qword _original_file_size{0};     ///< 已写入的原始总大小（包含头部）
+        uint32_t _crc{0};                 ///< 各本地文件包CRC串联后的CRC中间状态
+        std::vector<byte> _directory;     ///< 已序列化的中央目录
+        std::streampos _entry{-1};        ///< 正在分段写入的本地文件头在输出流中的位置，-1表示没有
+        size_t _entry_header_size{0};     ///< 正在分段写入的本地文件头大小
+        qword _entry_size{0};             ///< 正在分段写入的本地文件包已追加的数据量
+        bool _finished{false};
+    };
+} // data_packet
+
+#endif //DATA_BACK_UP_PACKET_WRITER_H
@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <iterator>
+#include <memory>
 
 namespace data_packet {
 
@@ -106,12 +107,34 @@ namespace data_packet {
 
     /**
      * @brief 用于计算文件对应的CRC校验码
+     * @details 运行时根据CPU特性选择实现：x86-64支持PCLMULQDQ时使用折叠算法，否则使用slicing-by-8查表
      * @param data 数据指针，以字节为单位
      * @param size 数据长度
      * @return CRC-32校验码
      */
     uint32_t CRC_calculate(const uint8_t* data, uint64_t size);
 
+    /**
+     * @brief 在CRC中间状态上继续累加数据，用于分段计算同一数据流的CRC校验码
+     * @param crc 当前中间状态，首次调用传入INIT
+     * @param data 数据指针，以字节为单位
+     * @param size 数据长度
+     * @return 新的中间状态，全部数据累加完成后需异或FINALXOR得到CRC-32校验码
+     */
+    uint32_t CRC_update(uint32_t crc, const uint8_t* data, uint64_t size);
+
+    namespace detail
+    {
+        /**
+         * @brief 不使用CPU专用指令的slicing-by-8实现，与CRC_update结果相同，用于校验各实现的一致性
+         * @param crc 当前中间状态
+         * @param data 数据指针，以字节为单位
+         * @param size 数据长度
+         * @return 新的中间状态
+         */
+        uint32_t CRC_update_portable(uint32_t crc, const uint8_t* data, uint64_t size);
+    }
+
     /**
      * @brief 用于计算数据流对应的CRC校验码
      * @tparam Iter 迭代器类型，限定数据类型长度为一字节
@@ -124,15 +147,22 @@ namespace data_packet {
 
         static_assert(sizeof(typename std::iterator_traits<Iter>::value_type) == sizeof(uint8_t));
 
-        uint32_t crc = INIT;
-
-        // 查表运算
-        for (auto it= begin;it!=end;++it) {
-            auto index = (crc ^ (*it)) & 0xFF;
-            crc = (crc >> 8) ^ crc32_table[index];
+        // 连续内存使用加速实现
+        if constexpr (std::contiguous_iterator<Iter>) {
+            return CRC_calculate(reinterpret_cast<const uint8_t*>(std::to_address(begin)),
+                                 static_cast<uint64_t>(std::distance(begin, end)));
         }
+        else {
+            uint32_t crc = INIT;
 
-        return crc ^ FINALXOR;
+            // 查表运算
+            for (auto it= begin;it!=end;++it) {
+                auto index = (crc ^ (*it)) & 0xFF;
+                crc = (crc >> 8) ^ crc32_table[index];
+            }
+
+            return crc ^ FINALXOR;
+        }
     }
 
     /**
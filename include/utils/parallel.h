@@ -0,0 +1,98 @@
+//
+// Created by hyh on 2026/1/16.
+//
+
+#ifndef DATA_BACK_UP_PARALLEL_H
+#define DATA_BACK_UP_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace data_packet
+{
+    /**
+     * @brief 将线程数参数规范化：0表示使用全部硬件线程
+     * @param thread_number 用户指定的线程数
+     * @return 实际使用的线程数，至少为1
+     */
+    inline unsigned int resolve_thread_number(unsigned int thread_number)
+    {
+        if (thread_number == 0)
+        {
+            thread_number = std::thread::hardware_concurrency();
+        }
+        return std::max(thread_number, 1u);
+    }
+
+    /**
+     * @brief 使用多个线程并行执行 func(0) ... func(count - 1)
+     *
+     * 各线程通过原子计数器领取下标，执行顺序不确定，调用方需保证不同下标之间互不干扰。
+     * 任意一次调用抛出异常后其余线程不再领取新下标，全部线程结束后重新抛出第一个异常。
+     * thread_number为1或count不超过1时直接在当前线程顺序执行。
+     * @tparam Func 可调用对象，签名为 void(size_t)
+     * @param count 任务数量
+     * @param thread_number 线程数，0表示使用全部硬件线程
+     * @param func 任务函数
+     */
+    template<typename Func>
+    void parallel_for(size_t count, unsigned int thread_number, Func&& func)
+    {
+        thread_number = static_cast<unsigned int>(std::min<size_t>(resolve_thread_number(thread_number), count));
+        if (thread_number <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error{nullptr};
+        std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < count && !failed; i = next++)
+            {
+                try
+                {
+                    func(i);
+                }
+                catch (...)
+                {
+                    if (!error_set.test_and_set())
+                    {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_number - 1);
+        for (unsigned int i = 1; i < thread_number; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+#endif //DATA_BACK_UP_PARALLEL_H
@@ -3,19 +3,32 @@
 //
 
 #include "../../include/back_up/back_up.h"
+#include "../../include/dedup/chunk_store.h"
+#include "../../include/dedup/content_chunker.h"
+#include "../../include/local_packet/block_table.h"
+#include "../../include/packet/directory.h"
+#include "../../include/packet/mapped_packet.h"
 #include "../../include/packet/packet.h"
+#include "../../include/packet/packet_writer.h"
 #include "../../include/file_system/get_entries.h"
+#include "../../include/file_system/path_matcher.h"
+#include <array>
+#include <format>
+#include <optional>
 #include <fstream>
+#include <unordered_map>
 #include "../../include/compression_method/huffman.h"
 #include "../../include/compression_method/lz77.h"
 #include "../../include/encryption_method/encryption.h"
+#include "../../include/utils/crc_32.h"
+#include "../../include/utils/parallel.h"
 
 // 匿名命名空间：限制以下函数仅在当前编译单元（.cpp文件）内可见，避免命名冲突
 namespace
 {
     /**
      * @brief 字符串类型的压缩方法转换为枚举类型的压缩方法
-     * @param method 字符串格式的压缩方法（支持 "LZ77"、"HUFFMAN"、"NONE"）
+     * @param method 字符串格式的压缩方法（支持 "LZ77"、"HUFFMAN"、"NONE"），新的备份使用序列格式的LZ77与范式哈夫曼压缩
      * @return 对应的 data_packet::local_file_header::compression_method 枚举值
      * @throw std::invalid_argument 当传入不识别的压缩方法字符串时抛出异常
      */
@@ -23,11 +36,11 @@ namespace
     {
         if (method == "LZ77")
         {
-            return data_packet::local_file_header::compression_method::LZ77;
+            return data_packet::local_file_header::compression_method::LZ77_SEQUENCE;
         }
         else if (method == "HUFFMAN")
         {
-            return data_packet::local_file_header::compression_method::HUFFMAN;
+            return data_packet::local_file_header::compression_method::CANONICAL_HUFFMAN;
         }
         else if (method == "NONE")
         {
@@ -41,7 +54,7 @@ namespace
 
     /**
      * @brief 字符串类型的加密方法转换为枚举类型的加密方法
-     * @param method 字符串格式的加密方法（支持 "AES_256_CBC"、"NONE"）
+     * @param method 字符串格式的加密方法（支持 "AES_256_CBC"、"AES_256_GCM"、"NONE"）
      * @return 对应的 data_packet::local_file_header::encryption_method 枚举值
      * @throw std::invalid_argument 当传入不识别的加密方法字符串时抛出异常
      */
@@ -51,6 +64,10 @@ namespace
         {
             return data_packet::local_file_header::encryption_method::AES_256_CBC;
         }
+        else if (method == "AES_256_GCM")
+        {
+            return data_packet::local_file_header::encryption_method::AES_256_GCM;
+        }
         else if (method == "NONE")
         {
             return data_packet::local_file_header::encryption_method::None;
@@ -61,10 +78,1033 @@ namespace
         }
     }
 
+    /**
+     * @brief 由备份的可选参数得到序列格式lz77的压缩参数
+     * @param options 可选参数
+     * @return 压缩参数
+     */
+    data_packet::lz77_parameters lz77_parameters_of(const data_packet::back_up_options& options)
+    {
+        return {options.long_distance_window_log, options.compression_level};
+    }
+
+    /**
+     * @brief 由备份的可选参数得到块存储中各块的压缩参数：块不超过CDC_MAX_SIZE，不使用长距离匹配
+     * @param options 可选参数
+     * @return 压缩参数
+     */
+    data_packet::lz77_parameters chunk_parameters_of(const data_packet::back_up_options& options)
+    {
+        return {0, options.compression_level};
+    }
+
+    /**
+     * @brief 使用序列格式lz77压缩的文件在中央目录扩展字段中记录压缩级别，使用了长距离匹配时还记录窗口大小的对数
+     * @param extra 该文件的扩展字段
+     * @param info 处理后的本地文件头
+     * @param options 可选参数
+     */
+    void record_compression(std::string& extra, const data_packet::local_file_header& info,
+                            const data_packet::back_up_options& options)
+    {
+        using namespace data_packet;
+
+        if (info.get_compression_method() != local_file_header::compression_method::LZ77_SEQUENCE)
+        {
+            return;
+        }
+        append_extra_field(extra, extra_tag::level, std::string(1, static_cast<char>(options.compression_level)));
+        if (options.long_distance_window_log != 0 && info.get_original_file_size() > BACK_SIZE)
+        {
+            append_extra_field(extra, extra_tag::window_log,
+                               std::string(1, static_cast<char>(options.long_distance_window_log)));
+        }
+    }
+
+    constexpr size_t SAMPLE_SLICE = 4 * 1024;                  ///< 抽样试压缩时每段样本的大小
+    constexpr size_t SAMPLE_THRESHOLD = 16 * SAMPLE_SLICE;     ///< 不小于该大小的数据先抽样试压缩
+
+    /**
+     * @brief 按指定方法压缩一段数据
+     * @param data 原始数据
+     * @param size 原始数据大小
+     * @param c 压缩方法
+     * @param parameters 序列格式lz77的压缩参数
+     * @return 压缩后的数据与大小；不压缩时数据为空指针
+     */
+    std::pair<std::unique_ptr<data_packet::byte[]>, size_t> compress_data(const data_packet::byte* data, size_t size,
+                                                                         data_packet::local_file_header::compression_method c,
+                                                                         const data_packet::lz77_parameters& parameters)
+    {
+        using namespace data_packet;
+
+        switch (c)
+        {
+            case local_file_header::compression_method::LZ77:
+                return lz77_compress(data, data + size);
+            case local_file_header::compression_method::HUFFMAN:
+                return Huffman_compress(data, data + size);
+            case local_file_header::compression_method::CANONICAL_HUFFMAN:
+                return canonical_Huffman_compress(data, data + size);
+            case local_file_header::compression_method::LZ77_SEQUENCE:
+                return lz77_sequence_compress(data, data + size, parameters);
+            case local_file_header::compression_method::None:
+                // 不压缩：保持原始数据不变，无需处理
+                break;
+        }
+        return {nullptr, size};
+    }
+
+    /**
+     * @brief 估计一段数据是否值得压缩：较大的数据取开头、中间与末尾各一段样本试压缩，较小的数据直接认为值得
+     *
+     * 启用长距离匹配时样本看不到相隔较远的重复内容，不抽样，由完整压缩的结果决定
+     * @param data 原始数据
+     * @param size 原始数据大小
+     * @param c 压缩方法
+     * @param max_ratio 压缩后与原始大小之比的上限
+     * @param parameters 序列格式lz77的压缩参数
+     * @return true 值得完整压缩
+     */
+    bool worth_compressing(const data_packet::byte* data, size_t size,
+                           data_packet::local_file_header::compression_method c, double max_ratio,
+                           const data_packet::lz77_parameters& parameters)
+    {
+        using namespace data_packet;
+
+        if (c == local_file_header::compression_method::None)
+        {
+            return false;
+        }
+        if (size < SAMPLE_THRESHOLD || parameters.window_log != 0)
+        {
+            return true;
+        }
+
+        std::vector<byte> sample(3 * SAMPLE_SLICE);
+        std::copy_n(data, SAMPLE_SLICE, sample.begin());
+        std::copy_n(data + (size - SAMPLE_SLICE) / 2, SAMPLE_SLICE, sample.begin() + SAMPLE_SLICE);
+        std::copy_n(data + size - SAMPLE_SLICE, SAMPLE_SLICE, sample.begin() + 2 * SAMPLE_SLICE);
+        const auto compressed = compress_data(sample.data(), sample.size(), c, parameters);
+        return static_cast<double>(compressed.second) <= static_cast<double>(sample.size()) * max_ratio;
+    }
+
+    /**
+     * @brief 对一段文件数据依次执行 压缩 -> 加密，数据不会被修改
+     *
+     * 抽样表明数据难以压缩时跳过压缩；压缩后与原始大小之比超过max_ratio时丢弃压缩结果，
+     * 两种情况下都改为不压缩存储，并将c改为None。空数据（目录、空文件）保留压缩方法
+     * @param data 原始数据
+     * @param size 原始数据大小
+     * @param c 压缩方法，改为不压缩存储时被设为None
+     * @param e 加密方法
+     * @param key 加密用的密钥
+     * @param file_name 文件名，用于报错信息
+     * @param max_ratio 压缩后与原始大小之比的上限
+     * @param parameters 序列格式lz77的压缩参数
+     * @param thread_number AES-256-GCM分块加密的线程数
+     * @return 处理后的数据与大小；不压缩也不加密时数据为空指针，表示原数据即为处理结果
+     * @throw std::runtime_error 加密失败时抛出
+     */
+    std::pair<std::unique_ptr<data_packet::byte[]>, size_t> encode_data(const data_packet::byte* data, size_t size,
+                                                                       data_packet::local_file_header::compression_method& c,
+                                                                       data_packet::local_file_header::encryption_method e,
+                                                                       const encryption::aes_key& key,
+                                                                       const std::string& file_name,
+                                                                       double max_ratio,
+                                                                       const data_packet::lz77_parameters& parameters,
+                                                                       unsigned int thread_number)
+    {
+        using namespace data_packet;
+
+        // 1. 根据压缩方法执行对应压缩操作，难以压缩或压缩后没有足够收益时改为不压缩存储
+        std::pair<std::unique_ptr<byte[]>, size_t> compressed = {nullptr, size};
+        if (worth_compressing(data, size, c, max_ratio, parameters))
+        {
+            compressed = compress_data(data, size, c, parameters);
+        }
+        if (compressed.first == nullptr ||
+            (size != 0 && static_cast<double>(compressed.second) > static_cast<double>(size) * max_ratio))
+        {
+            compressed = {nullptr, size};
+            c = local_file_header::compression_method::None;
+        }
+
+        // 2. 压缩后的数据用于后续加密操作
+        if (compressed.first != nullptr)
+        {
+            data = compressed.first.get();
+            size = compressed.second;
+        }
+
+        // 3. 根据加密方法执行对应加密操作
+        switch (e)
+        {
+            case local_file_header::encryption_method::AES_256_CBC:
+                {
+                    auto encrypted = encrypt(data, size, key);
+                    if (encrypted.first == nullptr)
+                    {
+                        throw std::runtime_error("Fail to encrypt the file " + file_name);
+                    }
+                    return encrypted;
+                }
+            case local_file_header::encryption_method::AES_256_GCM:
+                {
+                    auto encrypted = gcm_encrypt(data, size, key, thread_number);
+                    if (encrypted.first == nullptr)
+                    {
+                        throw std::runtime_error("Fail to encrypt the file " + file_name);
+                    }
+                    return encrypted;
+                }
+            case local_file_header::encryption_method::None:
+            case local_file_header::encryption_method::my_method:
+                // 不加密/自定义方法：保持数据不变，无需处理
+                break;
+        }
+        return compressed;
+    }
+
+    /**
+     * @brief 加密的文件在本地文件头中记录一个随机盐，用于计算该文件的子密钥
+     * @param local_pkt 本地文件包
+     * @param e 加密方法，不加密时盐保持为0
+     * @throw std::runtime_error 生成随机盐失败时抛出
+     */
+    void set_random_salt(data_packet::local_packet& local_pkt, data_packet::local_file_header::encryption_method e)
+    {
+        if (e == data_packet::local_file_header::encryption_method::None)
+        {
+            return;
+        }
+        std::array<uint8_t, encryption::KDF_SALT_SIZE> salt{};
+        if (RAND_bytes(salt.data(), static_cast<int>(salt.size())) != 1)
+        {
+            throw std::runtime_error("Failed to generate salt");
+        }
+        local_pkt.set_salt(salt);
+    }
+
+    /**
+     * @struct archive_keys
+     * @brief 一个备份包的密钥：每次备份、还原只由密码派生一次，各文件使用由其本地文件头中的随机盐计算的子密钥
+     *
+     * 包扩展字段中没有密钥派生参数的包（未加密或旧版本的包）直接使用由密码生成的密钥。
+     * 块存储在多个备份包之间共享，其中的块使用由块存储根目录中的密钥派生参数派生的密钥，需要时由 open_store 派生。
+     */
+    struct archive_keys
+    {
+        static constexpr std::string_view CHUNK_ID_LABEL = "chunk-id";   ///< 块标识密钥的标签
+
+        std::optional<encryption::kdf_parameters> kdf;  ///< 密钥派生参数，旧版本的包为空
+        encryption::aes_key archive{};                 ///< 备份包的密钥
+        encryption::aes_key store{};                   ///< 块存储的密钥
+        std::string chunk_id_key;                      ///< 计算加密块标识所用的密钥，未派生块存储的密钥时为空
+
+        /**
+         * @brief 备份时生成随机的密钥派生参数并派生备份包的密钥，不加密时不派生
+         * @param e 加密方法
+         * @param password 加密用的密码
+         * @param iterations 迭代次数
+         * @return 密钥
+         * @throw std::runtime_error 派生失败时抛出
+         */
+        static archive_keys create(data_packet::local_file_header::encryption_method e, const std::string& password,
+                                   uint32_t iterations)
+        {
+            archive_keys keys;
+            if (e != data_packet::local_file_header::encryption_method::None)
+            {
+                keys.kdf = encryption::kdf_parameters::generate(iterations);
+                keys.archive = encryption::derive_key(password, *keys.kdf);
+            }
+            return keys;
+        }
+
+        /**
+         * @brief 还原时按包扩展字段中的密钥派生参数派生备份包的密钥，没有参数时使用由密码生成的密钥
+         * @param archive_extra 包扩展字段
+         * @param password 解密用的密码
+         * @return 密钥
+         * @throw std::runtime_error 密钥派生参数不正确或派生失败时抛出
+         */
+        static archive_keys open(std::string_view archive_extra, const std::string& password)
+        {
+            archive_keys keys;
+            if (const auto kdf = data_packet::find_extra_field(archive_extra, data_packet::extra_tag::kdf))
+            {
+                keys.kdf = encryption::kdf_parameters::parse(*kdf);
+                keys.archive = encryption::derive_key(password, *keys.kdf);
+            }
+            else
+            {
+                keys.archive = encryption::password_key(password);
+            }
+            return keys;
+        }
+
+        /**
+         * @brief 按块存储根目录中的密钥派生参数派生块存储的密钥，以及由其计算的块标识密钥
+         * @param chunks 块存储
+         * @param password 密码
+         * @param iterations 块存储中还没有参数时生成参数的迭代次数，为0时不生成
+         * @throw std::runtime_error 块存储中没有参数且不生成、参数不正确或派生失败时抛出
+         */
+        void open_store(const data_packet::chunk_store& chunks, const std::string& password, uint32_t iterations)
+        {
+            auto parameters = chunks.load_key_derivation();
+            if (!parameters)
+            {
+                if (iterations == 0)
+                {
+                    throw std::runtime_error("chunk store has no key derivation parameters");
+                }
+                parameters = chunks.save_key_derivation(encryption::kdf_parameters::generate(iterations).serialize());
+            }
+            store = encryption::derive_key(password, encryption::kdf_parameters::parse(*parameters));
+            const auto id_key = encryption::derive_subkey(store, CHUNK_ID_LABEL);
+            chunk_id_key.assign(reinterpret_cast<const char*>(id_key.data()), id_key.size());
+        }
+
+        /**
+         * @brief 计算块标识所用的密钥：加密的块使用块标识密钥，不加密的块为空
+         * @param e 块的加密方法
+         * @return 密钥
+         * @throw std::runtime_error 加密的块没有派生块存储的密钥时抛出
+         */
+        [[nodiscard]] std::string_view chunk_key(data_packet::local_file_header::encryption_method e) const
+        {
+            if (e == data_packet::local_file_header::encryption_method::None)
+            {
+                return {};
+            }
+            if (chunk_id_key.empty())
+            {
+                throw std::runtime_error("chunk store has no key derivation parameters");
+            }
+            return chunk_id_key;
+        }
+
+        /**
+         * @brief 计算一个文件的密钥
+         * @param info 本地文件头
+         * @return 有密钥派生参数时为由文件的盐计算的子密钥，否则为备份包的密钥
+         */
+        [[nodiscard]] encryption::aes_key entry_key(const data_packet::local_file_header& info) const
+        {
+            if (!kdf)
+            {
+                return archive;
+            }
+            const auto salt = info.get_salt();
+            return encryption::derive_subkey(archive, salt);
+        }
+
+        /**
+         * @brief 生成写入包扩展字段的密钥派生参数与密码校验值，不加密时为空
+         * @return 包扩展字段的项
+         */
+        [[nodiscard]] std::string archive_extra() const
+        {
+            std::string extra;
+            if (kdf)
+            {
+                data_packet::append_extra_field(extra, data_packet::extra_tag::kdf, kdf->serialize());
+                data_packet::append_extra_field(extra, data_packet::extra_tag::key_check,
+                                                encryption::make_key_check(archive));
+            }
+            return extra;
+        }
+    };
+
+    /**
+     * @brief 对单个本地文件包依次执行 压缩 -> 加密，并刷新其校验信息
+     * @param local_pkt 需要处理的本地文件包，处理后数据被替换为压缩/加密后的数据
+     * @param c 压缩方法
+     * @param e 加密方法，加密时在本地文件头中记录随机盐
+     * @param keys 备份包的密钥
+     * @param max_ratio 压缩后与原始大小之比的上限，超过时该文件不压缩存储
+     * @param parameters 序列格式lz77的压缩参数
+     * @param thread_number AES-256-GCM分块加密的线程数
+     */
+    void encode_local_packet(data_packet::local_packet& local_pkt,
+                             data_packet::local_file_header::compression_method c,
+                             data_packet::local_file_header::encryption_method e,
+                             const archive_keys& keys,
+                             double max_ratio,
+                             const data_packet::lz77_parameters& parameters,
+                             unsigned int thread_number)
+    {
+        // 1. 压缩、加密，若数据被处理则更新文件包的数据流和文件大小
+        set_random_salt(local_pkt, e);
+        auto stream = encode_data(local_pkt.get_data().get(), local_pkt.info().get_file_size(), c, e,
+                                  keys.entry_key(local_pkt.info()), local_pkt.info().get_file_name(), max_ratio,
+                                  parameters, thread_number);
+
+        // 2. 设置当前文件包实际使用的压缩方法和加密方法
+        local_pkt.set_compression_method(c);
+        local_pkt.set_encryption_method(e);
+        if (stream.first != nullptr)
+        {
+            local_pkt.set_data(std::move(stream.first)); // 移动语义，避免拷贝
+            local_pkt.set_file_size(stream.second);      // 更新为处理后的文件大小
+        }
+
+        // 3. 刷新当前文件包的校验信息和时间信息，保证数据一致性
+        local_pkt.refresh_crc_32();          // 刷新 CRC32 校验值
+        local_pkt.refresh_creation_time();   // 刷新文件创建时间
+        local_pkt.refresh_checksum();        // 刷新校验和
+    }
+
+    /**
+     * @brief 分块编码并写出一个常规文件：按块读取文件，每组块并行压缩、加密后依次写出，内存占用与文件大小无关
+     * @param writer 包写入器
+     * @param path 文件的绝对路径
+     * @param local_pkt 只含头部的本地文件包，写出后其头部被更新为最终的头部
+     * @param c 压缩方法
+     * @param e 加密方法，加密时在本地文件头中记录随机盐，各块使用同一子密钥
+     * @param keys 备份包的密钥
+     * @param options 可选参数，使用其中的块大小、内存预算、线程数与压缩比上限，压缩比上限分别作用于每一块，
+     * 难以压缩的块在块表中标记为不压缩存储
+     * @throw std::runtime_error 读取失败或文件在备份过程中被截短时抛出
+     */
+    void write_chunked(data_packet::packet_writer& writer, const std::filesystem::path& path,
+                       data_packet::local_packet& local_pkt,
+                       data_packet::local_file_header::compression_method c,
+                       data_packet::local_file_header::encryption_method e,
+                       const archive_keys& keys,
+                       const data_packet::back_up_options& options)
+    {
+        using namespace data_packet;
+
+        const auto original_size = local_pkt.info().get_original_file_size();
+        const auto& file_name = local_pkt.info().get_file_name();
+
+        block_table table;
+        table.chunk_size = static_cast<dword>(options.chunk_size);
+        table.blocks.resize(block_table::block_count(original_size, table.chunk_size));
+
+        local_pkt.set_compression_method(c);
+        local_pkt.set_encryption_method(e);
+        local_pkt.set_chunked(true);
+        local_pkt.refresh_creation_time();
+        set_random_salt(local_pkt, e);
+        const auto key = keys.entry_key(local_pkt.info());
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open input file " + path.string());
+        }
+
+        // 先写出本地文件头与块表的占位，结束时回填
+        std::vector<byte> table_buffer(table.size());
+        writer.begin(local_pkt.info());
+        writer.append(table_buffer.data(), table_buffer.size());
+        qword stored_size = table_buffer.size();
+
+        // 每组块的原始数据总量不超过内存预算，且至少能让每个线程处理一块
+        const size_t group = std::max<size_t>({options.memory_budget / table.chunk_size, 1,
+                                                resolve_thread_number(options.thread_number)});
+        std::vector<std::unique_ptr<byte[]>> raw(std::min(group, table.blocks.size()));
+        std::vector<std::pair<std::unique_ptr<byte[]>, size_t>> encoded(raw.size());
+
+        for (size_t first = 0; first < table.blocks.size(); first += group)
+        {
+            const size_t count = std::min(group, table.blocks.size() - first);
+
+            // 顺序读取一组块
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto size = table.original_size_of(first + i, original_size);
+                if (raw[i] == nullptr)
+                {
+                    raw[i] = std::make_unique_for_overwrite<byte[]>(table.chunk_size);
+                }
+                file.read(raw[i].get(), static_cast<std::streamsize>(size));
+                if (static_cast<size_t>(file.gcount()) != size)
+                {
+                    throw std::runtime_error("file was truncated during back up: " + path.string());
+                }
+            }
+
+            // 各块互不依赖，并行压缩、加密
+            parallel_for(count, options.thread_number, [&](size_t i)
+            {
+                const auto size = table.original_size_of(first + i, original_size);
+                auto block_c = c;
+                encoded[i] = encode_data(raw[i].get(), size, block_c, e, key, file_name,
+                                         options.max_compression_ratio, lz77_parameters_of(options), 1);
+                if (encoded[i].first == nullptr)
+                {
+                    encoded[i].second = size;
+                }
+                const byte* block = encoded[i].first != nullptr ? encoded[i].first.get() : raw[i].get();
+                table.blocks[first + i] = {static_cast<dword>(encoded[i].second),
+                                           CRC_calculate(reinterpret_cast<const uint8_t*>(block), encoded[i].second),
+                                           block_c != c};
+            });
+
+            // 按顺序写出
+            for (size_t i = 0; i < count; ++i)
+            {
+                const byte* block = encoded[i].first != nullptr ? encoded[i].first.get() : raw[i].get();
+                writer.append(block, encoded[i].second);
+                stored_size += encoded[i].second;
+                encoded[i] = {nullptr, 0};
+            }
+        }
+
+        // 所有块都不压缩存储时，整个文件记录为不压缩
+        if (!table.blocks.empty() && std::ranges::all_of(table.blocks, &block_table::block::stored))
+        {
+            local_pkt.set_compression_method(local_file_header::compression_method::None);
+            for (auto& block : table.blocks)
+            {
+                block.stored = false;
+            }
+        }
+
+        // 回填块表与本地文件头，本地文件头的CRC32只覆盖块表
+        table.serialize(table_buffer.data());
+        local_pkt.set_file_size(stored_size);
+        local_pkt.set_crc_32(CRC_calculate(reinterpret_cast<const uint8_t*>(table_buffer.data()), table_buffer.size()));
+        local_pkt.refresh_checksum();
+        std::string extra;
+        record_compression(extra, local_pkt.info(), options);
+        writer.end(local_pkt.info(), table_buffer, extra);
+    }
+
+    /**
+     * @brief 对一段文件数据依次执行 解密 -> 解压，数据可以来自映射区，不会被修改
+     * @param data 加密、压缩后的文件数据
+     * @param size 文件数据大小
+     * @param c 压缩方法
+     * @param e 加密方法
+     * @param key 解密用的密钥
+     * @param file_name 文件名，用于报错信息
+     * @param original_size 原始数据大小，lz77解压时据此一次分配输出缓冲区
+     * @param thread_number AES-256-GCM分块解密的线程数
+     * @return 还原后的数据与大小；未加密也未压缩时数据为空指针，表示原数据即为还原结果
+     * @throw std::runtime_error 解密失败（密码错误等）时抛出
+     */
+    std::pair<std::unique_ptr<data_packet::byte[]>, size_t> decode_data(const data_packet::byte* data, size_t size,
+                                                                       data_packet::local_file_header::compression_method c,
+                                                                       data_packet::local_file_header::encryption_method e,
+                                                                       const encryption::aes_key& key,
+                                                                       const std::string& file_name,
+                                                                       size_t original_size,
+                                                                       unsigned int thread_number)
+    {
+        using namespace data_packet;
+
+        // 存储解密/解压后的数据流和大小
+        std::pair<std::unique_ptr<byte[]>, size_t> decrypted = {nullptr,size};
+
+        // 1. 根据加密方法执行对应解密操作（先解密，后解压）
+        switch (e)
+        {
+        case local_file_header::encryption_method::AES_256_CBC:
+            {
+                decrypted = decrypt(data,size,key);
+                // 解密失败（密码错误等），抛出异常
+                if (decrypted.first == nullptr)
+                {
+                    throw std::runtime_error("Fail to decrypt the file " + file_name + ". Wrong password");
+                }
+                break;
+            }
+        case local_file_header::encryption_method::AES_256_GCM:
+            {
+                decrypted = gcm_decrypt(data, size, key, thread_number);
+                if (decrypted.first == nullptr)
+                {
+                    throw std::runtime_error("Fail to decrypt the file " + file_name + ". Wrong password");
+                }
+                break;
+            }
+        default:
+            // 不加密/其他方法：保持数据不变，无需处理
+            break;
+        }
+
+        // 2. 解密后的数据用于后续解压操作
+        if (decrypted.first != nullptr)
+        {
+            data = decrypted.first.get();
+            size = decrypted.second;
+        }
+
+        // 3. 根据压缩方法执行对应解压操作
+        switch (c)
+        {
+        case local_file_header::compression_method::LZ77:
+            return lz77_decompress(data,data+size,original_size);
+        case local_file_header::compression_method::HUFFMAN:
+            return Huffman_decompress(data,data+size);
+        case local_file_header::compression_method::CANONICAL_HUFFMAN:
+            return canonical_Huffman_decompress(data,data+size);
+        case local_file_header::compression_method::LZ77_SEQUENCE:
+            return lz77_sequence_decompress(data,data+size);
+        case local_file_header::compression_method::None:
+            // 不压缩：保持数据不变，无需处理
+            break;
+        }
+        return decrypted;
+    }
+
+    /**
+     * @brief 按本地文件头记录的方法对一段文件数据依次执行 解密 -> 解压
+     * @param info 本地文件头，提供加密方法、压缩方法与文件名
+     * @param data 加密、压缩后的文件数据
+     * @param size 文件数据大小
+     * @param key 解密用的密钥
+     * @param original_size 原始数据大小
+     * @param thread_number AES-256-GCM分块解密的线程数
+     * @return 还原后的数据与大小；未加密也未压缩时数据为空指针，表示原数据即为还原结果
+     * @throw std::runtime_error 解密失败（密码错误等）时抛出
+     */
+    std::pair<std::unique_ptr<data_packet::byte[]>, size_t> decode_data(const data_packet::local_file_header& info,
+                                                                       const data_packet::byte* data, size_t size,
+                                                                       const encryption::aes_key& key,
+                                                                       size_t original_size,
+                                                                       unsigned int thread_number)
+    {
+        return decode_data(data, size, info.get_compression_method(), info.get_encryption_method(), key,
+                           info.get_file_name(), original_size, thread_number);
+    }
+
+    /**
+     * @brief 用包扩展字段中的密码校验值检查密码，在访问任何文件数据之前发现错误的密码
+     * @param archive_extra 包扩展字段
+     * @param keys 由密码派生的备份包的密钥
+     * @return true 包中有密码校验值且密码正确；false 包中没有密码校验值（未加密或旧版本的包）
+     * @throw std::runtime_error 密码错误时抛出
+     */
+    bool check_password(std::string_view archive_extra, const archive_keys& keys)
+    {
+        const auto key_check = data_packet::find_extra_field(archive_extra, data_packet::extra_tag::key_check);
+        if (!key_check)
+        {
+            return false;
+        }
+        if (!encryption::verify_key_check(*key_check, keys.archive))
+        {
+            throw std::runtime_error("Wrong password");
+        }
+        return true;
+    }
+
+    /**
+     * @brief 还原块存储中的文件前派生一次块存储的密钥；未加密的包中的块不加密，没有块存储时由还原的文件报错
+     * @param keys 备份包的密钥
+     * @param password 解密用的密码
+     * @param options 可选参数，使用其中的块存储目录
+     * @param in_store 需要还原的文件中是否有保存在块存储中的文件
+     * @throw std::runtime_error 块存储中没有密钥派生参数或派生失败时抛出
+     */
+    void open_chunk_store(archive_keys& keys, const std::string& password, const data_packet::back_up_options& options,
+                          bool in_store)
+    {
+        if (keys.kdf && in_store && !options.chunk_store.empty() && std::filesystem::is_directory(options.chunk_store))
+        {
+            keys.open_store(data_packet::chunk_store(options.chunk_store), password, 0);
+        }
+    }
+
+    /**
+     * @brief 将一段数据切分为内容定义的块，块存储中没有的块压缩、加密后写入块存储，并追加对应的块引用
+     * @param store 块存储
+     * @param chunker 分块器
+     * @param data 数据
+     * @param size 数据大小
+     * @param last 是否为文件的最后一段数据；不是时末尾不足最大块大小的部分留待与后续数据一起切分
+     * @param c 压缩方法
+     * @param e 加密方法
+     * @param keys 备份包的密钥，使用其中块存储的密钥与块标识密钥
+     * @param file_name 文件名，用于报错信息
+     * @param thread_number 压缩、加密各块的线程数
+     * @param max_ratio 压缩后与原始大小之比的上限，超过时该块不压缩存储
+     * @param parameters 序列格式lz77的压缩参数
+     * @param references 块引用列表，新切分的块依次追加到末尾
+     * @return 已切分的数据长度
+     */
+    size_t store_chunks(const data_packet::chunk_store& store, const data_packet::content_chunker& chunker,
+                        const data_packet::byte* data, size_t size, bool last,
+                        data_packet::local_file_header::compression_method c,
+                        data_packet::local_file_header::encryption_method e,
+                        const archive_keys& keys, const std::string& file_name, unsigned int thread_number,
+                        double max_ratio, const data_packet::lz77_parameters& parameters,
+                        std::vector<data_packet::chunk_reference>& references)
+    {
+        using namespace data_packet;
+
+        // 先顺序确定块边界
+        std::vector<std::pair<size_t, size_t>> chunks;
+        size_t offset = 0;
+        while (offset < size && (last || size - offset >= chunker.max_size()))
+        {
+            const auto length = chunker.cut(data + offset, size - offset);
+            chunks.emplace_back(offset, length);
+            offset += length;
+        }
+
+        // 各块互不依赖，并行计算标识并处理新块；同一批中重复的块可能被写入两次，结果相同
+        const auto id_key = keys.chunk_key(e);
+        const size_t first = references.size();
+        references.resize(first + chunks.size());
+        parallel_for(chunks.size(), thread_number, [&](size_t i)
+        {
+            const auto [chunk_offset, length] = chunks[i];
+            const byte* chunk = data + chunk_offset;
+            auto& reference = references[first + i];
+            reference.id = chunk_store::make_id(chunk, length, id_key);
+            reference.size = static_cast<dword>(length);
+            if (!store.contains(reference.id))
+            {
+                auto chunk_c = c;
+                const auto encoded = encode_data(chunk, length, chunk_c, e, keys.store, file_name, max_ratio,
+                                                 parameters, 1);
+                if (encoded.first != nullptr)
+                {
+                    store.put(reference.id, chunk_c, e, reference.size, encoded.first.get(), encoded.second);
+                }
+                else
+                {
+                    store.put(reference.id, chunk_c, e, reference.size, chunk, length);
+                }
+            }
+        });
+        return offset;
+    }
+
+    /**
+     * @brief 将本地文件包的数据替换为块引用列表：文件内容切分后存入块存储，文件数据本身不压缩、不加密
+     * @param local_pkt 已读入文件内容的本地文件包
+     * @param references 文件内容的块引用列表
+     */
+    void set_chunk_references(data_packet::local_packet& local_pkt,
+                              const std::vector<data_packet::chunk_reference>& references)
+    {
+        using namespace data_packet;
+
+        const auto list = chunk_reference::serialize(references);
+        auto buffer = std::make_unique<byte[]>(list.size());
+        std::copy(list.begin(), list.end(), buffer.get());
+
+        local_pkt.set_compression_method(local_file_header::compression_method::None);
+        local_pkt.set_encryption_method(local_file_header::encryption_method::None);
+        local_pkt.set_data(std::move(buffer));
+        local_pkt.set_file_size(list.size());
+        local_pkt.refresh_crc_32();
+        local_pkt.refresh_creation_time();
+        local_pkt.refresh_checksum();
+    }
+
+    /**
+     * @brief 分段读取一个常规文件存入块存储，内存占用与文件大小无关
+     * @param store 块存储
+     * @param chunker 分块器
+     * @param path 文件的绝对路径
+     * @param local_pkt 只含头部的本地文件包，返回后数据为块引用列表
+     * @param c 压缩方法
+     * @param e 加密方法
+     * @param keys 备份包的密钥，使用其中块存储的密钥
+     * @param options 可选参数，使用其中的内存预算与线程数
+     * @throw std::runtime_error 读取失败或文件在备份过程中被截短时抛出
+     */
+    void store_file(const data_packet::chunk_store& store, const data_packet::content_chunker& chunker,
+                    const std::filesystem::path& path, data_packet::local_packet& local_pkt,
+                    data_packet::local_file_header::compression_method c,
+                    data_packet::local_file_header::encryption_method e, const archive_keys& keys,
+                    const data_packet::back_up_options& options)
+    {
+        using namespace data_packet;
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open input file " + path.string());
+        }
+
+        // 缓冲区至少容纳两个最大块，未切分的末尾部分移到开头与后续数据一起切分
+        const size_t capacity = std::max(options.memory_budget, 2 * chunker.max_size());
+        const auto buffer = std::make_unique_for_overwrite<byte[]>(capacity);
+        std::vector<chunk_reference> references;
+        qword remaining = local_pkt.info().get_original_file_size();
+        size_t filled = 0;
+        while (remaining > 0 || filled > 0)
+        {
+            const auto size = static_cast<size_t>(std::min<qword>(capacity - filled, remaining));
+            file.read(buffer.get() + filled, static_cast<std::streamsize>(size));
+            if (static_cast<size_t>(file.gcount()) != size)
+            {
+                throw std::runtime_error("file was truncated during back up: " + path.string());
+            }
+            filled += size;
+            remaining -= size;
+
+            const auto consumed = store_chunks(store, chunker, buffer.get(), filled, remaining == 0, c, e, keys,
+                                               local_pkt.info().get_file_name(), options.thread_number,
+                                               options.max_compression_ratio, chunk_parameters_of(options), references);
+            std::copy(buffer.get() + consumed, buffer.get() + filled, buffer.get());
+            filled -= consumed;
+        }
+        set_chunk_references(local_pkt, references);
+    }
+
+    /**
+     * @brief 校验、解密、解压映射包中的一个本地文件包并立即还原，未加密也未压缩的数据直接从映射区写出
+     * @param archive 映射的备份包
+     * @param index 中央目录记录下标
+     * @param keys 由密码派生的备份包的密钥，读取加密的块时还需已派生块存储的密钥
+     * @param options 可选参数，分块编码时使用其中的内存预算与线程数
+     * @param unpack 解包器
+     */
+    void restore_entry(const data_packet::mapped_packet& archive, size_t index, const archive_keys& keys, const data_packet::back_up_options& options,
+                       data_packet::unpacker& unpack)
+    {
+        using namespace data_packet;
+
+        // 增量备份中未变化的文件已由基准备份包还原
+        if (archive.records()[index].has(extra_tag::in_base))
+        {
+            return;
+        }
+
+        archive.verify(index);
+
+        const auto& info = *archive.records()[index].header;
+        const auto payload = archive.data(index);
+
+        // 文件数据保存在块存储中：每组块并行读取、解密、解压，并核对块标识后按顺序写出
+        if (archive.records()[index].has(extra_tag::in_store))
+        {
+            if (options.chunk_store.empty() || !std::filesystem::is_directory(options.chunk_store))
+            {
+                throw std::runtime_error("chunk store is required to restore " + info.get_file_name());
+            }
+            const chunk_store store(options.chunk_store);
+            const auto references = chunk_reference::parse(payload.data(), payload.size(),
+                                                           info.get_original_file_size());
+
+            const size_t group = std::max<size_t>({options.memory_budget / CDC_MAX_SIZE, 1,
+                                                    resolve_thread_number(options.thread_number)});
+            unpack.unpack(info, [&](std::ostream& out)
+            {
+                std::vector<stored_chunk> chunks(std::min(group, references.size()));
+                std::vector<std::pair<std::unique_ptr<byte[]>, size_t>> decoded(chunks.size());
+                for (size_t first = 0; first < references.size(); first += group)
+                {
+                    const size_t count = std::min(group, references.size() - first);
+                    parallel_for(count, options.thread_number, [&](size_t i)
+                    {
+                        const auto& reference = references[first + i];
+                        chunks[i] = store.get(reference.id);
+                        decoded[i] = decode_data(chunks[i].data.get(), chunks[i].size, chunks[i].compression,
+                                                 chunks[i].encryption, keys.store, info.get_file_name(),
+                                                 reference.size, 1);
+                        if (decoded[i].first == nullptr)
+                        {
+                            decoded[i] = {std::move(chunks[i].data), chunks[i].size};
+                        }
+                        if (decoded[i].second != reference.size ||
+                            chunk_store::make_id(decoded[i].first.get(), decoded[i].second,
+                                                 keys.chunk_key(chunks[i].encryption)) != reference.id)
+                        {
+                            throw std::runtime_error("chunk does not match the reference: " + info.get_file_name());
+                        }
+                    });
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        out.write(decoded[i].first.get(), static_cast<std::streamsize>(decoded[i].second));
+                        chunks[i] = {};
+                        decoded[i] = {nullptr, 0};
+                    }
+                }
+            });
+            return;
+        }
+
+        const auto key = keys.entry_key(info);
+
+        // 分块编码：每组块并行解密、解压后按顺序写出
+        if (info.is_chunked())
+        {
+            const auto original_size = info.get_original_file_size();
+            const auto table = block_table::parse(payload.data(), payload.size(), original_size);
+
+            std::vector<const byte*> blocks(table.blocks.size());
+            const byte* block = payload.data() + table.size();
+            for (size_t i = 0; i < blocks.size(); ++i)
+            {
+                blocks[i] = block;
+                block += table.blocks[i].stored_size;
+            }
+
+            const size_t group = std::max<size_t>({options.memory_budget / table.chunk_size, 1,
+                                                    resolve_thread_number(options.thread_number)});
+            unpack.unpack(info, [&](std::ostream& out)
+            {
+                std::vector<std::pair<std::unique_ptr<byte[]>, size_t>> decoded(std::min(group, blocks.size()));
+                for (size_t first = 0; first < blocks.size(); first += group)
+                {
+                    const size_t count = std::min(group, blocks.size() - first);
+                    parallel_for(count, options.thread_number, [&](size_t i)
+                    {
+                        const auto block_size = table.original_size_of(first + i, original_size);
+                        const auto& stored_block = table.blocks[first + i];
+                        const auto block_c = stored_block.stored ? local_file_header::compression_method::None
+                                                                 : info.get_compression_method();
+                        decoded[i] = decode_data(blocks[first + i], stored_block.stored_size, block_c,
+                                                 info.get_encryption_method(), key, info.get_file_name(),
+                                                 block_size, 1);
+                        const auto size = decoded[i].first != nullptr ? decoded[i].second
+                                                                      : table.blocks[first + i].stored_size;
+                        if (size != block_size)
+                        {
+                            throw std::runtime_error("local packet data is corrupted: " + info.get_file_name());
+                        }
+                    });
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        if (decoded[i].first != nullptr)
+                        {
+                            out.write(decoded[i].first.get(), static_cast<std::streamsize>(decoded[i].second));
+                        }
+                        else
+                        {
+                            out.write(blocks[first + i], table.blocks[first + i].stored_size);
+                        }
+                        decoded[i] = {nullptr, 0};
+                    }
+                }
+            });
+            return;
+        }
+        const auto stream = decode_data(info, payload.data(), payload.size(), key,
+                                        static_cast<size_t>(info.get_original_file_size()), options.thread_number);
+        if (stream.first != nullptr)
+        {
+            unpack.unpack(info, stream.first.get(), stream.second);
+        }
+        else
+        {
+            unpack.unpack(info, payload.data(), payload.size());
+        }
+    }
+
+    /**
+     * @brief 比较增量备份所依据的文件元数据：类型、权限、所有者、修改时间、原始大小与链接名
+     * @param current 本次备份的本地文件头
+     * @param base 基准备份包中的本地文件头
+     * @return true 元数据相同，认为文件未变化
+     */
+    bool same_metadata(const data_packet::local_file_header& current, const data_packet::local_file_header& base)
+    {
+        return current.get_file_type() == base.get_file_type() &&
+               current.get_permissions() == base.get_permissions() &&
+               current.get_uid() == base.get_uid() &&
+               current.get_gid() == base.get_gid() &&
+               current.get_last_modification_time() == base.get_last_modification_time() &&
+               current.get_original_file_size() == base.get_original_file_size() &&
+               current.get_link_name() == base.get_link_name();
+    }
+
+    /**
+     * @brief 创建表示文件已被删除的本地文件包：文件类型为not_found，没有文件数据
+     * @param file_name 已删除文件的相对路径
+     * @return 本地文件包
+     */
+    data_packet::local_packet make_deletion_packet(const std::string& file_name)
+    {
+        data_packet::local_packet local_pkt;
+        local_pkt.set_file_type(std::filesystem::file_type::not_found);
+        local_pkt.set_file_name_length(file_name.size());
+        local_pkt.set_file_name(file_name);
+        local_pkt.refresh_crc_32();
+        local_pkt.refresh_creation_time();
+        local_pkt.refresh_checksum();
+        return local_pkt;
+    }
+
+    /**
+     * @brief 选出需要还原的中央目录记录：匹配的记录、硬链接的目标以及它们的上级目录
+     * @param records 中央目录记录
+     * @param matcher 需要还原的路径模式
+     * @return 选中记录的下标，按包内顺序排列，保证目录在其内容之前还原
+     */
+    std::vector<size_t> select_records(const std::vector<data_packet::directory_record>& records,
+                                       const data_packet::path_matcher& matcher)
+    {
+        std::unordered_map<std::string, size_t> index_of;
+        index_of.reserve(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            index_of.emplace(records[i].header->get_file_name(), i);
+        }
+
+        std::vector<bool> selected(records.size(), false);
+        std::vector<size_t> pending;
+        auto select = [&](size_t i)
+        {
+            if (!selected[i])
+            {
+                selected[i] = true;
+                pending.push_back(i);
+            }
+        };
+        auto select_name = [&](const std::string& name)
+        {
+            if (const auto it = index_of.find(name); it != index_of.end())
+            {
+                select(it->second);
+            }
+        };
+
+        // 1. 自身或上级目录匹配的记录
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (matcher.match_self_or_parent(records[i].header->get_file_name()))
+            {
+                select(i);
+            }
+        }
+
+        // 2. 依次补充硬链接的目标与上级目录，新选中的记录同样需要补充
+        while (!pending.empty())
+        {
+            const auto& header = *records[pending.back()].header;
+            pending.pop_back();
+
+            if (header.get_link_name_length() > 0 && header.get_file_size() > 0)
+            {
+                select_name(header.get_link_name());
+            }
+            const std::string name = header.get_file_name();
+            for (auto length = name.rfind('/'); length != std::string::npos && length > 0;
+                 length = name.rfind('/', length - 1))
+            {
+                select_name(name.substr(0, length));
+            }
+        }
+
+        std::vector<size_t> result;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (selected[i])
+            {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
     /**
      * @brief 枚举类型的压缩方法转换为字符串类型
      * @param method 枚举格式的压缩方法
-     * @return 对应的字符串（"LZ77"、"HUFFMAN"、"NONE" 或 "UNKNOWN"）
+     * @return 对应的字符串（"LZ77"、"LZ77 SEQUENCE"、"HUFFMAN"、"CANONICAL HUFFMAN"、"NONE" 或 "UNKNOWN"）
      */
     std::string to_string(data_packet::local_file_header::compression_method method)
     {
@@ -74,6 +1114,10 @@ namespace
                 return "LZ77";
             case data_packet::local_file_header::compression_method::HUFFMAN:
                 return "HUFFMAN";
+            case data_packet::local_file_header::compression_method::CANONICAL_HUFFMAN:
+                return "CANONICAL HUFFMAN";
+            case data_packet::local_file_header::compression_method::LZ77_SEQUENCE:
+                return "LZ77 SEQUENCE";
             case data_packet::local_file_header::compression_method::None:
                 return "NONE";
         }
@@ -84,7 +1128,7 @@ namespace
     /**
      * @brief 枚举类型的加密方法转换为字符串类型
      * @param method 枚举格式的加密方法
-     * @return 对应的字符串（"AES 256 CBC"、"NONE" 或 "UNKNOWN"）
+     * @return 对应的字符串（"AES 256 CBC"、"AES 256 GCM"、"NONE" 或 "UNKNOWN"）
      */
     std::string to_string(data_packet::local_file_header::encryption_method method)
     {
@@ -92,6 +1136,8 @@ namespace
         {
             case data_packet::local_file_header::encryption_method::AES_256_CBC:
                 return "AES 256 CBC";
+            case data_packet::local_file_header::encryption_method::AES_256_GCM:
+                return "AES 256 GCM";
             case data_packet::local_file_header::encryption_method::None:
                 return "NONE";
             case data_packet::local_file_header::encryption_method::my_method:
@@ -103,13 +1149,14 @@ namespace
 }
 
 /**
- * @brief 执行文件备份核心功能：打包源目录文件，进行压缩、加密后写入目标文件
+ * @brief 执行文件备份核心功能：逐批读取源目录文件，进行压缩、加密后流式写入目标文件
  * @param source 源目录路径（待备份的目录，必须存在）
  * @param destination 目标文件路径（备份文件输出路径）
  * @param compression_method 压缩方法字符串（"LZ77"、"HUFFMAN"、"NONE"）
- * @param encryption_method 加密方法字符串（"AES_256_CBC"、"NONE"）
- * @param password 加密/解密密码（当加密方法为 AES_256_CBC 时有效）
- * @param not_including_files 需排除的文件列表（按换行符 \n 分隔多个文件名）
+ * @param encryption_method 加密方法字符串（"AES_256_CBC"、"AES_256_GCM"、"NONE"）
+ * @param password 加密/解密密码（加密方法不为 NONE 时有效）
+ * @param not_including_files 需排除的文件列表（按换行符 \n 分隔多个相对路径、目录或通配符模式）
+ * @param options 可选参数（内存预算、工作线程数等）
  * @return 执行结果：成功返回 "OK"，失败返回异常信息字符串
  */
 std::string data_packet::back_up(
@@ -118,141 +1165,242 @@ std::string data_packet::back_up(
     const std::string& compression_method,
     const std::string& encryption_method,
     const std::string& password,
-    const std::string& not_including_files)
+    const std::string& not_including_files,
+    const back_up_options& options)
 {
+    namespace fs = std::filesystem;
+
+    bool output_created = false;
     try
     {
         // 第一步：校验源目录是否存在，不存在则抛出异常
-        if (!std::filesystem::exists(source))
+        if (!fs::exists(source))
         {
             throw std::invalid_argument("source directory does not exist.");
         }
 
-        // 第二步：打包源目录所有文件为 packet 结构体
-        auto pkt = make_packet(source);
+        // 第二步：解析压缩与加密方法，在写出任何数据前发现参数错误
+        const auto c = c_method(compression_method);
+        const auto e = e_method(encryption_method);
 
-        // 第三步：解析排除文件列表，存储到有序集合中（方便快速查找）
-        std::set<std::string> filtered_files; // 排除文件集合（自动去重、有序）
-        auto begin = not_including_files.begin(), end = not_including_files.begin();
+        if (options.chunk_size != 0 &&
+            (options.chunk_size < MIN_CHUNK_SIZE || options.chunk_size > MAX_CHUNK_SIZE))
+        {
+            throw std::invalid_argument("chunk size is out of range.");
+        }
+        if (!(options.max_compression_ratio > 0))
+        {
+            throw std::invalid_argument("compression ratio is out of range.");
+        }
+        if (options.compression_level < MIN_LEVEL || options.compression_level > MAX_LEVEL)
+        {
+            throw std::invalid_argument("compression level is out of range.");
+        }
+        if (options.long_distance_window_log != 0 &&
+            (options.long_distance_window_log < MIN_WINDOW_LOG || options.long_distance_window_log > MAX_WINDOW_LOG))
+        {
+            throw std::invalid_argument("long distance window is out of range.");
+        }
+        if (options.kdf_iterations < encryption::MIN_KDF_ITERATIONS ||
+            options.kdf_iterations > encryption::MAX_KDF_ITERATIONS)
+        {
+            throw std::invalid_argument("kdf iterations is out of range.");
+        }
 
-        // 按换行符 \n 分割字符串，提取每个需排除的文件名
-        while (end != not_including_files.end())
+        // 加密时由密码派生备份包的密钥，整个备份只派生一次
+        auto keys = archive_keys::create(e, password, options.kdf_iterations);
+
+        // 第三步：将排除列表编译为匹配器，支持精确路径、目录与通配符模式
+        const path_matcher excluded(not_including_files);
+
+        // 第四步：增量备份时映射基准备份包，读取其中仍存在的文件的头部作为清单
+        std::unique_ptr<mapped_packet> base;
+        std::unordered_map<std::string, const local_file_header*> manifest;
+        if (!options.base_archive.empty())
         {
-            if (*end == '\n')
+            if (fs::exists(destination) && fs::equivalent(options.base_archive, destination))
+            {
+                throw std::invalid_argument("base archive can not be the destination.");
+            }
+            base = std::make_unique<mapped_packet>(options.base_archive);
+            for (const auto& record : base->records())
             {
-                filtered_files.insert({begin, end}); // 插入一段[begin, end)的文件名
-                begin = end + 1; // 移动起始迭代器到下一个文件名开头
+                if (record.header->get_file_type() != fs::file_type::not_found)
+                {
+                    manifest.emplace(record.header->get_file_name(), record.header.get());
+                }
             }
-            ++end;
         }
-        // 处理最后一个文件名（若字符串末尾无换行符）
-        if (begin != end)
+
+        // 第五步：多线程并行枚举目录项（仅元数据，不读取文件内容），结果按路径排序。
+        // 排除的文件在遍历时跳过，排除的目录不会被读取，其下的全部内容都被排除
+        const auto entries = excluded.empty()
+                                 ? get_entries(source, options.thread_number)
+                                 : get_entries(source, [&](const fs::directory_entry& entry)
+                                 {
+                                     return excluded.match(entry.path().lexically_relative(source).string());
+                                 }, options.thread_number);
+
+        // 第六步：以二进制模式打开目标文件，写入占位总文件头
+        std::ofstream out(destination, std::ios::binary);
+        if (!out.is_open())
         {
-            filtered_files.insert({begin, end});
+            throw std::runtime_error("Could not open output file " + destination.string());
         }
+        output_created = true;
+        packet_writer writer(out);
 
-        // 第四步：遍历 packet 中的本地文件包，移除需排除的文件
-        for (auto it = pkt.packets().begin(); it != pkt.packets().end();)
+        // 第七步：按内存预算分批 读取 -> 压缩 -> 加密 -> 写出，每批写完即释放
+        hard_link_map_t hard_links;          // 硬链接映射表，跨批次共享
+        std::vector<local_packet> window;    // 当前批次
+        std::vector<std::string> extras;     // 当前批次各文件的中央目录扩展字段
+        size_t window_size = 0;              // 当前批次读入的原始数据量
+
+        std::string in_base_extra;
+        append_extra_field(in_base_extra, extra_tag::in_base);
+
+        // 使用块存储时，常规文件的内容切分后存入块存储，文件数据只保存块引用列表
+        std::unique_ptr<chunk_store> store;
+        const content_chunker chunker;
+        std::string in_store_extra;
+        if (!options.chunk_store.empty())
         {
-            // 若当前文件在排除列表中，删除该元素并更新迭代器
-            if (filtered_files.find(it->info().get_file_name()) != filtered_files.end())
+            store = std::make_unique<chunk_store>(options.chunk_store);
+            append_extra_field(in_store_extra, extra_tag::in_store);
+            if (e != local_file_header::encryption_method::None)
             {
-                it = pkt.packets().erase(it); // erase 返回下一个有效迭代器，无需手动++
-                continue;
+                keys.open_store(*store, password, options.kdf_iterations);
             }
-            ++it; // 非排除文件，迭代器正常后移
         }
 
-        // 第五步：更新 packet 中的文件数量（删除排除文件后，文件总数发生变化）
-        pkt.refresh_file_number();
-
-        // 第六步：遍历所有本地文件包，依次执行 压缩 -> 加密 操作
-        for (auto& local_pkt:pkt.packets())
+        auto flush = [&]()
         {
-            // 1. 设置当前文件包的压缩方法和加密方法（字符串转枚举）
-            local_pkt.set_compression_method(c_method(compression_method));
-            local_pkt.set_encryption_method(e_method(encryption_method));
+            // 同一批次内的文件互不依赖，可并行压缩、加密；写出仍按原顺序进行。未变化的文件只有头部，无需处理。
+            // 批次中的文件少于线程数时，多出的线程用于AES-256-GCM的分块加密
+            const auto cipher_threads = static_cast<unsigned int>(
+                std::max<size_t>(resolve_thread_number(options.thread_number) / std::max<size_t>(window.size(), 1), 1));
+            parallel_for(window.size(), options.thread_number, [&](size_t i)
+            {
+                if (extras[i].empty())
+                {
+                    encode_local_packet(window[i], c, e, keys, options.max_compression_ratio,
+                                        lz77_parameters_of(options), cipher_threads);
+                    record_compression(extras[i], window[i].info(), options);
+                }
+                else if (find_extra_field(extras[i], extra_tag::in_store))
+                {
+                    std::vector<chunk_reference> references;
+                    store_chunks(*store, chunker, window[i].get_data().get(), window[i].info().get_file_size(), true,
+                                 c, e, keys, window[i].info().get_file_name(), 1,
+                                 options.max_compression_ratio,
+                                 chunk_parameters_of(options), references);
+                    set_chunk_references(window[i], references);
+                }
+            });
+            for (size_t i = 0; i < window.size(); ++i)
+            {
+                writer.write(window[i], extras[i]);
+            }
+            window.clear();
+            extras.clear();
+            window_size = 0;
+        };
 
-            // 2. 获取当前文件包的原始数据和文件大小
-            auto data = local_pkt.get_data().get();
-            auto size = local_pkt.info().get_file_size();
+        auto push = [&](local_packet&& local_pkt, std::string extra = {})
+        {
+            window.emplace_back(std::move(local_pkt));
+            extras.emplace_back(std::move(extra));
+        };
 
-            // 存储压缩/加密后的数据流和大小（初始化为原始数据大小，空指针）
-            std::pair<std::unique_ptr<byte[]>, size_t> stream = {nullptr, size};
+        for (const auto& entry : entries)
+        {
+            const auto relative_path = entry.path().lexically_relative(source).string();
 
-            // 3. 根据压缩方法执行对应压缩操作
-            switch (local_pkt.info().get_compression_method())
+            // 常规文件以外的类型只占用头部空间，直接加入批次
+            if (entry.symlink_status().type() != fs::file_type::regular)
             {
-                case local_file_header::compression_method::LZ77:
-                    // LZ77 压缩：输入原始数据指针范围，返回压缩后的数据流和大小
-                    stream = lz77_compress(data, data + size);
-                    break;
-                case local_file_header::compression_method::HUFFMAN:
-                    // Huffman 压缩：输入原始数据指针范围，返回压缩后的数据流和大小
-                    stream = Huffman_compress(data, data + size);
-                    break;
-                case local_file_header::compression_method::None:
-                    // 不压缩：保持原始数据不变，无需处理
-                    break;
+                push(make_local_packet(source, entry, hard_links));
+                manifest.erase(relative_path);
+                continue;
             }
 
-            // 4. 若压缩成功（数据流非空），更新文件包的数据流和文件大小
-            if (stream.first != nullptr)
+            // 常规文件先只填写头部；硬链接此时已得到链接信息，无需读取内容
+            auto local_pkt = make_local_packet(source, entry, hard_links, false);
+            const auto base_header = manifest.extract(relative_path);
+            if (local_pkt.get_data() != nullptr)
             {
-                local_pkt.set_data(std::move(stream.first)); // 移动语义，避免拷贝
-                local_pkt.set_file_size(stream.second);      // 更新为压缩后的文件大小
+                push(std::move(local_pkt));
+                continue;
             }
 
-            // 5. 重新获取压缩后的数据和大小，用于后续加密操作
-            data = local_pkt.get_data().get();
-            size = local_pkt.info().get_file_size();
-            stream = {nullptr, size}; // 重置数据流，准备存储加密后数据
+            // 与基准备份相比未变化的文件只记录头部，文件数据位于基准备份包中
+            if (!base_header.empty() && same_metadata(local_pkt.info(), *base_header.mapped()))
+            {
+                local_pkt.set_compression_method(c);
+                local_pkt.set_encryption_method(e);
+                local_pkt.set_file_size(0);
+                local_pkt.refresh_crc_32();
+                local_pkt.refresh_creation_time();
+                local_pkt.refresh_checksum();
+                push(std::move(local_pkt), in_base_extra);
+                continue;
+            }
 
-            // 6. 根据加密方法执行对应加密操作
-            switch (local_pkt.info().get_encryption_method())
+            // 存入块存储时，超出内存预算的文件分段读取，直接写出块引用列表，不进入批次
+            const size_t entry_size = local_pkt.info().get_file_size();
+            if (store != nullptr && entry_size > options.memory_budget)
             {
-                case local_file_header::encryption_method::AES_256_CBC:
-                    // AES_256_CBC 加密：输入压缩后数据、密码，返回加密后的数据流和大小
-                    stream = encrypt(data, data + size, password);
-                    break;
-                case local_file_header::encryption_method::None:
-                case local_file_header::encryption_method::my_method:
-                    // 不加密/自定义方法：保持数据不变，无需处理
-                    break;
+                flush();
+                store_file(*store, chunker, entry.path(), local_pkt, c, e, keys, options);
+                writer.write(local_pkt, in_store_extra);
+                continue;
             }
 
-            // 7. 若加密成功（数据流非空），更新文件包的数据流和文件大小
-            if (stream.first != nullptr)
+            // 超过块大小的常规文件分块编码，分段读取并直接写出，不进入批次
+            if (store == nullptr && options.chunk_size != 0 && entry_size > options.chunk_size)
             {
-                local_pkt.set_data(std::move(stream.first)); // 移动语义，避免拷贝
-                local_pkt.set_file_size(stream.second);      // 更新为加密后的文件大小
+                flush();
+                write_chunked(writer, entry.path(), local_pkt, c, e, keys, options);
+                continue;
             }
 
-            // 8. 刷新当前文件包的校验信息和时间信息，保证数据一致性
-            local_pkt.refresh_crc_32();          // 刷新 CRC32 校验值
-            local_pkt.refresh_creation_time();   // 刷新文件创建时间
-            local_pkt.refresh_checksum();        // 刷新校验和
+            // 常规文件的内容会被完整读入
+            if (!window.empty() && window_size + entry_size > options.memory_budget)
+            {
+                flush();
+            }
+            read_file_content(local_pkt, entry.path());
+            local_pkt.refresh_crc_32();
+            push(std::move(local_pkt), in_store_extra);
+            window_size += entry_size;
         }
+        flush();
 
-        // 第七步：刷新整个 packet 的全局信息，保证备份文件的完整性
-        pkt.refresh_original_file_size(); // 刷新原始总文件大小（未压缩/加密前）
-        pkt.refresh_file_size();          // 刷新备份后总文件大小（压缩/加密后）
-        pkt.refresh_creation_time();      // 刷新备份包的创建时间
-        pkt.refresh_crc_32();             // 刷新备份包的 CRC32 校验值
-        pkt.refresh_checksum();           // 刷新备份包的校验和
-
-        // 第八步：以二进制模式打开目标文件，写入备份包数据
-        std::ofstream out(destination, std::ios::binary);
-        if (!out.is_open())
+        // 第八步：基准备份中存在、本次不再存在（或被排除）的文件记录为已删除
+        if (base != nullptr)
         {
-            throw std::runtime_error("Could not open output file " + destination.string());
+            for (const auto& record : base->records())
+            {
+                if (manifest.contains(record.header->get_file_name()))
+                {
+                    writer.write(make_deletion_packet(record.header->get_file_name()));
+                }
+            }
         }
-        out << pkt; // 重载 << 运算符，将 packet 序列化写入文件
+
+        // 第九步：写出中央目录，加密时在包扩展字段中记录密钥派生参数与密码校验值，回填总文件头（文件数量、大小、CRC32、校验和）
+        writer.finish(keys.archive_extra());
 
         return {"OK"}; // 备份成功，返回 OK
     }
     catch(const std::exception& e)
     {
+        // 失败时删除写了一半的备份文件
+        if (output_created)
+        {
+            std::error_code ec;
+            fs::remove(destination, ec);
+        }
         // 捕获所有异常，返回异常信息字符串
         return e.what();
     }
@@ -274,27 +1422,72 @@ std::string data_packet::info(const std::filesystem::path& path)
             throw std::runtime_error("Could not open output file " + path.string());
         }
 
-        // 第二步：反序列化备份文件数据到 packet 结构体
-        packet pkt;
-        input >> pkt; // 重载 >> 运算符，从文件读取并解析 packet
+        // 第二步：只读取总文件头与中央目录（旧版本包逐个读取本地文件头），不读取文件数据
+        file_header header;
+        std::string archive_extra;
+        const auto records = read_directory(input, header, &archive_extra);
 
         // 第三步：格式化拼接备份文件信息
         std::string result;
 
         // 拼接全局信息：版本、文件大小、原始大小、创建时间、文件数量
-        result.append(std::format("version:{}\n",pkt.info().get_version()));
-        result.append(std::format("file size:{}\n",pkt.info().get_file_size()));
-        result.append(std::format("original file size:{}\n",pkt.info().get_original_file_size()));
-        result.append(std::format("creation time:{}\n",pkt.info().get_creation_time()));
-        result.append(std::format("file number:{}\n",pkt.info().get_file_number()));
-        // 拼接压缩方法和加密方法（取第一个本地文件包的方法，默认所有文件方法一致）
-        result.append(std::format("compression method:{}\n",to_string(pkt.packets().front().info().get_compression_method())));
-        result.append(std::format("encryption method:{}\n",to_string(pkt.packets().front().info().get_encryption_method())));
+        result.append(std::format("version:{}\n",header.get_version()));
+        result.append(std::format("file size:{}\n",header.get_file_size()));
+        result.append(std::format("original file size:{}\n",header.get_original_file_size()));
+        result.append(std::format("creation time:{}\n",header.get_creation_time()));
+        result.append(std::format("file number:{}\n",header.get_file_number()));
+        // 拼接压缩方法和加密方法：难以压缩的文件与块存储中的文件不压缩（或不加密）存储，取第一个不为NONE的方法
+        auto c = local_file_header::compression_method::None;
+        auto e = local_file_header::encryption_method::None;
+        for (const auto& record : records)
+        {
+            if (c == local_file_header::compression_method::None)
+            {
+                c = record.header->get_compression_method();
+            }
+            if (e == local_file_header::encryption_method::None)
+            {
+                e = record.header->get_encryption_method();
+            }
+        }
+        result.append(std::format("compression method:{}\n",to_string(c)));
+        result.append(std::format("encryption method:{}\n",to_string(e)));
+        if (const auto kdf = find_extra_field(archive_extra, extra_tag::kdf))
+        {
+            result.append(std::format("key derivation:PBKDF2-SHA256 ({} iterations)\n",
+                                      encryption::kdf_parameters::parse(*kdf).iterations));
+        }
+        if (find_extra_field(archive_extra, extra_tag::key_check))
+        {
+            result.append("password check:yes\n");
+        }
+        // 使用了序列格式lz77时拼接压缩级别，使用了长距离匹配时拼接最大的窗口大小
+        unsigned int level = 0;
+        unsigned int window_log = 0;
+        for (const auto& record : records)
+        {
+            if (const auto value = find_extra_field(record.extra, extra_tag::level); value && value->size() == 1)
+            {
+                level = std::max<unsigned int>(level, static_cast<uint8_t>(value->front()));
+            }
+            if (const auto value = find_extra_field(record.extra, extra_tag::window_log); value && value->size() == 1)
+            {
+                window_log = std::max<unsigned int>(window_log, static_cast<uint8_t>(value->front()));
+            }
+        }
+        if (level != 0)
+        {
+            result.append(std::format("compression level:{}\n",level));
+        }
+        if (window_log != 0)
+        {
+            result.append(std::format("long distance window:{}\n",qword{1} << window_log));
+        }
         // 拼接所有包含的文件名列表
         result.append("all file names:\n");
-        for (const auto& local_pkt:pkt.packets())
+        for (const auto& record : records)
         {
-            result.append(local_pkt.info().get_file_name() + "\n");
+            result.append(record.header->get_file_name() + "\n");
         }
 
         return result; // 返回格式化后的信息字符串
@@ -308,96 +1501,93 @@ std::string data_packet::info(const std::filesystem::path& path)
 }
 
 /**
- * @brief 执行备份文件恢复核心功能：读取备份文件，解密、解压后还原到目标目录
+ * @brief 执行备份文件恢复核心功能：映射备份文件，逐个校验本地文件包，解密、解压后立即还原到目标目录
  * @param source 备份文件路径（待恢复的备份文件，必须存在且有效）
  * @param destination 目标目录路径（恢复后的文件输出目录）
- * @param password 解密密码（与备份时的密码一致，AES_256_CBC 加密时有效）
+ * @param password 解密密码（与备份时的密码一致，加密时有效）
+ * @param options 可选参数（分块编码的文件解密、解压时的内存预算与工作线程数）
  * @return 执行结果：成功返回 "OK"，失败返回异常信息字符串
  */
 std::string data_packet::restore_backup(const std::filesystem::path& source, const std::filesystem::path& destination,
-                                        const std::string& password)
+                                        const std::string& password, const back_up_options& options)
 {
     try
     {
-        // 第一步：以二进制模式打开备份文件
-        std::ifstream input(source, std::ios::binary);
-        if (!input.is_open())
+        // 第一步：以只读方式映射备份文件，读取并校验总文件头与中央目录，派生一次备份包的密钥（需要时还有块存储的密钥），有密码校验值时先检查密码
+        const mapped_packet archive(source);
+        auto keys = archive_keys::open(archive.archive_extra(), password);
+        check_password(archive.archive_extra(), keys);
+        open_chunk_store(keys, password, options, std::ranges::any_of(archive.records(), [](const auto& record)
         {
-            throw std::runtime_error("Could not open output file " + source.string());
-        }
-
-        // 第二步：反序列化备份文件到 packet 结构体
-        packet pkt;
-        input >> pkt;
+            return record.has(extra_tag::in_store);
+        }));
+        unpacker unpack(destination);
 
-        // 第三步：遍历所有本地文件包，依次执行 解密 -> 解压 操作
-        for (auto& local_pkt:pkt.packets())
+        // 第二步：逐个校验本地文件包，在映射的数据上解密 -> 解压后立即写出
+        for (size_t i = 0; i < archive.records().size(); ++i)
         {
-            // 1. 获取加密后的数据流和大小
-            auto data = local_pkt.get_data().get();
-            auto size = local_pkt.info().get_file_size();
-
-            // 存储解密/解压后的数据流和大小
-            std::pair<std::unique_ptr<byte[]>, size_t> stream = {nullptr,size};
-
-            // 2. 根据加密方法执行对应解密操作（先解密，后解压）
-            switch (local_pkt.info().get_encryption_method())
-            {
-            case local_file_header::encryption_method::AES_256_CBC:
-                {
-                    // AES_256_CBC 解密：输入加密数据、密码，返回解密后的数据流
-                    stream = decrypt(data,data+size,password);
-                    // 解密失败（密码错误等），抛出异常
-                    if (stream.first == nullptr)
-                    {
-                        throw std::runtime_error("Fail to decrypt the file " + destination.string() + ". Wrong password");
-                    }
-                    break;
-                }
-            default:
-                // 不加密/其他方法：保持数据不变，无需处理
-                break;
-            }
+            restore_entry(archive, i, keys, options, unpack);
+        }
 
-            // 3. 若解密成功，更新文件包的数据流和大小
-            if (stream.first != nullptr)
-            {
-                local_pkt.set_data(std::move(stream.first));
-                local_pkt.set_file_size(stream.second);
-            }
+        // 第三步：还原链接与目录权限
+        unpack.finish();
 
-            // 4. 重新获取解密后的数据和大小，用于后续解压操作
-            data = local_pkt.get_data().get();
-            size = local_pkt.info().get_file_size();
-            stream = {nullptr,size}; // 重置数据流
+        return "OK"; // 恢复成功，返回 OK
+    }
+    catch (const std::exception& e)
+    {
+        // 捕获异常，返回异常信息
+        return e.what();
+    }
+}
 
-            // 5. 根据压缩方法执行对应解压操作
-            switch (local_pkt.info().get_compression_method())
-            {
-            case local_file_header::compression_method::LZ77:
-                // LZ77 解压：输入压缩数据，返回原始数据流
-                stream = lz77_decompress(data,data+size);
-                break;
-            case local_file_header::compression_method::HUFFMAN:
-                // Huffman 解压：输入压缩数据，返回原始数据流
-                stream = Huffman_decompress(data,data+size);
-                break;
-            case local_file_header::compression_method::None:
-                // 不压缩：保持数据不变，无需处理
-                break;
-            }
+/**
+ * @brief 只恢复备份文件中选中的文件：由中央目录定位选中的本地文件包，其余文件数据不会被访问
+ * @param source 备份文件路径（待恢复的备份文件，必须存在且有效）
+ * @param destination 目标目录路径（恢复后的文件输出目录）
+ * @param password 解密密码（与备份时的密码一致，加密时有效）
+ * @param including_files 需恢复的文件列表（按换行符 \n 分隔多个相对路径或通配符模式）
+ * @param options 可选参数（分块编码的文件解密、解压时的内存预算与工作线程数）
+ * @return 执行结果：成功返回 "OK"，失败返回异常信息字符串
+ */
+std::string data_packet::restore_selected(const std::filesystem::path& source,
+                                          const std::filesystem::path& destination,
+                                          const std::string& password,
+                                          const std::string& including_files,
+                                          const back_up_options& options)
+{
+    try
+    {
+        // 第一步：解析需要恢复的文件列表
+        const path_matcher matcher(including_files);
+        if (matcher.empty())
+        {
+            throw std::invalid_argument("no file was selected.");
+        }
 
-            // 6. 若解压成功，更新文件包的数据流和大小（还原为原始数据）
-            if (stream.first != nullptr)
-            {
-                local_pkt.set_data(std::move(stream.first));
-                local_pkt.set_file_size(stream.second);
-            }
+        // 第二步：以只读方式映射备份文件，读取中央目录（旧版本包逐个解析本地文件头），选出需要恢复的记录
+        const mapped_packet archive(source);
+        auto keys = archive_keys::open(archive.archive_extra(), password);
+        check_password(archive.archive_extra(), keys);
+        const auto selected = select_records(archive.records(), matcher);
+        if (selected.empty())
+        {
+            throw std::invalid_argument("no file in the backup matches the selection.");
+        }
+        open_chunk_store(keys, password, options, std::ranges::any_of(selected, [&](size_t i)
+        {
+            return archive.records()[i].has(extra_tag::in_store);
+        }));
 
+        // 第三步：只校验、解密、解压选中的本地文件包，其余文件数据不会被访问
+        unpacker unpack(destination);
+        for (const auto i : selected)
+        {
+            restore_entry(archive, i, keys, options, unpack);
         }
 
-        // 第四步：将还原后的 packet 解压到目标目录
-        unpack_packet(destination,pkt);
+        // 第四步：还原链接与目录权限
+        unpack.finish();
 
         return "OK"; // 恢复成功，返回 OK
     }
@@ -406,4 +1596,45 @@ std::string data_packet::restore_backup(const std::filesystem::path& source, con
         // 捕获异常，返回异常信息
         return e.what();
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 只读取总文件头与中央目录，用包中的密码校验值检查密码，不访问任何文件数据
+ * @param source 备份文件路径
+ * @param password 需要检查的密码
+ * @return 执行结果：密码正确或备份未加密时返回 "OK"，否则返回错误信息
+ */
+std::string data_packet::verify_password(const std::filesystem::path& source, const std::string& password)
+{
+    try
+    {
+        std::ifstream input(source, std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::runtime_error("Could not open input file " + source.string());
+        }
+
+        file_header header;
+        std::string archive_extra;
+        const auto records = read_directory(input, header, &archive_extra);
+        if (check_password(archive_extra, archive_keys::open(archive_extra, password)))
+        {
+            return "OK";
+        }
+
+        // 没有密码校验值：未加密的包无需密码，旧版本的加密包只能在解密时发现错误的密码
+        const bool encrypted = std::ranges::any_of(records, [](const directory_record& record)
+        {
+            return record.header->get_encryption_method() != local_file_header::encryption_method::None;
+        });
+        if (encrypted)
+        {
+            throw std::runtime_error("the backup has no password check value");
+        }
+        return "OK";
+    }
+    catch (const std::exception& e)
+    {
+        return e.what();
+    }
+}
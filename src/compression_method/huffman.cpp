@@ -1,5 +1,6 @@
 #include "../../include/compression_method/huffman.h"
 #include <queue>
+#include <stdexcept>
 std::unique_ptr<data_packet::Huffman::Huffman_tn> data_packet::Huffman::Create_Huffman_Tree()
 {
     std::unique_ptr<Huffman_tn> head;
@@ -43,15 +44,664 @@ std::unique_ptr<data_packet::Huffman::Huffman_tn> data_packet::Huffman::Create_H
 }
 
 
-void data_packet::Huffman::encoding_dfs(Huffman_tn* node, std::string prefix)
+void data_packet::Huffman::encoding_dfs(Huffman_tn* node, qword code, unsigned int length)
 {
     if (node == nullptr)
         return;
     if (node->word != -1)
     {
-        Huffman_coding[(uint8_t)node->word] = prefix;
+        if (length > MAX_CODE_LENGTH)
+        {
+            throw std::runtime_error("Huffman code is too long");
+        }
+        Huffman_coding[(uint8_t)node->word] = Huffman_code{code, static_cast<uint8_t>(length)};
         return;
     }
-    encoding_dfs(node->lson.get(), prefix + "0");//左0右1
-    encoding_dfs(node->rson.get(), prefix + "1");
-}
\ No newline at end of file
+    encoding_dfs(node->lson.get(), code << 1, length + 1);//左0右1
+    encoding_dfs(node->rson.get(), code << 1 | 1, length + 1);
+}
+
+namespace
+{
+    /// 查找表的位数，码长不超过该值的符号一次查表即可解码
+    constexpr unsigned int TABLE_BITS = 11;
+
+    /// 查找表项标记：无效编码
+    constexpr uint8_t INVALID_CODE = 0;
+
+    /// 查找表项标记：编码长于TABLE_BITS，value为读取TABLE_BITS位后到达的树节点
+    constexpr uint8_t LONG_CODE = 0xff;
+
+    /**
+     * @brief 展开为数组的哈夫曼树节点，子节点为-1表示不存在
+     */
+    struct flat_node
+    {
+        int32_t child[2] = {-1, -1};
+        int32_t word = -1;
+    };
+
+    /**
+     * @brief 查找表项
+     * @param value 码长不超过TABLE_BITS时为解码出的字符，否则为树节点下标
+     * @param length 第一个字符的码长，或INVALID_CODE、LONG_CODE标记
+     * @param second 两个编码总长不超过TABLE_BITS时，紧随其后的第二个字符
+     * @param advance 一次查表消耗的位数
+     * @param symbols 一次查表解码的字符数，标记项为0
+     */
+    struct table_entry
+    {
+        uint16_t value = 0;
+        uint8_t length = INVALID_CODE;
+        uint8_t second = 0;
+        uint8_t advance = 0;
+        uint8_t symbols = 0;
+    };
+
+    /**
+     * @brief 将哈夫曼树展开为数组
+     * @param node 当前节点
+     * @param nodes 输出数组
+     * @return 当前节点在数组中的下标
+     */
+    int32_t flatten(const data_packet::Huffman::Huffman_tn* node, std::vector<flat_node>& nodes)
+    {
+        const auto index = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes[index].word = node->word;
+        if (node->lson)
+        {
+            const int32_t child = flatten(node->lson.get(), nodes);
+            nodes[index].child[0] = child;
+        }
+        if (node->rson)
+        {
+            const int32_t child = flatten(node->rson.get(), nodes);
+            nodes[index].child[1] = child;
+        }
+        return index;
+    }
+
+    /**
+     * @brief 递归填充查找表
+     * @param nodes 展开后的哈夫曼树
+     * @param index 当前节点下标
+     * @param code 当前节点的编码（左0右1）
+     * @param depth 当前节点的深度，即编码长度
+     * @param table 查找表
+     */
+    void fill_table(const std::vector<flat_node>& nodes, int32_t index, uint32_t code, unsigned int depth,
+                    std::vector<table_entry>& table)
+    {
+        const flat_node& node = nodes[index];
+        if (node.word != -1)
+        {
+            // 以该编码为前缀的所有表项都解码为该字符
+            const uint32_t first = code << (TABLE_BITS - depth);
+            const uint32_t count = 1u << (TABLE_BITS - depth);
+            const auto length = static_cast<uint8_t>(depth);
+            std::fill_n(table.begin() + first, count,
+                        table_entry{static_cast<uint16_t>(node.word), length, 0, length, 1});
+            return;
+        }
+        if (depth == TABLE_BITS)
+        {
+            table[code] = table_entry{static_cast<uint16_t>(index), LONG_CODE, 0, 0, 0};
+            return;
+        }
+        for (uint32_t bit = 0; bit < 2; ++bit)
+        {
+            if (node.child[bit] != -1)
+            {
+                fill_table(nodes, node.child[bit], code << 1 | bit, depth + 1, table);
+            }
+        }
+    }
+
+    /**
+     * @brief 为查找表补充第二个字符，使一次查表可解码两个短编码
+     * @param table 已填充单字符的查找表
+     */
+    void pair_table(std::vector<table_entry>& table)
+    {
+        constexpr uint32_t mask = (1u << TABLE_BITS) - 1;
+        for (uint32_t index = 0; index < table.size(); ++index)
+        {
+            table_entry& first = table[index];
+            if (first.symbols == 0 || first.length >= TABLE_BITS)
+            {
+                continue;
+            }
+            // 第二个编码完全位于剩余位中时才能合并，剩余位之后补0不影响其解码
+            const table_entry& next = table[(index << first.length) & mask];
+            if (next.symbols != 0 && first.length + next.length <= TABLE_BITS)
+            {
+                first.second = static_cast<uint8_t>(next.value);
+                first.advance = static_cast<uint8_t>(first.length + next.length);
+                first.symbols = 2;
+            }
+        }
+    }
+
+    /**
+     * @brief 按大端字节序读取8字节
+     * @param data 数据位置
+     * @return 四字
+     */
+    uint64_t load_big_endian(const uint8_t* data)
+    {
+        uint64_t value = 0;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            value = value << 8 | data[i];
+        }
+        return value;
+    }
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::Huffman_decode(const uint8_t* data,
+    size_t size)
+{
+    //压缩数据流第一字节为padding_length，随后为256 * 8字节的词频表
+    constexpr size_t header_size = 1 + 256 * 8;
+    if (size < header_size)
+    {
+        throw std::runtime_error("Huffman data is incomplete");
+    }
+
+    const unsigned int padding_length = data[0];
+    const uint8_t* stream = data + header_size;
+    const uint8_t* stream_end = data + size;
+    const size_t stream_size = size - header_size;
+    if (padding_length >= 8 || (stream_size == 0 && padding_length != 0))
+    {
+        throw std::runtime_error("Huffman data is corrupted");
+    }
+    const size_t bit_count = stream_size * 8 - padding_length;
+
+    //从压缩数据流中还原解压表，词频总和即为解压后数据长度
+    Huffman decoding_huffman;
+    qword total = 0;
+    for (size_t i = 0; i < 256; i++)
+    {
+        decoding_huffman.times[i] = load_big_endian(data + 1 + i * 8);
+        if (total + decoding_huffman.times[i] < total)
+        {
+            throw std::runtime_error("Huffman data is corrupted");
+        }
+        total += decoding_huffman.times[i];
+    }
+
+    //每个字符至少占1位，可在分配前排除损坏的词频表
+    if (total > bit_count)
+    {
+        throw std::runtime_error("Huffman data is corrupted");
+    }
+
+    auto decompressed_data = std::make_unique_for_overwrite<byte[]>(total);
+    if (total == 0)
+    {
+        return std::make_pair(std::move(decompressed_data), size_t{0});
+    }
+
+    //建哈夫曼树并生成查找表
+    std::vector<flat_node> nodes;
+    nodes.reserve(511);
+    flatten(decoding_huffman.Create_Huffman_Tree().get(), nodes);
+    std::vector<table_entry> table(size_t{1} << TABLE_BITS);
+    fill_table(nodes, 0, 0, 0, table);
+    pair_table(table);
+    const table_entry* lookup = table.data();
+
+    //位缓冲区高位对齐，count为其中有效位数，低于count的位均为0
+    uint64_t bits = 0;
+    unsigned int count = 0;
+    const uint8_t* it = stream;
+
+    byte* out = decompressed_data.get();
+    qword i = 0;
+    while (i < total)
+    {
+        //快速路径：一次补充至少56位，随后连续查表4次无需再检查有效位数
+        while (stream_end - it >= 8 && total - i >= 8)
+        {
+            bits |= load_big_endian(it) >> count;
+            it += (63 - count) >> 3;
+            count |= 56;
+
+            bool fallback = false;
+            for (unsigned int k = 0; k < 4; ++k)
+            {
+                const table_entry entry = lookup[bits >> (64 - TABLE_BITS)];
+                if (entry.symbols == 0)
+                {
+                    fallback = true;
+                    break;
+                }
+                out[i] = static_cast<byte>(entry.value);
+                out[i + 1] = static_cast<byte>(entry.second);
+                i += entry.symbols;
+                bits <<= entry.advance;
+                count -= entry.advance;
+            }
+            if (fallback)
+            {
+                break;
+            }
+        }
+
+        //逐字符路径：处理数据末尾、无效编码与长编码
+        if (count < TABLE_BITS)
+        {
+            while (count <= 56 && it < stream_end)
+            {
+                bits |= static_cast<uint64_t>(*it++) << (56 - count);
+                count += 8;
+            }
+        }
+
+        const table_entry entry = lookup[bits >> (64 - TABLE_BITS)];
+        if (entry.length == INVALID_CODE)
+        {
+            throw std::runtime_error("Huffman data is corrupted");
+        }
+        const unsigned int length = entry.length != LONG_CODE ? entry.length : TABLE_BITS;
+        if (length > count)
+        {
+            throw std::runtime_error("Huffman data is incomplete");
+        }
+        bits <<= length;
+        count -= length;
+        if (entry.length != LONG_CODE)
+        {
+            out[i++] = static_cast<byte>(entry.value);
+            continue;
+        }
+
+        //长编码：沿树逐位解码
+        int32_t index = entry.value;
+        while (nodes[index].word == -1)
+        {
+            if (count == 0 && it < stream_end)
+            {
+                bits = static_cast<uint64_t>(*it++) << 56;
+                count = 8;
+            }
+            if (count == 0)
+            {
+                throw std::runtime_error("Huffman data is incomplete");
+            }
+            const auto bit = static_cast<unsigned int>(bits >> 63);
+            bits <<= 1;
+            --count;
+            index = nodes[index].child[bit];
+            if (index == -1)
+            {
+                throw std::runtime_error("Huffman data is corrupted");
+            }
+        }
+        out[i++] = static_cast<byte>(nodes[index].word);
+    }
+
+    //已读取的位数不能超过有效数据位数
+    if (static_cast<size_t>(it - stream) * 8 - count > bit_count)
+    {
+        throw std::runtime_error("Huffman data is incomplete");
+    }
+
+    return std::make_pair(std::move(decompressed_data), static_cast<size_t>(total));
+}
+
+namespace
+{
+    /**
+     * @brief 范式哈夫曼解码的查找表项
+     * @param symbol 解码出的字符
+     * @param second 两个编码总长不超过最大码长时，紧随其后的第二个字符
+     * @param length 第一个字符的码长，0表示无效编码
+     * @param advance 一次查表消耗的位数，大于length时解码了两个字符
+     */
+    struct canonical_entry
+    {
+        uint8_t symbol = 0;
+        uint8_t second = 0;
+        uint8_t length = 0;
+        uint8_t advance = 0;
+    };
+
+    /**
+     * @brief 计算码长，码长超过MAX_CANONICAL_CODE_LENGTH时将词频减半（出现过的字符至少保留1）后重建
+     * @param times 词频表
+     * @param lengths 输出各字符的码长，未出现的字符为0
+     */
+    void code_lengths(const data_packet::qword (&times)[256], uint8_t (&lengths)[256])
+    {
+        using data_packet::Huffman;
+
+        Huffman huffman;
+        std::copy(std::begin(times), std::end(times), huffman.times);
+        while (true)
+        {
+            huffman.encoding_dfs(huffman.Create_Huffman_Tree().get());
+            unsigned int max_length = 0;
+            for (const auto& code : huffman.Huffman_coding)
+            {
+                max_length = std::max<unsigned int>(max_length, code.length);
+            }
+            if (max_length <= Huffman::MAX_CANONICAL_CODE_LENGTH)
+            {
+                break;
+            }
+            for (auto& times : huffman.times)
+            {
+                times = times == 0 ? 0 : (times + 1) / 2;
+            }
+        }
+        for (size_t i = 0; i < 256; ++i)
+        {
+            lengths[i] = huffman.Huffman_coding[i].length;
+        }
+    }
+
+    /**
+     * @brief 由码长分配范式哈夫曼编码：码长较短的在前，码长相同时字符较小的在前，依次加一
+     * @param lengths 各字符的码长
+     * @param codes 输出各字符的编码
+     * @return true 码长满足Kraft不等式，可以构成前缀码
+     */
+    bool canonical_codes(const uint8_t (&lengths)[256], uint16_t (&codes)[256])
+    {
+        constexpr unsigned int max = data_packet::Huffman::MAX_CANONICAL_CODE_LENGTH;
+        uint32_t count[max + 1] = {0};
+        for (const auto length : lengths)
+        {
+            if (length > max)
+            {
+                return false;
+            }
+            count[length]++;
+        }
+        count[0] = 0;
+
+        // 每种码长的第一个编码，同时检查编码空间是否用尽
+        uint32_t next[max + 1] = {0};
+        uint32_t code = 0;
+        for (unsigned int length = 1; length <= max; ++length)
+        {
+            code = (code + count[length - 1]) << 1;
+            next[length] = code;
+            if (code + count[length] > (1u << length))
+            {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < 256; ++i)
+        {
+            if (lengths[i] != 0)
+            {
+                codes[i] = static_cast<uint16_t>(next[lengths[i]]++);
+            }
+        }
+        return true;
+    }
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::canonical_Huffman_encode(
+    const uint8_t* data, size_t size)
+{
+    // 原始长度
+    std::vector<uint8_t> header;
+    for (qword value = size; ; value >>= 7)
+    {
+        header.push_back(static_cast<uint8_t>(value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+        if (value < 0x80)
+        {
+            break;
+        }
+    }
+    if (size == 0)
+    {
+        auto result = std::make_unique_for_overwrite<byte[]>(header.size());
+        std::copy(header.begin(), header.end(), result.get());
+        return {std::move(result), header.size()};
+    }
+
+    qword times[256] = {0};
+    for (size_t i = 0; i < size; ++i)
+    {
+        times[data[i]]++;
+    }
+    uint8_t lengths[256] = {0};
+    uint16_t codes[256] = {0};
+    code_lengths(times, lengths);
+    canonical_codes(lengths, codes);
+
+    // 码长表：最大字符 + 4位码长，连续未出现的字符按游程存储
+    size_t last = 255;
+    while (lengths[last] == 0)
+    {
+        --last;
+    }
+    header.push_back(static_cast<uint8_t>(last));
+    std::vector<uint8_t> nibbles;
+    for (size_t i = 0; i <= last;)
+    {
+        if (lengths[i] != 0)
+        {
+            nibbles.push_back(lengths[i++]);
+            continue;
+        }
+        size_t run = 0;
+        while (i + run <= last && lengths[i + run] == 0 && run < 16)
+        {
+            ++run;
+        }
+        nibbles.push_back(0);
+        nibbles.push_back(static_cast<uint8_t>(run - 1));
+        i += run;
+    }
+    for (size_t i = 0; i < nibbles.size(); i += 2)
+    {
+        header.push_back(static_cast<uint8_t>(nibbles[i] << 4 | (i + 1 < nibbles.size() ? nibbles[i + 1] : 0)));
+    }
+
+    // 编码总位数由词频与码长直接得出
+    qword bit_count = 0;
+    for (size_t i = 0; i < 256; ++i)
+    {
+        bit_count += times[i] * lengths[i];
+    }
+    const size_t compressed_size = header.size() + static_cast<size_t>((bit_count + 7) / 8);
+    auto compressed = std::make_unique_for_overwrite<byte[]>(compressed_size);
+    std::copy(header.begin(), header.end(), compressed.get());
+
+    bit_writer writer(compressed.get() + header.size());
+    for (size_t i = 0; i < size; ++i)
+    {
+        writer.write(codes[data[i]], lengths[data[i]]);
+    }
+    writer.flush();
+
+    return {std::move(compressed), compressed_size};
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::canonical_Huffman_decode(
+    const uint8_t* data, size_t size)
+{
+    const uint8_t* it = data;
+    const uint8_t* const end = data + size;
+
+    // 原始长度
+    qword total = 0;
+    for (unsigned int shift = 0; ; shift += 7)
+    {
+        if (it == end || shift > 63)
+        {
+            throw std::runtime_error("Huffman data is incomplete");
+        }
+        total |= static_cast<qword>(*it & 0x7f) << shift;
+        if ((*it++ & 0x80) == 0)
+        {
+            break;
+        }
+    }
+    if (total == 0)
+    {
+        return {std::make_unique_for_overwrite<byte[]>(0), 0};
+    }
+
+    // 码长表
+    if (it == end)
+    {
+        throw std::runtime_error("Huffman data is incomplete");
+    }
+    const size_t last = *it++;
+    uint8_t lengths[256] = {0};
+    bool high = true;
+    auto next_nibble = [&]() -> uint8_t
+    {
+        if (it == end)
+        {
+            throw std::runtime_error("Huffman data is incomplete");
+        }
+        const uint8_t nibble = high ? *it >> 4 : *it++ & 0xf;
+        high = !high;
+        return nibble;
+    };
+    for (size_t i = 0; i <= last;)
+    {
+        const uint8_t length = next_nibble();
+        if (length != 0)
+        {
+            lengths[i++] = length;
+            continue;
+        }
+        i += next_nibble() + 1;
+        if (i > last + 1)
+        {
+            throw std::runtime_error("Huffman data is corrupted");
+        }
+    }
+    if (!high)
+    {
+        ++it;
+    }
+
+    uint16_t codes[256] = {0};
+    if (lengths[last] == 0 || !canonical_codes(lengths, codes))
+    {
+        throw std::runtime_error("Huffman data is corrupted");
+    }
+
+    // 每个字符至少占1位，可在分配前排除损坏的长度
+    const auto stream_size = static_cast<size_t>(end - it);
+    if (total > qword{stream_size} * 8)
+    {
+        throw std::runtime_error("Huffman data is incomplete");
+    }
+
+    // 按最大码长建查找表，以某编码为前缀的全部表项都解码为该字符
+    unsigned int max_length = 0;
+    for (const auto length : lengths)
+    {
+        max_length = std::max<unsigned int>(max_length, length);
+    }
+
+    // 查找表位数不小于最大码长；数据较多时至少取TABLE_BITS位，使两个短编码可以一次查表解码
+    const unsigned int table_bits = total < (qword{1} << TABLE_BITS) ? max_length : std::max(max_length, TABLE_BITS);
+    std::vector<canonical_entry> table(size_t{1} << table_bits);
+    for (size_t i = 0; i < 256; ++i)
+    {
+        if (lengths[i] != 0)
+        {
+            const unsigned int shift = table_bits - lengths[i];
+            std::fill_n(table.begin() + (size_t{codes[i]} << shift), size_t{1} << shift,
+                        canonical_entry{static_cast<uint8_t>(i), 0, lengths[i], lengths[i]});
+        }
+    }
+
+    // 第二个编码完全位于剩余位中时合并，一次查表解码两个字符
+    const size_t mask = table.size() - 1;
+    for (size_t index = 0; index < table.size(); ++index)
+    {
+        canonical_entry& first = table[index];
+        if (first.length == 0 || first.length >= table_bits)
+        {
+            continue;
+        }
+        const canonical_entry& next = table[(index << first.length) & mask];
+        if (next.length != 0 && first.length + next.length <= table_bits)
+        {
+            first.second = next.symbol;
+            first.advance = static_cast<uint8_t>(first.length + next.length);
+        }
+    }
+
+    auto decompressed = std::make_unique_for_overwrite<byte[]>(total);
+    byte* out = decompressed.get();
+
+    // 位缓冲区高位对齐，count为其中有效位数，低于count的位均为0
+    uint64_t bits = 0;
+    unsigned int count = 0;
+    const unsigned int shift = 64 - table_bits;
+    qword i = 0;
+    while (i < total)
+    {
+        if (end - it >= 8)
+        {
+            bits |= load_big_endian(it) >> count;
+            it += (63 - count) >> 3;
+            count |= 56;
+        }
+        else
+        {
+            while (count <= 56 && it < end)
+            {
+                bits |= static_cast<uint64_t>(*it++) << (56 - count);
+                count += 8;
+            }
+        }
+
+        // 数据末尾有效位数不足查找表位数时，只能解码一个码长足够短的字符
+        if (count < table_bits)
+        {
+            const canonical_entry entry = table[bits >> shift];
+            if (entry.length == 0 || entry.length > count)
+            {
+                throw std::runtime_error(entry.length == 0 ? "Huffman data is corrupted" : "Huffman data is incomplete");
+            }
+            out[i++] = static_cast<byte>(entry.symbol);
+            bits <<= entry.length;
+            count -= entry.length;
+            continue;
+        }
+
+        // 有效位数不少于查找表位数时无需检查剩余位数，最后一个字符之前可以一次写出两个字符
+        while (count >= table_bits && i + 1 < total)
+        {
+            const canonical_entry entry = table[bits >> shift];
+            if (entry.length == 0)
+            {
+                throw std::runtime_error("Huffman data is corrupted");
+            }
+            out[i] = static_cast<byte>(entry.symbol);
+            out[i + 1] = static_cast<byte>(entry.second);
+            i += entry.advance != entry.length ? 2 : 1;
+            bits <<= entry.advance;
+            count -= entry.advance;
+        }
+        if (count >= table_bits && i + 1 == total)
+        {
+            const canonical_entry entry = table[bits >> shift];
+            if (entry.length == 0)
+            {
+                throw std::runtime_error("Huffman data is corrupted");
+            }
+            out[i++] = static_cast<byte>(entry.symbol);
+            bits <<= entry.length;
+            count -= entry.length;
+        }
+    }
+
+    return {std::move(decompressed), static_cast<size_t>(total)};
+}
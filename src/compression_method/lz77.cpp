@@ -4,66 +4,1234 @@
 
 #include "../../include/compression_method/lz77.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
 namespace
 {
     /**
-     * @brief 获取串的最长前缀匹配
-     * @param pattern 模式串
-     * @return 前缀匹配数量
+     * @brief 计算两个位置的公共前缀长度
+     * @param a 第一个位置
+     * @param b 第二个位置
+     * @param limit 最大比较长度，两个位置之后均需至少有limit个字节可读
+     * @return 公共前缀长度
      */
-    std::vector<int> get_prefix(const std::vector<char>& pattern)
+    unsigned int common_length(const data_packet::byte* a, const data_packet::byte* b, unsigned int limit)
     {
-        std::vector<int> result(pattern.size(),0);
-        for (unsigned int i = 1; i < pattern.size(); i++)
+        unsigned int length = 0;
+
+        // 每次比较8字节，首个不同字节由异或结果的尾零个数得到
+        while (length + 8 <= limit)
         {
-            auto j = result[i-1];
-            while (pattern[i] != pattern[j] && j >0)
+            uint64_t x, y;
+            memcpy(&x, a + length, 8);
+            memcpy(&y, b + length, 8);
+            if (const uint64_t diff = x ^ y)
             {
-                j = result[j-1];
+                if constexpr (std::endian::native == std::endian::little)
+                {
+                    return length + static_cast<unsigned int>(std::countr_zero(diff)) / 8;
+                }
+                else
+                {
+                    return length + static_cast<unsigned int>(std::countl_zero(diff)) / 8;
+                }
             }
-            if (pattern[i] == pattern[j])
+            length += 8;
+        }
+
+        while (length < limit && a[length] == b[length])
+        {
+            ++length;
+        }
+        return length;
+    }
+
+    /**
+     * @brief 取两个字节组成的双字节表下标
+     * @param position 数据位置
+     * @return 表下标
+     */
+    size_t pair_index(const data_packet::byte* position)
+    {
+        const auto* p = reinterpret_cast<const unsigned char*>(position);
+        return static_cast<size_t>(p[0]) << 8 | p[1];
+    }
+
+    /**
+     * @brief 写入一个4字节压缩单元
+     * @param out 输出位置
+     * @param offset 匹配偏移
+     * @param length 匹配长度
+     * @param next 下一个字符
+     */
+    void write_token(data_packet::byte* out, unsigned int offset, unsigned int length, data_packet::byte next)
+    {
+        auto [high, low] = data_packet::to_bytes(static_cast<data_packet::word>(offset));
+        out[0] = high;
+        out[1] = low;
+        out[2] = static_cast<data_packet::byte>(length);
+        out[3] = next;
+    }
+
+    /**
+     * @brief 生成长距离匹配的Gear滚动哈希使用的256个随机数（splitmix64）
+     * @return 随机数表
+     */
+    constexpr std::array<uint64_t, 256> make_gear_table()
+    {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0x4c5a3737u;
+        for (auto& value : table)
+        {
+            state += 0x9e3779b97f4a7c15u;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+            value = z ^ (z >> 31);
+        }
+        return table;
+    }
+
+    constexpr auto GEAR = make_gear_table();
+
+    constexpr size_t WILD_COPY_SLACK = 16;   ///< 解压输出末尾预留的余量，整块复制可能越过匹配结尾至多15字节
+
+    /**
+     * @brief 复制一个匹配，匹配源位于目标之前offset字节处，可以与目标重叠
+     *
+     * 偏移不小于16（或8）时源与目标的每一块都不重叠，按16（或8）字节整块复制；
+     * 更短的偏移先逐字节复制出一个不小于8字节的整数倍周期，之后按该周期整块复制。
+     * 可能写过匹配结尾至多15字节，调用方需在输出末尾预留WILD_COPY_SLACK字节。
+     * @param destination 目标位置
+     * @param offset 匹配偏移，长度不为0时不为0
+     * @param length 匹配长度
+     */
+    void copy_match(data_packet::byte* destination, size_t offset, size_t length)
+    {
+        if (length == 0)
+        {
+            return;
+        }
+        data_packet::byte* const last = destination + length;
+        if (offset >= 16)
+        {
+            for (const data_packet::byte* source = destination - offset; destination < last;
+                 destination += 16, source += 16)
+            {
+                memcpy(destination, source, 16);
+            }
+            return;
+        }
+
+        size_t period = offset;
+        if (offset < 8)
+        {
+            period = (8 + offset - 1) / offset * offset;
+            for (data_packet::byte* const stop = std::min(last, destination + period); destination < stop; ++destination)
             {
-                j++;
+                *destination = destination[-static_cast<std::ptrdiff_t>(offset)];
             }
-            result[i] = j;
         }
-        return result;
+        for (const data_packet::byte* source = destination - period; destination < last; destination += 8, source += 8)
+        {
+            memcpy(destination, source, 8);
+        }
     }
+
+    /**
+     * @class sequence_writer
+     * @brief 序列格式的输出缓冲区，按需扩容
+     */
+    class sequence_writer
+    {
+    public:
+        explicit sequence_writer(size_t capacity) : _buffer(std::max<size_t>(capacity, 64)) {}
+
+        /**
+         * @brief 写入LEB128变长整数
+         * @param value 待写入的值
+         */
+        void varint(uint64_t value)
+        {
+            reserve(10);
+            for (; value >= 0x80; value >>= 7)
+            {
+                _buffer[_size++] = static_cast<data_packet::byte>((value & 0x7f) | 0x80);
+            }
+            _buffer[_size++] = static_cast<data_packet::byte>(value);
+        }
+
+        /**
+         * @brief 写入标记字节之后的长度扩展：每个扩展字节累加到长度上，直到某个字节不为255
+         * @param value 长度减去15后的值
+         */
+        void extension(size_t value)
+        {
+            reserve(value / 255 + 1);
+            for (; value >= 255; value -= 255)
+            {
+                _buffer[_size++] = static_cast<data_packet::byte>(255);
+            }
+            _buffer[_size++] = static_cast<data_packet::byte>(value);
+        }
+
+        /**
+         * @brief 写入一个序列
+         * @param literals 字面量起始位置
+         * @param literal_length 字面量长度
+         * @param offset_code 偏移编码，0表示沿用上一个偏移
+         * @param match_length 匹配长度，为0时表示只含字面量的最后一个序列
+         */
+        void sequence(const data_packet::byte* literals, size_t literal_length, size_t offset_code, size_t match_length)
+        {
+            const size_t match_code = match_length == 0 ? 0 : match_length - data_packet::SEQUENCE_MIN_MATCH;
+            reserve(1);
+            _buffer[_size++] = static_cast<data_packet::byte>(std::min<size_t>(literal_length, 15) << 4 |
+                                                              std::min<size_t>(match_code, 15));
+            if (literal_length >= 15)
+            {
+                extension(literal_length - 15);
+            }
+            reserve(literal_length);
+            std::copy_n(literals, literal_length, _buffer.data() + _size);
+            _size += literal_length;
+            if (match_length == 0)
+            {
+                return;
+            }
+            varint(offset_code);
+            if (match_code >= 15)
+            {
+                extension(match_code - 15);
+            }
+        }
+
+        /**
+         * @brief 取出精确大小的结果
+         * @return 压缩后数据与长度
+         */
+        std::pair<std::unique_ptr<data_packet::byte[]>, size_t> release() const
+        {
+            auto result = std::make_unique_for_overwrite<data_packet::byte[]>(_size);
+            std::copy_n(_buffer.data(), _size, result.get());
+            return {std::move(result), _size};
+        }
+
+    private:
+        void reserve(size_t extra)
+        {
+            if (_size + extra > _buffer.size())
+            {
+                _buffer.resize(std::max(_buffer.size() * 2, _size + extra));
+            }
+        }
+
+        std::vector<data_packet::byte> _buffer;
+        size_t _size{0};
+    };
+
+    /**
+     * @class sequence_reader
+     * @brief 序列格式的输入读取器，所有读取都检查边界
+     */
+    class sequence_reader
+    {
+    public:
+        sequence_reader(const data_packet::byte* begin, const data_packet::byte* end) : _position(begin), _end(end) {}
+
+        [[nodiscard]] size_t remaining() const { return _end - _position; }
+
+        [[nodiscard]] const data_packet::byte* position() const { return _position; }
+
+        uint8_t next()
+        {
+            if (_position == _end)
+            {
+                throw std::runtime_error("lz77 data is incomplete");
+            }
+            return static_cast<uint8_t>(*_position++);
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (unsigned int shift = 0; ; shift += 7)
+            {
+                const uint8_t current = next();
+                if (shift > 63 || (shift == 63 && current > 1))
+                {
+                    throw std::runtime_error("lz77 data is corrupted");
+                }
+                value |= static_cast<uint64_t>(current & 0x7f) << shift;
+                if ((current & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+        }
+
+        /**
+         * @brief 读取长度扩展
+         * @param limit 长度上限，超过时视为数据损坏
+         * @return 扩展部分的长度
+         */
+        size_t extension(size_t limit)
+        {
+            size_t value = 0;
+            uint8_t current;
+            do
+            {
+                current = next();
+                value += current;
+                if (value > limit)
+                {
+                    throw std::runtime_error("lz77 data is corrupted");
+                }
+            }
+            while (current == 255);
+            return value;
+        }
+
+        void skip(size_t length) { _position += length; }
+
+    private:
+        const data_packet::byte* _position;
+        const data_packet::byte* _end;
+    };
+
+    /**
+     * @enum strategy
+     * @brief 序列的划分方式
+     */
+    enum class strategy
+    {
+        greedy,    ///< 贪心：每个位置直接采用最长的匹配
+        lazy,      ///< 惰性：之后的位置有明显更好的匹配时，当前位置改为字面量
+        optimal,   ///< 最优：在一段位置内按编码后的字节数求代价最小的划分
+    };
+
+    /**
+     * @struct level_setting
+     * @brief 一个压缩级别对应的查找参数
+     */
+    struct level_setting
+    {
+        strategy method;            ///< 划分方式
+        unsigned int depth;         ///< 哈希链或二叉树的最大查找深度
+        unsigned int nice_length;   ///< 最优划分中达到该长度的匹配直接采用
+        unsigned int lazy_steps;    ///< 惰性匹配最多推迟的位置数
+    };
+
+    /// 各压缩级别的查找参数，级别3与引入级别之前的贪心查找相同
+    constexpr level_setting LEVELS[data_packet::MAX_LEVEL] = {
+        {strategy::greedy, 2, 0, 0},
+        {strategy::greedy, 8, 0, 0},
+        {strategy::greedy, 64, 0, 0},
+        {strategy::lazy, 32, 0, 1},
+        {strategy::lazy, 128, 0, 1},
+        {strategy::lazy, 512, 0, 2},
+        {strategy::optimal, 16, 64, 0},
+        {strategy::optimal, 48, 128, 0},
+        {strategy::optimal, 256, 256, 0},
+    };
+
+    /**
+     * @brief 计算LEB128变长整数的字节数
+     * @param value 整数
+     * @return 字节数
+     */
+    size_t varint_size(uint64_t value)
+    {
+        size_t size = 1;
+        for (; value >= 0x80; value >>= 7)
+        {
+            ++size;
+        }
+        return size;
+    }
+
+    /**
+     * @brief 计算一个匹配编码后的字节数：标记 + 偏移 + 匹配长度扩展，字面量每个按1字节计
+     * @param offset_code 偏移编码，0表示沿用上一个偏移
+     * @param length 匹配长度
+     * @return 字节数
+     */
+    size_t match_price(size_t offset_code, size_t length)
+    {
+        const size_t code = length - data_packet::SEQUENCE_MIN_MATCH;
+        return 1 + varint_size(offset_code) + (code >= 15 ? (code - 15) / 255 + 1 : 0);
+    }
+
+    /**
+     * @class sequence_compressor
+     * @brief 序列格式的压缩过程：按压缩级别选择匹配查找器与划分方式，依次写出序列
+     *
+     * 所有位置按从前到后的顺序恰好加入索引一次，_indexed之前的位置已加入索引。
+     */
+    class sequence_compressor
+    {
+    public:
+        sequence_compressor(const data_packet::byte* begin, const data_packet::byte* end,
+                            const data_packet::lz77_parameters& parameters)
+            : _begin(begin), _end(end), _indexed(begin), _anchor(begin),
+              _setting(LEVELS[std::clamp(parameters.level, data_packet::MIN_LEVEL, data_packet::MAX_LEVEL) - 1]),
+              _output((end - begin) / 2)
+        {
+            using namespace data_packet;
+
+            _output.varint(end - begin);
+            if (_setting.method == strategy::optimal)
+            {
+                _tree = std::make_unique<detail::binary_tree_finder>(begin, end, _setting.depth, _setting.nice_length);
+            }
+            else
+            {
+                _chain = std::make_unique<detail::match_finder>(begin, end, _setting.depth, SEQUENCE_MAX_MATCH, true);
+            }
+
+            // 输入超出BACK_SIZE时，长距离匹配才可能找到窗口之外的重复内容
+            if (parameters.window_log != 0 && static_cast<size_t>(end - begin) > BACK_SIZE)
+            {
+                _far = std::make_unique<detail::long_distance_finder>(begin, end, parameters.window_log);
+            }
+        }
+
+        /**
+         * @brief 压缩全部输入
+         * @return 压缩后数据与长度
+         */
+        std::pair<std::unique_ptr<data_packet::byte[]>, size_t> compress()
+        {
+            if (_setting.method == strategy::optimal)
+            {
+                parse_optimal();
+            }
+            else
+            {
+                parse_greedy();
+            }
+
+            // 剩余数据作为只含字面量的最后一个序列
+            if (_anchor != _end)
+            {
+                _output.sequence(_anchor, _end - _anchor, 0, 0);
+            }
+            return _output.release();
+        }
+
+    private:
+        /**
+         * @struct match
+         * @brief 一个匹配
+         */
+        struct match
+        {
+            size_t offset{0};
+            size_t length{0};
+        };
+
+        /**
+         * @struct node
+         * @brief 最优划分中到达某个位置的最小代价及其最后一步
+         */
+        struct node
+        {
+            size_t price{std::numeric_limits<size_t>::max()};
+            size_t from{0};      ///< 最后一步的起点
+            size_t offset{0};    ///< 最后一步的匹配偏移
+            size_t length{0};    ///< 最后一步的匹配长度，0表示字面量
+            size_t repeat{0};    ///< 到达该位置后可沿用的偏移
+        };
+
+        /**
+         * @brief 将last之前尚未加入索引的位置依次加入
+         * @param last 结束位置
+         */
+        void index_until(const data_packet::byte* last)
+        {
+            for (; _indexed < last; ++_indexed)
+            {
+                if (_chain != nullptr)
+                {
+                    _chain->insert(_indexed);
+                }
+                else
+                {
+                    _tree->insert(_indexed);
+                }
+                if (_far != nullptr)
+                {
+                    _far->insert(_indexed);
+                }
+            }
+        }
+
+        /**
+         * @brief 计算沿用偏移repeat时的匹配长度
+         * @param position 当前位置
+         * @param repeat 可沿用的偏移，0表示没有
+         * @return 匹配长度
+         */
+        [[nodiscard]] size_t repeat_length(const data_packet::byte* position, size_t repeat) const
+        {
+            if (repeat == 0 || static_cast<size_t>(position - _begin) < repeat)
+            {
+                return 0;
+            }
+            const auto limit = static_cast<unsigned int>(std::min<size_t>(data_packet::SEQUENCE_MAX_MATCH,
+                                                                          _end - position));
+            return common_length(position - repeat, position, limit);
+        }
+
+        /**
+         * @brief 计算偏移编码
+         * @param offset 匹配偏移
+         * @param repeat 可沿用的偏移
+         * @return 与可沿用的偏移相同时为0，否则为偏移本身
+         */
+        static size_t offset_code(size_t offset, size_t repeat) { return offset == repeat ? 0 : offset; }
+
+        /**
+         * @brief 匹配相对于按字面量存放节省的字节数
+         * @param candidate 匹配
+         * @return 节省的字节数
+         */
+        [[nodiscard]] std::ptrdiff_t gain(const match& candidate) const
+        {
+            return static_cast<std::ptrdiff_t>(candidate.length) -
+                   static_cast<std::ptrdiff_t>(match_price(offset_code(candidate.offset, _repeat), candidate.length));
+        }
+
+        /**
+         * @brief 查找贪心与惰性匹配中指定位置的最佳匹配，position之前的位置需已加入索引
+         * @param position 当前位置
+         * @return 最佳匹配，长度不足SEQUENCE_MIN_MATCH时表示没有可用的匹配
+         */
+        match best_match(const data_packet::byte* position)
+        {
+            const auto [near_offset, near_length] = _chain->find(position);
+            match best{near_offset, near_length};
+            if (_far != nullptr)
+            {
+                if (const auto [far_offset, far_length] = _far->find(position); far_length > best.length)
+                {
+                    best = {far_offset, far_length};
+                }
+            }
+
+            // 沿用上一个偏移不需要写出偏移，长度相差不超过1时优先使用
+            if (const size_t length = repeat_length(position, _repeat);
+                length >= data_packet::SEQUENCE_MIN_MATCH && length + 1 >= best.length)
+            {
+                best = {_repeat, length};
+            }
+            return best;
+        }
+
+        /**
+         * @brief 写出一个匹配及其之前的字面量，并将匹配覆盖的位置加入索引
+         * @param position 匹配位置
+         * @param chosen 匹配
+         * @param extend 是否向前延伸到上一个序列的结尾，收回匹配之前可以匹配的字面量
+         * @return 匹配结束的位置
+         */
+        const data_packet::byte* emit(const data_packet::byte* position, match chosen, bool extend)
+        {
+            while (extend && position > _anchor && static_cast<size_t>(position - _begin) > chosen.offset &&
+                   position[-1] == position[-1 - static_cast<std::ptrdiff_t>(chosen.offset)])
+            {
+                --position;
+                ++chosen.length;
+            }
+            chosen.length = std::min<size_t>(chosen.length, data_packet::SEQUENCE_MAX_MATCH);
+
+            _output.sequence(_anchor, position - _anchor, offset_code(chosen.offset, _repeat), chosen.length);
+            _repeat = chosen.offset;
+            position += chosen.length;
+            index_until(position);
+            _anchor = position;
+            return position;
+        }
+
+        /**
+         * @brief 贪心与惰性匹配
+         */
+        void parse_greedy()
+        {
+            const data_packet::byte* position = _begin;
+            while (_end - position >= data_packet::SEQUENCE_MIN_MATCH)
+            {
+                auto best = best_match(position);
+                if (best.length < data_packet::SEQUENCE_MIN_MATCH)
+                {
+                    index_until(++position);
+                    continue;
+                }
+
+                // 惰性匹配：下一个位置的匹配多节省超过1字节时，当前位置改为字面量
+                for (unsigned int step = 0;
+                     step < _setting.lazy_steps && _end - (position + 1) >= data_packet::SEQUENCE_MIN_MATCH; ++step)
+                {
+                    index_until(position + 1);
+                    const auto next = best_match(position + 1);
+                    if (next.length < data_packet::SEQUENCE_MIN_MATCH || gain(next) <= gain(best) + 1)
+                    {
+                        break;
+                    }
+                    ++position;
+                    best = next;
+                }
+                position = emit(position, best, true);
+            }
+        }
+
+        /**
+         * @brief 按代价放松一个位置：经由当前位置到达to的代价更小时更新
+         */
+        static void relax(std::vector<node>& nodes, size_t from, size_t to, size_t price, size_t offset, size_t length)
+        {
+            if (price < nodes[to].price)
+            {
+                nodes[to] = {price, from, offset, length, length != 0 ? offset : nodes[from].repeat};
+            }
+        }
+
+        /**
+         * @brief 最优划分：每次处理至多OPTIMAL_BLOCK个位置，求到达末尾的代价最小的序列，
+         * 遇到长度不小于nice_length的匹配时直接采用并在此结束本轮
+         */
+        void parse_optimal()
+        {
+            using namespace data_packet;
+
+            constexpr size_t OPTIMAL_BLOCK = 4096;
+            const size_t nice_length = _setting.nice_length;
+            std::vector<node> nodes(OPTIMAL_BLOCK + nice_length + 1);
+            std::vector<std::pair<unsigned int, unsigned int>> candidates;
+            std::vector<node> steps;
+
+            const byte* position = _begin;
+            while (_end - position >= SEQUENCE_MIN_MATCH)
+            {
+                // 处理的每个位置之后至少还有SEQUENCE_MIN_MATCH个字节
+                const size_t count = std::min<size_t>(OPTIMAL_BLOCK, _end - position - SEQUENCE_MIN_MATCH + 1);
+                std::fill_n(nodes.begin(), count + nice_length + 1, node{});
+                nodes[0].price = 0;
+                nodes[0].repeat = _repeat;
+
+                size_t last = count;
+                match cut;
+                for (size_t k = 0; k < count; ++k)
+                {
+                    const byte* current = position + k;
+                    const size_t price = nodes[k].price;
+                    const size_t repeat = nodes[k].repeat;
+
+                    // 查找候选匹配，同时将当前位置加入索引
+                    candidates.clear();
+                    _tree->find(current, candidates);
+                    match far;
+                    if (_far != nullptr)
+                    {
+                        const auto [far_offset, far_length] = _far->find(current);
+                        far = {far_offset, far_length};
+                        _far->insert(current);
+                    }
+                    _indexed = current + 1;
+                    const match repeated{repeat, repeat_length(current, repeat)};
+
+                    // 足够长的匹配直接采用，优先沿用上一个偏移
+                    match longest = candidates.empty() ? match{} : match{candidates.back().first, candidates.back().second};
+                    if (far.length > longest.length)
+                    {
+                        longest = far;
+                    }
+                    if (repeated.length >= SEQUENCE_MIN_MATCH && repeated.length + 1 >= longest.length)
+                    {
+                        longest = repeated;
+                    }
+                    if (longest.length >= nice_length)
+                    {
+                        last = k;
+                        cut = longest;
+                        break;
+                    }
+
+                    relax(nodes, k, k + 1, price + 1, 0, 0);
+                    for (size_t length = SEQUENCE_MIN_MATCH; length <= repeated.length; ++length)
+                    {
+                        relax(nodes, k, k + length, price + match_price(0, length), repeat, length);
+                    }
+                    size_t shortest = SEQUENCE_MIN_MATCH;
+                    for (const auto& [offset, length] : candidates)
+                    {
+                        const size_t code = offset_code(offset, repeat);
+                        for (; shortest <= length; ++shortest)
+                        {
+                            relax(nodes, k, k + shortest, price + match_price(code, shortest), offset, shortest);
+                        }
+                    }
+                    for (size_t length = SEQUENCE_MIN_MATCH; length <= far.length; ++length)
+                    {
+                        relax(nodes, k, k + length, price + match_price(offset_code(far.offset, repeat), length),
+                              far.offset, length);
+                    }
+                }
+
+                // 从末尾回溯得到代价最小的划分，依次写出其中的匹配
+                steps.clear();
+                for (size_t k = last; k != 0; k = nodes[k].from)
+                {
+                    if (nodes[k].length != 0)
+                    {
+                        steps.push_back(nodes[k]);
+                    }
+                }
+                for (auto step = steps.rbegin(); step != steps.rend(); ++step)
+                {
+                    const byte* start = position + step->from;
+                    _output.sequence(_anchor, start - _anchor, offset_code(step->offset, _repeat), step->length);
+                    _repeat = step->offset;
+                    _anchor = start + step->length;
+                }
+
+                position += last;
+                if (cut.length != 0)
+                {
+                    position = emit(position, cut, false);
+                }
+            }
+        }
+
+        const data_packet::byte* _begin;
+        const data_packet::byte* _end;
+        const data_packet::byte* _indexed;   ///< 第一个尚未加入索引的位置
+        const data_packet::byte* _anchor;    ///< 第一个尚未写出的位置
+        size_t _repeat{0};                   ///< 上一个匹配的偏移
+        level_setting _setting;
+        sequence_writer _output;
+        std::unique_ptr<data_packet::detail::match_finder> _chain;
+        std::unique_ptr<data_packet::detail::binary_tree_finder> _tree;
+        std::unique_ptr<data_packet::detail::long_distance_finder> _far;
+    };
+}
+
+data_packet::detail::match_finder::match_finder(const byte* begin, const byte* end, unsigned int max_chain,
+                                                unsigned int max_length, bool overlap)
+    : _begin(begin), _end(end), _max_chain(std::max(max_chain, 1u)), _max_length(max_length), _overlap(overlap)
+{
+    // 小文件使用较小的哈希表，避免为大量小文件反复初始化整张表
+    const size_t size = end - begin;
+    _hash_bits = std::clamp(static_cast<unsigned int>(std::bit_width(size)) + 1, 8u, 16u);
+    _head.assign(size_t{1} << _hash_bits, 0);
+    _prev.assign(std::min(WINDOW_SIZE, std::bit_ceil(std::max<size_t>(size, 1))), 0);
+    if (size >= 2)
+    {
+        _last2.assign(size_t{1} << 16, 0);
+    }
+}
+
+uint32_t data_packet::detail::match_finder::hash(const byte* position) const
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(position);
+    const uint32_t value = static_cast<uint32_t>(p[0]) << 16 | static_cast<uint32_t>(p[1]) << 8 | p[2];
+    return (value * 2654435761u) >> (32 - _hash_bits);
+}
+
+size_t data_packet::detail::match_finder::position_of(uint32_t stored) const
+{
+    return _base + stored - 1;
+}
+
+void data_packet::detail::match_finder::rebase()
+{
+    // 所有表项整体前移REBASE，早于新基准的位置已远超窗口，直接清空
+    auto shift = [](uint32_t& stored) { stored = stored > REBASE ? stored - REBASE : 0; };
+    std::ranges::for_each(_head, shift);
+    std::ranges::for_each(_prev, shift);
+    std::ranges::for_each(_last2, shift);
+    std::ranges::for_each(_last1, shift);
+    _base += REBASE;
+}
+
+void data_packet::detail::match_finder::insert(const byte* position)
+{
+    const size_t index = position - _begin;
+    if (index - _base >= 2 * static_cast<size_t>(REBASE))
+    {
+        rebase();
+    }
+    const auto stored = static_cast<uint32_t>(index - _base + 1);
+    const size_t remaining = _end - position;
+
+    if (remaining >= 3)
+    {
+        uint32_t& head = _head[hash(position)];
+        _prev[index & (_prev.size() - 1)] = head;
+        head = stored;
+    }
+    if (remaining >= 2)
+    {
+        _last2[pair_index(position)] = stored;
+    }
+    _last1[static_cast<unsigned char>(position[0])] = stored;
+}
+
+std::pair<unsigned int, unsigned int> data_packet::detail::match_finder::find(const byte* position) const
+{
+    const size_t index = position - _begin;
+    const auto max_length = static_cast<unsigned int>(std::min<size_t>(_max_length, _end - position));
+
+    unsigned int best_offset = 0;
+    unsigned int best_length = 0;
+
+    // 计算与候选位置的匹配长度，不允许重叠时长度不超过偏移以保证匹配源不与当前位置重叠
+    auto try_candidate = [&](uint32_t stored)
+    {
+        const size_t candidate = position_of(stored);
+        const size_t offset = index - candidate;
+        if (offset == 0 || offset > BACK_SIZE)
+        {
+            return false;
+        }
+        const auto limit = _overlap ? max_length : static_cast<unsigned int>(std::min<size_t>(max_length, offset));
+        if (limit <= best_length || _begin[candidate + best_length] != position[best_length])
+        {
+            return true;
+        }
+        const unsigned int length = common_length(_begin + candidate, position, limit);
+        if (length > best_length)
+        {
+            best_length = length;
+            best_offset = static_cast<unsigned int>(offset);
+        }
+        return true;
+    };
+
+    if (max_length >= 3)
+    {
+        uint32_t stored = _head[hash(position)];
+        for (unsigned int chain = 0; stored != 0 && chain < _max_chain && best_length < max_length; ++chain)
+        {
+            // 链上位置单调递减，超出窗口后不再继续
+            if (!try_candidate(stored))
+            {
+                break;
+            }
+            const uint32_t previous = _prev[position_of(stored) & (_prev.size() - 1)];
+            if (previous >= stored)
+            {
+                break;
+            }
+            stored = previous;
+        }
+
+        // 周期性数据（如连续相同字符）的匹配长度被偏移限制时，尝试偏移为周期整数倍的更远位置
+        if (best_length == best_offset && best_length > 0 && best_length < max_length)
+        {
+            const size_t period = best_offset;
+            const size_t offset = (max_length + period - 1) / period * period;
+            if (offset <= BACK_SIZE && offset <= index)
+            {
+                try_candidate(static_cast<uint32_t>(index - offset - _base + 1));
+            }
+        }
+    }
+
+    if (best_length < 2 && max_length >= 2 && !_last2.empty())
+    {
+        if (const uint32_t stored = _last2[pair_index(position)])
+        {
+            try_candidate(stored);
+        }
+    }
+
+    if (best_length < 1)
+    {
+        if (const uint32_t stored = _last1[static_cast<unsigned char>(position[0])])
+        {
+            try_candidate(stored);
+        }
+    }
+
+    return {best_offset, best_length};
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::lz77_compress_range(
+    const byte* begin, const byte* end)
+{
+    match_finder finder(begin, end);
+
+    // 输出缓冲区按需扩容，结束时复制为精确大小
+    std::vector<byte> output(std::max<size_t>((end - begin) / 2, 64));
+    size_t output_size = 0;
+    auto emit = [&](unsigned int offset, unsigned int length, byte next)
+    {
+        if (output_size + 4 > output.size())
+        {
+            output.resize(output.size() * 2);
+        }
+        write_token(output.data() + output_size, offset, length, next);
+        output_size += 4;
+    };
+
+    const byte* position = begin;
+    bool padded = false;
+    while (position < end)
+    {
+        auto [offset, length] = finder.find(position);
+
+        // 匹配延伸到数据末尾时，以填充字符结束，不再需要额外的结束单元
+        if (position + length == end)
+        {
+            emit(offset, length, '\0');
+            padded = true;
+            break;
+        }
+
+        emit(offset, length, position[length]);
+        for (const byte* last = position + length + 1; position < last; ++position)
+        {
+            finder.insert(position);
+        }
+    }
+
+    // 最后一个单元的下一个字符是真实数据时，追加一个只含填充字符的单元
+    if (!padded)
+    {
+        emit(0, 0, '\0');
+    }
+
+    auto result = std::make_unique_for_overwrite<byte[]>(output_size);
+    memcpy(result.get(), output.data(), output_size);
+    return std::make_pair(std::move(result), output_size);
+}
+
+data_packet::detail::long_distance_finder::long_distance_finder(const byte* begin, const byte* end,
+                                                                unsigned int window_log)
+    : _begin(begin), _end(end), _window(size_t{1} << window_log)
+{
+    // 每个桶平均对应窗口内2^SAMPLE_LOG * BUCKET_SIZE字节，窗口超过输入时按输入大小分配，最多2^20个桶
+    const size_t span = std::min<size_t>(_window, std::max<size_t>(end - begin, 1));
+    const auto bits = static_cast<unsigned int>(std::bit_width(span));
+    _bucket_log = std::clamp(bits > SAMPLE_LOG + 2 ? bits - SAMPLE_LOG - 2 : 0u, 4u, 20u);
+    _positions.assign(BUCKET_SIZE << _bucket_log, 0);
+    _checks.assign(BUCKET_SIZE << _bucket_log, 0);
+}
+
+uint64_t data_packet::detail::long_distance_finder::hash(const byte* position)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(position);
+    if (position == _hashed)
+    {
+        return _hash;
+    }
+    if (_hashed != nullptr && position == _hashed + 1)
+    {
+        // 左移一位后最早的字节移出哈希
+        _hash = (_hash << 1) + GEAR[p[LONG_MATCH - 1]];
+    }
+    else
+    {
+        _hash = 0;
+        for (unsigned int i = 0; i < LONG_MATCH; ++i)
+        {
+            _hash = (_hash << 1) + GEAR[p[i]];
+        }
+    }
+    _hashed = position;
+    return _hash;
 }
 
-std::tuple<unsigned int, unsigned int, char> data_packet::detail::compression_tuple(const std::vector<char>& data,
-    const std::vector<char>& pattern, const char last)
+void data_packet::detail::long_distance_finder::insert(const byte* position)
 {
-    std::tuple<unsigned int, unsigned int, char> result{0,0,pattern.front()};
+    if (static_cast<size_t>(_end - position) < LONG_MATCH)
+    {
+        return;
+    }
+    const uint64_t value = hash(position);
+    if (!sampled(value))
+    {
+        return;
+    }
 
-    auto next = get_prefix(pattern);
+    // 新位置放在桶的开头，最早的位置被挤出
+    const size_t bucket = (value >> (64 - _bucket_log)) * BUCKET_SIZE;
+    std::copy_backward(_positions.begin() + bucket, _positions.begin() + bucket + BUCKET_SIZE - 1,
+                       _positions.begin() + bucket + BUCKET_SIZE);
+    std::copy_backward(_checks.begin() + bucket, _checks.begin() + bucket + BUCKET_SIZE - 1,
+                       _checks.begin() + bucket + BUCKET_SIZE);
+    _positions[bucket] = static_cast<uint64_t>(position - _begin) + 1;
+    _checks[bucket] = static_cast<uint32_t>(value);
+}
 
-    size_t j = 0;
+std::pair<size_t, size_t> data_packet::detail::long_distance_finder::find(const byte* position)
+{
+    if (static_cast<size_t>(_end - position) < LONG_MATCH)
+    {
+        return {0, 0};
+    }
+    const uint64_t value = hash(position);
+    if (!sampled(value))
+    {
+        return {0, 0};
+    }
 
-    for (size_t i = 0; i < data.size(); i++)
+    const size_t index = position - _begin;
+    const auto limit = static_cast<unsigned int>(std::min<size_t>(SEQUENCE_MAX_MATCH, _end - position));
+    size_t best_offset = 0;
+    size_t best_length = 0;
+    const size_t bucket = (value >> (64 - _bucket_log)) * BUCKET_SIZE;
+    for (size_t i = bucket; i < bucket + BUCKET_SIZE && _positions[i] != 0; ++i)
     {
-        while (j > 0 && j < pattern.size() && data.at(i) != pattern.at(j))
+        const size_t offset = index - (_positions[i] - 1);
+        if (_checks[i] != static_cast<uint32_t>(value) || offset > _window)
         {
-            j = next[j-1];
+            continue;
         }
+        const unsigned int length = common_length(position - offset, position, limit);
+        if (length >= LONG_MATCH && length > best_length)
+        {
+            best_offset = offset;
+            best_length = length;
+        }
+    }
+    return {best_offset, best_length};
+}
+
+data_packet::detail::binary_tree_finder::binary_tree_finder(const byte* begin, const byte* end, unsigned int depth,
+                                                            unsigned int nice_length)
+    : _begin(begin), _end(end), _depth(std::max(depth, 1u)), _nice_length(std::max(nice_length, SEQUENCE_MIN_MATCH))
+{
+    // 与match_finder相同，小文件使用较小的表
+    const size_t size = end - begin;
+    _hash_bits = std::clamp(static_cast<unsigned int>(std::bit_width(size)) + 1, 8u, 16u);
+    _head.assign(size_t{1} << _hash_bits, 0);
+    _tree.assign(2 * std::min(WINDOW_SIZE, std::bit_ceil(std::max<size_t>(size, 1))), 0);
+}
+
+uint32_t data_packet::detail::binary_tree_finder::hash(const byte* position) const
+{
+    uint32_t value;
+    memcpy(&value, position, sizeof(value));
+    return (value * 2654435761u) >> (32 - _hash_bits);
+}
+
+void data_packet::detail::binary_tree_finder::find(const byte* position,
+                                                   std::vector<std::pair<unsigned int, unsigned int>>& matches)
+{
+    update(position, &matches);
+}
 
-        if (j >= pattern.size())
+void data_packet::detail::binary_tree_finder::insert(const byte* position)
+{
+    update(position, nullptr);
+}
+
+void data_packet::detail::binary_tree_finder::update(const byte* position,
+                                                     std::vector<std::pair<unsigned int, unsigned int>>* matches)
+{
+    const size_t remaining = _end - position;
+    if (remaining < SEQUENCE_MIN_MATCH)
+    {
+        return;
+    }
+
+    const size_t index = position - _begin;
+    const size_t mask = _tree.size() / 2 - 1;
+    const auto max_length = static_cast<unsigned int>(std::min<size_t>(_nice_length, remaining));
+
+    // 当前位置成为新的根，原来的树按与当前位置的大小关系拆分为左右子树
+    uint64_t& head = _head[hash(position)];
+    uint64_t current = head;
+    head = index + 1;
+    uint64_t* smaller = &_tree[2 * (index & mask)];
+    uint64_t* larger = smaller + 1;
+    unsigned int smaller_length = 0;
+    unsigned int larger_length = 0;
+    unsigned int best_length = SEQUENCE_MIN_MATCH - 1;
+
+    for (unsigned int depth = _depth; ; --depth)
+    {
+        if (current == 0 || depth == 0 || index - (current - 1) > mask)
         {
-            j = next[j-1];
+            *smaller = 0;
+            *larger = 0;
+            return;
         }
 
-        if (pattern.at(j) == data.at(i))
+        const size_t candidate = current - 1;
+        uint64_t* children = &_tree[2 * (candidate & mask)];
+        const byte* source = _begin + candidate;
+
+        // 子树中所有位置与当前位置的公共前缀不短于两侧已知长度的较小值
+        unsigned int length = std::min(smaller_length, larger_length);
+        length += common_length(source + length, position + length, max_length - length);
+        if (length > best_length)
+        {
+            best_length = length;
+            if (matches != nullptr)
+            {
+                matches->emplace_back(static_cast<unsigned int>(index - candidate), length);
+            }
+        }
+        if (length == max_length)
         {
-            ++j;
+            // 候选与当前位置在比较范围内相同，直接继承其子树
+            *smaller = children[0];
+            *larger = children[1];
+            return;
         }
 
-        if (j >= std::get<1>(result))
+        if (static_cast<unsigned char>(source[length]) < static_cast<unsigned char>(position[length]))
+        {
+            *smaller = current;
+            smaller = children + 1;
+            current = *smaller;
+            smaller_length = length;
+        }
+        else
         {
-            std::get<1>(result) = j;
-            std::get<0>(result) = data.size() - i + j - 1;
-            std::get<2>(result) = j < pattern.size()? pattern.at(j) : last;
+            *larger = current;
+            larger = children;
+            current = *larger;
+            larger_length = length;
         }
     }
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::lz77_sequence_compress_range(
+    const byte* begin, const byte* end, const lz77_parameters& parameters)
+{
+    return sequence_compressor(begin, end, parameters).compress();
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::lz77_sequence_decompress_range(
+    const byte* begin, const byte* end)
+{
+    sequence_reader input(begin, end);
+    const uint64_t size = input.varint();
+    // 每个输入字节至多还原出255字节，原始长度与剩余数据不相称时视为损坏，避免按错误的长度分配内存
+    if (size / 256 > input.remaining())
+    {
+        throw std::runtime_error("lz77 data is corrupted");
+    }
 
-    return result;
-}
\ No newline at end of file
+    auto result = std::make_unique_for_overwrite<byte[]>(size + WILD_COPY_SLACK);
+    byte* const output = result.get();
+    size_t produced = 0;
+    size_t repeat = 0;
+    while (produced < size)
+    {
+        const uint8_t token = input.next();
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15)
+        {
+            literal_length += input.extension(size - produced);
+        }
+        if (literal_length > size - produced || literal_length > input.remaining())
+        {
+            throw std::runtime_error("lz77 data is corrupted");
+        }
+        std::copy_n(input.position(), literal_length, output + produced);
+        input.skip(literal_length);
+        produced += literal_length;
+        if (produced == size)
+        {
+            break;
+        }
+
+        if (const uint64_t offset = input.varint())
+        {
+            repeat = offset;
+        }
+        size_t match_length = (token & 0x0f) + SEQUENCE_MIN_MATCH;
+        if (match_length == 15 + SEQUENCE_MIN_MATCH)
+        {
+            match_length += input.extension(size - produced);
+        }
+        if (repeat == 0 || repeat > produced || match_length > size - produced)
+        {
+            throw std::runtime_error("lz77 data is corrupted");
+        }
+
+        copy_match(output + produced, repeat, match_length);
+        produced += match_length;
+    }
+
+    if (input.remaining() != 0)
+    {
+        throw std::runtime_error("lz77 data is corrupted");
+    }
+    return {std::move(result), size};
+}
+
+size_t data_packet::detail::lz77_original_size(const byte* begin, const byte* end)
+{
+    const size_t size = end - begin;
+    if (size == 0 || size % 4 != 0)
+    {
+        throw std::runtime_error("lz77 data is incomplete");
+    }
+
+    // 每个单元还原出匹配长度加一个字符，最后一个单元的字符为填充字符
+    size_t original_size = size / 4 - 1;
+    for (const byte* token = begin; token != end; token += 4)
+    {
+        original_size += static_cast<unsigned char>(token[2]);
+    }
+    return original_size;
+}
+
+std::pair<std::unique_ptr<data_packet::byte[]>, size_t> data_packet::detail::lz77_decompress_range(
+    const byte* begin, const byte* end, size_t original_size)
+{
+    const size_t size = end - begin;
+    if (size == 0 || size % 4 != 0)
+    {
+        throw std::runtime_error("lz77 data is incomplete");
+    }
+    // 每个单元至多还原出256字节，原始长度与数据不相称时视为损坏，避免按错误的长度分配内存
+    if (original_size / 256 >= size / 4)
+    {
+        throw std::runtime_error("lz77 data is corrupted");
+    }
+
+    // 最后一个单元的填充字符写入末尾的余量中
+    auto result = std::make_unique_for_overwrite<byte[]>(original_size + WILD_COPY_SLACK);
+    byte* const output = result.get();
+    size_t produced = 0;
+    for (const byte* token = begin; token != end; token += 4)
+    {
+        const size_t offset = make_word({token[0], token[1]});
+        const size_t length = static_cast<unsigned char>(token[2]);
+        if (length > original_size - produced || (length != 0 && (offset == 0 || offset > produced)))
+        {
+            throw std::runtime_error("lz77 data is corrupted");
+        }
+        copy_match(output + produced, offset, length);
+        produced += length;
+
+        // 除最后一个单元外，下一个字符都属于原始数据
+        if (token + 4 == end)
+        {
+            break;
+        }
+        if (produced == original_size)
+        {
+            throw std::runtime_error("lz77 data is corrupted");
+        }
+        output[produced++] = token[3];
+    }
+
+    if (produced != original_size)
+    {
+        throw std::runtime_error("lz77 data is corrupted");
+    }
+    return {std::move(result), original_size};
+}
@@ -0,0 +1,280 @@
+//
+// Created by hyh on 2026/1/25.
+//
+
+#include "../../include/dedup/chunk_store.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <unistd.h>
+
+#include "../../include/utils/crc_32.h"
+
+namespace
+{
+    constexpr char CHUNK_MAGIC[4] = {'P', 'K', 'C', 'H'};         ///< 块文件的标记
+    constexpr size_t CHUNK_HEADER_SIZE = 4 + 1 + 1 + 4 + 4;       ///< 块文件头部大小
+    constexpr char KDF_FILE_NAME[] = "kdf";                       ///< 根目录中保存密钥派生参数的文件
+
+    /**
+     * @brief 生成区分进程与线程的临时文件名后缀
+     * @return 后缀
+     */
+    std::string temporary_suffix()
+    {
+        return ".tmp." + std::to_string(getpid()) + "." +
+               std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    }
+
+    /**
+     * @brief 按大端字节序写入双字
+     * @param out 输出位置，写入后后移
+     * @param value 双字
+     */
+    void put_dword(data_packet::byte*& out, data_packet::dword value)
+    {
+        auto [b0, b1, b2, b3] = data_packet::to_bytes(value);
+        out[0] = b0;
+        out[1] = b1;
+        out[2] = b2;
+        out[3] = b3;
+        out += 4;
+    }
+
+    /**
+     * @brief 按大端字节序读取双字
+     * @param in 输入位置，读取后后移
+     * @return 双字
+     */
+    data_packet::dword get_dword(const data_packet::byte*& in)
+    {
+        const auto value = data_packet::make_dword({in[0], in[1], in[2], in[3]});
+        in += 4;
+        return value;
+    }
+
+    /**
+     * @brief 块标识转换为十六进制字符串
+     * @param id 块标识
+     * @return 64个小写十六进制字符
+     */
+    std::string to_hex(const data_packet::chunk_id& id)
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::string hex(id.size() * 2, '0');
+        for (size_t i = 0; i < id.size(); ++i)
+        {
+            hex[2 * i] = digits[id[i] >> 4];
+            hex[2 * i + 1] = digits[id[i] & 0xf];
+        }
+        return hex;
+    }
+}
+
+std::vector<data_packet::byte> data_packet::chunk_reference::serialize(const std::vector<chunk_reference>& references)
+{
+    std::vector<byte> buffer(references.size() * SIZE);
+    byte* out = buffer.data();
+    for (const auto& [id, size] : references)
+    {
+        std::memcpy(out, id.data(), id.size());
+        out += id.size();
+        put_dword(out, size);
+    }
+    return buffer;
+}
+
+std::vector<data_packet::chunk_reference> data_packet::chunk_reference::parse(const byte* in, size_t size,
+                                                                              qword original_size)
+{
+    if (size % SIZE != 0)
+    {
+        throw std::runtime_error("chunk reference list is incomplete");
+    }
+
+    std::vector<chunk_reference> references(size / SIZE);
+    qword total = 0;
+    for (auto& [id, chunk_size] : references)
+    {
+        std::memcpy(id.data(), in, id.size());
+        in += id.size();
+        chunk_size = get_dword(in);
+        total += chunk_size;
+    }
+    if (total != original_size)
+    {
+        throw std::runtime_error("chunk reference list does not match the file size");
+    }
+    return references;
+}
+
+data_packet::chunk_store::chunk_store(std::filesystem::path root) : _root(std::move(root))
+{
+    std::filesystem::create_directories(_root);
+}
+
+data_packet::chunk_id data_packet::chunk_store::make_id(const byte* data, size_t size, std::string_view key)
+{
+    chunk_id id{};
+    const auto* in = reinterpret_cast<const unsigned char*>(data);
+    bool ok;
+    if (key.empty())
+    {
+        ok = EVP_Digest(in, size, id.data(), nullptr, EVP_sha256(), nullptr) == 1;
+    }
+    else
+    {
+        ok = HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), in, size, id.data(), nullptr) != nullptr;
+    }
+
+    if (!ok)
+    {
+        throw std::runtime_error("Fail to hash a chunk");
+    }
+    return id;
+}
+
+std::filesystem::path data_packet::chunk_store::path_of(const chunk_id& id) const
+{
+    const auto hex = to_hex(id);
+    return _root / hex.substr(0, 2) / hex;
+}
+
+bool data_packet::chunk_store::contains(const chunk_id& id) const
+{
+    return std::filesystem::exists(path_of(id));
+}
+
+void data_packet::chunk_store::put(const chunk_id& id, local_file_header::compression_method compression,
+                                   local_file_header::encryption_method encryption, dword original_size,
+                                   const byte* data, size_t size) const
+{
+    namespace fs = std::filesystem;
+
+    const auto path = path_of(id);
+    if (fs::exists(path))
+    {
+        return;
+    }
+    fs::create_directories(path.parent_path());
+
+    byte header[CHUNK_HEADER_SIZE];
+    byte* out = header;
+    std::memcpy(out, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    out += sizeof(CHUNK_MAGIC);
+    *out++ = static_cast<byte>(compression);
+    *out++ = static_cast<byte>(encryption);
+    put_dword(out, original_size);
+    put_dword(out, CRC_calculate(reinterpret_cast<const uint8_t*>(data), size));
+
+    // 写入临时文件后重命名，临时文件名区分进程与线程
+    auto temporary = path;
+    temporary += temporary_suffix();
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(header, sizeof(header));
+        file.write(data, static_cast<std::streamsize>(size));
+        if (!file)
+        {
+            file.close();
+            fs::remove(temporary);
+            throw std::runtime_error("Could not write chunk " + path.string());
+        }
+    }
+    fs::rename(temporary, path);
+}
+
+std::optional<std::string> data_packet::chunk_store::load_key_derivation() const
+{
+    const auto path = _root / KDF_FILE_NAME;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        if (std::filesystem::exists(path))
+        {
+            throw std::runtime_error("Could not read " + path.string());
+        }
+        return std::nullopt;
+    }
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+std::string data_packet::chunk_store::save_key_derivation(std::string_view parameters) const
+{
+    namespace fs = std::filesystem;
+
+    const auto path = _root / KDF_FILE_NAME;
+    auto temporary = path;
+    temporary += temporary_suffix();
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(parameters.data(), static_cast<std::streamsize>(parameters.size()));
+        if (!file)
+        {
+            file.close();
+            fs::remove(temporary);
+            throw std::runtime_error("Could not write " + path.string());
+        }
+    }
+
+    // 硬链接在目标已存在时失败而不会覆盖，此时使用先发布的参数
+    const bool published = link(temporary.c_str(), path.c_str()) == 0;
+    const int error = errno;
+    fs::remove(temporary);
+    if (published)
+    {
+        return std::string(parameters);
+    }
+    if (error != EEXIST)
+    {
+        throw std::runtime_error("Could not write " + path.string() + ": " + std::strerror(error));
+    }
+    return load_key_derivation().value();
+}
+
+data_packet::stored_chunk data_packet::chunk_store::get(const chunk_id& id) const
+{
+    const auto path = path_of(id);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("chunk is missing from the chunk store: " + path.string());
+    }
+    const auto file_size = static_cast<size_t>(file.tellg());
+    if (file_size < CHUNK_HEADER_SIZE)
+    {
+        throw std::runtime_error("chunk is incomplete: " + path.string());
+    }
+    file.seekg(0);
+
+    byte header[CHUNK_HEADER_SIZE];
+    file.read(header, sizeof(header));
+    if (std::memcmp(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0)
+    {
+        throw std::runtime_error("chunk is not valid: " + path.string());
+    }
+
+    stored_chunk chunk;
+    const byte* in = header + sizeof(CHUNK_MAGIC);
+    chunk.compression = static_cast<local_file_header::compression_method>(*in++);
+    chunk.encryption = static_cast<local_file_header::encryption_method>(*in++);
+    chunk.original_size = get_dword(in);
+    const dword crc_32 = get_dword(in);
+
+    chunk.size = file_size - CHUNK_HEADER_SIZE;
+    chunk.data = std::make_unique_for_overwrite<byte[]>(chunk.size);
+    file.read(chunk.data.get(), static_cast<std::streamsize>(chunk.size));
+    if (static_cast<size_t>(file.gcount()) != chunk.size ||
+        !CRC_verify(crc_32, reinterpret_cast<const uint8_t*>(chunk.data.get()), chunk.size))
+    {
+        throw std::runtime_error("chunk is corrupted: " + path.string());
+    }
+    return chunk;
+}
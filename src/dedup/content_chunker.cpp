@@ -0,0 +1,91 @@
+//
+// Created by hyh on 2026/1/25.
+//
+
+#include "../../include/dedup/content_chunker.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * @brief 生成Gear哈希使用的256个随机数，使用固定种子的splitmix64，保证不同版本切分结果一致
+     * @return 随机数表
+     */
+    constexpr std::array<uint64_t, 256> make_gear_table()
+    {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        for (auto& value : table)
+        {
+            state += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            value = z ^ (z >> 31);
+        }
+        return table;
+    }
+
+    constexpr auto GEAR = make_gear_table();
+
+    /**
+     * @brief 生成最高bits位为1的掩码。Gear哈希的高位受最近64字节影响，低位只受最近几个字节影响，因此使用高位判断边界
+     * @param bits 置位数
+     * @return 掩码
+     */
+    constexpr uint64_t top_bits(unsigned int bits)
+    {
+        return bits == 0 ? 0 : ~uint64_t{0} << (64 - bits);
+    }
+}
+
+data_packet::content_chunker::content_chunker(size_t min_size, size_t average_size, size_t max_size)
+    : _min_size(min_size), _average_size(average_size), _max_size(max_size)
+{
+    if (min_size < 64 || min_size >= average_size || average_size >= max_size || !std::has_single_bit(average_size))
+    {
+        throw std::invalid_argument("[content_chunker] chunk sizes are not valid");
+    }
+
+    // 平均大小为2^bits时，掩码置位bits位的边界概率为1/average_size，前后各调整2位实现归一化
+    const auto bits = static_cast<unsigned int>(std::countr_zero(average_size));
+    _mask_small = top_bits(std::min(bits + 2, 64u));
+    _mask_large = top_bits(bits > 2 ? bits - 2 : 0);
+}
+
+size_t data_packet::content_chunker::cut(const byte* data, size_t size) const
+{
+    if (size <= _min_size)
+    {
+        return size;
+    }
+    size = std::min(size, _max_size);
+    const size_t normal = std::min(size, _average_size);
+
+    const auto* in = reinterpret_cast<const uint8_t*>(data);
+    uint64_t hash = 0;
+
+    // 最小块大小之内不可能出现边界，直接跳过
+    size_t i = _min_size;
+    for (; i < normal; ++i)
+    {
+        hash = (hash << 1) + GEAR[in[i]];
+        if ((hash & _mask_small) == 0)
+        {
+            return i + 1;
+        }
+    }
+    for (; i < size; ++i)
+    {
+        hash = (hash << 1) + GEAR[in[i]];
+        if ((hash & _mask_large) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return size;
+}
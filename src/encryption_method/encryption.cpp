@@ -1,4 +1,10 @@
 #include "../../include/encryption_method/encryption.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <openssl/hmac.h>
+
 std::string encryption::pkcs7_pad(const std::string& data, size_t block_size)
 {
     size_t pad_len = block_size - (data.size() % block_size);
@@ -25,138 +31,591 @@ bool encryption::generate_iv(unsigned char* iv) {
     if (!iv) return false;
     return RAND_bytes(iv, AES_BLOCK_SIZE) == 1;
 }
-bool encryption::aes_encrypt(const std::string& plaintext, const std::string& password, std::string& ciphertext) 
+bool encryption::aes_encrypt(const std::string& plaintext, const std::string& password, std::string& ciphertext)
 {
-    ERR_clear_error(); // 操作前清空错误栈，避免残留错误干扰
-    // 1. 生成密钥和IV
-    unsigned char key[AES_KEY_SIZE_256] = {0};
-    unsigned char iv[AES_BLOCK_SIZE] = {0};
-    if (!generate_aes_key(password, key) || !generate_iv(iv)) {
-        std::cerr << "Failed to generate key/iv" << std::endl;
+    ciphertext.resize(encrypted_size(plaintext.size()));
+    try
+    {
+        encrypt_to({plaintext.data(), plaintext.size()}, password, ciphertext.data());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        ciphertext.clear();
         return false;
     }
+    return true;
+}
 
-    // 2. 初始化EVP加密上下文
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        std::cerr << "Failed to create EVP context" << std::endl;
+bool encryption::aes_decrypt(const std::string& ciphertext, const std::string& password, std::string& plaintext)
+{
+    if (ciphertext.size() < encrypted_size(0))
+    {
+        std::cerr << "Invalid ciphertext length" << std::endl;
         return false;
     }
 
-    // 3. 初始化AES-256-CBC加密
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv) != 1) {
-        std::cerr << "Failed to init encrypt context" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
+    plaintext.resize(ciphertext.size() - AES_BLOCK_SIZE);
+    try
+    {
+        plaintext.resize(decrypt_to({ciphertext.data(), ciphertext.size()}, password, plaintext.data()));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        plaintext.clear();
         return false;
     }
+    return true;
+}
 
-    // 4. 明文填充
-    std::string padded_plaintext = pkcs7_pad(plaintext, AES_BLOCK_SIZE);
-
-    // 5. 执行加密
-    ciphertext.clear();
-    ciphertext.resize(AES_BLOCK_SIZE + padded_plaintext.size() + AES_BLOCK_SIZE); // 预留IV+加密缓冲区
-    memcpy(&ciphertext[0], iv, AES_BLOCK_SIZE); // IV放在密文开头
-
-    int out_len = 0;
-    int total_out_len = 0;
-    // 加密数据
-    if (EVP_EncryptUpdate(ctx, 
-                          reinterpret_cast<unsigned char*>(&ciphertext[AES_BLOCK_SIZE]), 
-                          &out_len, 
-                          reinterpret_cast<const unsigned char*>(padded_plaintext.c_str()), 
-                          padded_plaintext.size()) != 1) {
-        std::cerr << "Failed to encrypt data" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
-        return false;
+namespace
+{
+    /**
+     * @brief 抛出带有OpenSSL错误信息的异常
+     * @param what 失败的操作
+     */
+    [[noreturn]] void throw_openssl_error(const std::string& what)
+    {
+        char buffer[256] = {0};
+        ERR_error_string_n(ERR_get_error(), buffer, sizeof(buffer));
+        ERR_clear_error();
+        throw std::runtime_error(what + ": " + buffer);
     }
-    total_out_len += out_len;
 
-    // 完成加密（处理最后一块）
-    if (EVP_EncryptFinal_ex(ctx, 
-                            reinterpret_cast<unsigned char*>(&ciphertext[AES_BLOCK_SIZE + total_out_len]), 
-                            &out_len) != 1) {
-        std::cerr << "Failed to finalize encryption" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
-        return false;
+    /**
+     * @struct thread_context
+     * @brief 线程缓存的EVP上下文，线程结束时释放
+     */
+    struct thread_context
+    {
+        EVP_CIPHER_CTX* context{nullptr};
+        bool in_use{false};
+
+        ~thread_context() { EVP_CIPHER_CTX_free(context); }
+    };
+
+    thread_local thread_context cached_context;
+
+    /**
+     * @brief 以CIPHER_CHUNK_SIZE为单位执行EVP_CipherUpdate，避免单次调用的长度超出int
+     * @param context 已初始化的上下文
+     * @param in 输入
+     * @param out 输出位置
+     * @return 写入的字节数
+     */
+    size_t cipher_update(EVP_CIPHER_CTX* context, std::span<const data_packet::byte> in, data_packet::byte* out)
+    {
+        size_t written = 0;
+        for (size_t offset = 0; offset < in.size(); offset += encryption::CIPHER_CHUNK_SIZE)
+        {
+            const size_t length = std::min(encryption::CIPHER_CHUNK_SIZE, in.size() - offset);
+            int out_length = 0;
+            if (EVP_CipherUpdate(context, reinterpret_cast<unsigned char*>(out + written), &out_length,
+                                 reinterpret_cast<const unsigned char*>(in.data() + offset),
+                                 static_cast<int>(length)) != 1)
+            {
+                throw_openssl_error("Failed to process data");
+            }
+            written += static_cast<size_t>(out_length);
+        }
+        return written;
     }
-    total_out_len += out_len;
+}
 
-    // 调整密文长度
-    ciphertext.resize(AES_BLOCK_SIZE + total_out_len);
-    // 清理上下文
-    EVP_CIPHER_CTX_free(ctx);
-    CHECK_OPENSSL_ERR(EVP_Encrypt);
-    return true;
+encryption::cipher_context::cipher_context()
+{
+    if (!cached_context.in_use)
+    {
+        if (cached_context.context == nullptr)
+        {
+            cached_context.context = EVP_CIPHER_CTX_new();
+        }
+        if (cached_context.context != nullptr)
+        {
+            cached_context.in_use = true;
+            _context = cached_context.context;
+            _borrowed = true;
+            return;
+        }
+    }
+
+    _context = EVP_CIPHER_CTX_new();
+    if (_context == nullptr)
+    {
+        throw std::runtime_error("Failed to create EVP context");
+    }
 }
 
-bool encryption::aes_decrypt(const std::string& ciphertext, const std::string& password, std::string& plaintext) {
-    ERR_clear_error(); // 操作前清空错误栈，避免残留错误干扰
-    // 1. 校验密文长度
-    if (ciphertext.size() < AES_BLOCK_SIZE) {
-        std::cerr << "Invalid ciphertext length" << std::endl;
-        return false;
+encryption::cipher_context::~cipher_context()
+{
+    if (_borrowed)
+    {
+        // 清除密钥等状态后归还
+        EVP_CIPHER_CTX_reset(_context);
+        cached_context.in_use = false;
     }
+    else
+    {
+        EVP_CIPHER_CTX_free(_context);
+    }
+}
 
-    // 2. 提取IV并生成密钥
-    unsigned char iv[AES_BLOCK_SIZE] = {0};
-    memcpy(iv, &ciphertext[0], AES_BLOCK_SIZE);
+encryption::cbc_encryptor::cbc_encryptor(const aes_key& key)
+{
+    ERR_clear_error();
+    if (!generate_iv(_iv))
+    {
+        throw_openssl_error("Failed to generate iv");
+    }
 
-    unsigned char key[AES_KEY_SIZE_256] = {0};
-    if (!generate_aes_key(password, key)) {
-        std::cerr << "Failed to generate key" << std::endl;
-        return false;
+    // 填充由finish自行写出，关闭EVP的填充
+    const bool initialized = EVP_EncryptInit_ex(_context.get(), EVP_aes_256_cbc(), nullptr, key.data(), _iv) == 1 &&
+                             EVP_CIPHER_CTX_set_padding(_context.get(), 0) == 1;
+    if (!initialized)
+    {
+        throw_openssl_error("Failed to init encrypt context");
     }
+}
 
-    // 3. 初始化EVP解密上下文
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        std::cerr << "Failed to create EVP context" << std::endl;
-        return false;
+size_t encryption::cbc_encryptor::update(std::span<const data_packet::byte> in, data_packet::byte* out)
+{
+    _size += in.size();
+    return cipher_update(_context.get(), in, out);
+}
+
+size_t encryption::cbc_encryptor::finish(data_packet::byte* out)
+{
+    // PKCS7填充补齐最后一块，再追加一个全为16的块，与旧版本手动填充后再由EVP填充的结果相同
+    data_packet::byte padding[2 * AES_BLOCK_SIZE];
+    const size_t pad_length = AES_BLOCK_SIZE - _size % AES_BLOCK_SIZE;
+    std::memset(padding, static_cast<int>(pad_length), pad_length);
+    std::memset(padding + pad_length, AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+
+    size_t written = cipher_update(_context.get(), {padding, pad_length + AES_BLOCK_SIZE}, out);
+    int out_length = 0;
+    if (EVP_EncryptFinal_ex(_context.get(), reinterpret_cast<unsigned char*>(out + written), &out_length) != 1)
+    {
+        throw_openssl_error("Failed to finalize encryption");
     }
+    return written + static_cast<size_t>(out_length);
+}
 
-    // 4. 初始化AES-256-CBC解密
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv) != 1) {
-        std::cerr << "Failed to init decrypt context" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
-        return false;
+encryption::cbc_decryptor::cbc_decryptor(const aes_key& key,
+                                         std::span<const data_packet::byte, AES_BLOCK_SIZE> iv)
+{
+    ERR_clear_error();
+    const bool initialized = EVP_DecryptInit_ex(_context.get(), EVP_aes_256_cbc(), nullptr, key.data(),
+                                                reinterpret_cast<const unsigned char*>(iv.data())) == 1 &&
+                             EVP_CIPHER_CTX_set_padding(_context.get(), 0) == 1;
+    if (!initialized)
+    {
+        throw_openssl_error("Failed to init decrypt context");
     }
+}
 
-    // 5. 执行解密
-    plaintext.clear();
-    plaintext.resize(ciphertext.size() - AES_BLOCK_SIZE + AES_BLOCK_SIZE); // 预留解密缓冲区
-
-    int out_len = 0;
-    int total_out_len = 0;
-    // 解密数据
-    if (EVP_DecryptUpdate(ctx, 
-                          reinterpret_cast<unsigned char*>(&plaintext[0]), 
-                          &out_len, 
-                          reinterpret_cast<const unsigned char*>(&ciphertext[AES_BLOCK_SIZE]), 
-                          ciphertext.size() - AES_BLOCK_SIZE) != 1) {
-        std::cerr << "Failed to decrypt data" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
-        return false;
+size_t encryption::cbc_decryptor::update(std::span<const data_packet::byte> in, data_packet::byte* out)
+{
+    if (_tail_size + in.size() <= TAIL_SIZE)
+    {
+        std::memcpy(_tail + _tail_size, in.data(), in.size());
+        _tail_size += in.size();
+        return 0;
     }
-    total_out_len += out_len;
 
-    // 完成解密（处理最后一块）
-    if (EVP_DecryptFinal_ex(ctx, 
-                            reinterpret_cast<unsigned char*>(&plaintext[total_out_len]), 
-                            &out_len) != 1) {
-        std::cerr << "Failed to finalize decryption (wrong password or corrupted data)" << std::endl;
-        EVP_CIPHER_CTX_free(ctx);
-        return false;
+    // 保留的末尾与新数据中除最后TAIL_SIZE字节外的部分可以解密
+    const size_t release = _tail_size + in.size() - TAIL_SIZE;
+    const size_t from_tail = std::min(release, _tail_size);
+    size_t written = cipher_update(_context.get(), {_tail, from_tail}, out);
+    std::memmove(_tail, _tail + from_tail, _tail_size - from_tail);
+    _tail_size -= from_tail;
+
+    const size_t from_in = release - from_tail;
+    written += cipher_update(_context.get(), in.first(from_in), out + written);
+    std::memcpy(_tail + _tail_size, in.data() + from_in, in.size() - from_in);
+    _tail_size += in.size() - from_in;
+    return written;
+}
+
+size_t encryption::cbc_decryptor::finish(data_packet::byte* out)
+{
+    if (_tail_size != TAIL_SIZE)
+    {
+        throw std::runtime_error("Invalid ciphertext length");
     }
-    total_out_len += out_len;
 
-    // 调整明文长度并去除填充
-    plaintext.resize(total_out_len);
-    plaintext = pkcs7_unpad(plaintext);
+    data_packet::byte plain[TAIL_SIZE];
+    const size_t written = cipher_update(_context.get(), {_tail, TAIL_SIZE}, plain);
+    int out_length = 0;
+    // 关闭填充时，密文长度不是16的整数倍会在这里失败
+    if (written != TAIL_SIZE ||
+        EVP_DecryptFinal_ex(_context.get(), reinterpret_cast<unsigned char*>(plain), &out_length) != 1)
+    {
+        ERR_clear_error();
+        throw std::runtime_error("Invalid ciphertext length");
+    }
 
-    // 清理上下文
-    EVP_CIPHER_CTX_free(ctx);
-    CHECK_OPENSSL_ERR(EVP_Decrypt);
-    return true;
+    // 最后一块全为16，倒数第二块以PKCS7填充结尾
+    const auto pad_length = static_cast<unsigned char>(plain[AES_BLOCK_SIZE - 1]);
+    bool valid = pad_length >= 1 && pad_length <= AES_BLOCK_SIZE;
+    for (size_t i = AES_BLOCK_SIZE; i < TAIL_SIZE; ++i)
+    {
+        valid &= static_cast<unsigned char>(plain[i]) == AES_BLOCK_SIZE;
+    }
+    for (size_t i = 0; valid && i < pad_length; ++i)
+    {
+        valid &= static_cast<unsigned char>(plain[AES_BLOCK_SIZE - 1 - i]) == pad_length;
+    }
+    if (!valid)
+    {
+        throw std::runtime_error("Failed to finalize decryption (wrong password or corrupted data)");
+    }
+
+    const size_t length = AES_BLOCK_SIZE - pad_length;
+    std::memcpy(out, plain, length);
+    return length;
+}
+
+size_t encryption::encrypt_to(std::span<const data_packet::byte> plaintext, const aes_key& key,
+                              data_packet::byte* out)
+{
+    cbc_encryptor encryptor(key);
+    std::memcpy(out, encryptor.iv().data(), AES_BLOCK_SIZE);
+    size_t written = AES_BLOCK_SIZE;
+    written += encryptor.update(plaintext, out + written);
+    written += encryptor.finish(out + written);
+    return written;
+}
+
+size_t encryption::decrypt_to(std::span<const data_packet::byte> ciphertext, const aes_key& key,
+                              data_packet::byte* out)
+{
+    if (ciphertext.size() < encrypted_size(0))
+    {
+        throw std::runtime_error("Invalid ciphertext length");
+    }
+
+    cbc_decryptor decryptor(key, ciphertext.first<AES_BLOCK_SIZE>());
+    size_t written = decryptor.update(ciphertext.subspan(AES_BLOCK_SIZE), out);
+    written += decryptor.finish(out + written);
+    return written;
 }
 
+namespace
+{
+    /**
+     * @struct gcm_layout
+     * @brief AES-256-GCM分块加密数据的布局
+     */
+    struct gcm_layout
+    {
+        size_t chunk_size{0};       ///< 明文的块大小
+        size_t chunk_count{0};      ///< 块数量
+        size_t plaintext_size{0};   ///< 明文大小
+
+        /**
+         * @brief 第index块的明文大小
+         * @param index 块下标
+         * @return 明文大小
+         */
+        [[nodiscard]] size_t length_of(size_t index) const
+        {
+            return std::min(chunk_size, plaintext_size - index * chunk_size);
+        }
+
+        /**
+         * @brief 第index块在加密数据中的起始位置
+         * @param index 块下标
+         * @return 相对加密数据开头的偏移
+         */
+        [[nodiscard]] size_t offset_of(size_t index) const
+        {
+            return encryption::GCM_HEADER_SIZE + index * (chunk_size + encryption::GCM_NONCE_SIZE + encryption::GCM_TAG_SIZE);
+        }
+    };
+
+    /**
+     * @brief 解析AES-256-GCM分块加密数据的布局
+     * @param ciphertext 加密后的数据
+     * @return 布局
+     * @throws std::runtime_error 数据不完整或块大小不合法时抛出
+     */
+    gcm_layout parse_gcm_layout(std::span<const data_packet::byte> ciphertext)
+    {
+        constexpr size_t overhead = encryption::GCM_NONCE_SIZE + encryption::GCM_TAG_SIZE;
+        if (ciphertext.size() < encryption::GCM_HEADER_SIZE + overhead)
+        {
+            throw std::runtime_error("Invalid ciphertext length");
+        }
+
+        gcm_layout layout;
+        layout.chunk_size = data_packet::make_dword({ciphertext[0], ciphertext[1], ciphertext[2], ciphertext[3]});
+        if (layout.chunk_size == 0 || layout.chunk_size > encryption::GCM_MAX_CHUNK_SIZE)
+        {
+            throw std::runtime_error("Invalid ciphertext chunk size");
+        }
+
+        // 除最后一块外各块都是完整的，最后一块的明文为1到chunk_size字节（只有一块时可以为空）
+        const size_t body = ciphertext.size() - encryption::GCM_HEADER_SIZE;
+        const size_t stride = layout.chunk_size + overhead;
+        layout.chunk_count = (body + stride - 1) / stride;
+        const size_t last = body - (layout.chunk_count - 1) * stride;
+        if (last < overhead || (last == overhead && layout.chunk_count > 1))
+        {
+            throw std::runtime_error("Invalid ciphertext length");
+        }
+        layout.plaintext_size = body - layout.chunk_count * overhead;
+        return layout;
+    }
+
+    /**
+     * @brief 计算第index块的附加认证数据：块序号(8字节，大端) + 是否最后一块(1字节)
+     * @param index 块下标
+     * @param last 是否最后一块
+     * @param aad 输出位置
+     */
+    void gcm_associated_data(size_t index, bool last, unsigned char (&aad)[9])
+    {
+        for (size_t i = 0; i < 8; ++i)
+        {
+            aad[i] = static_cast<unsigned char>(static_cast<uint64_t>(index) >> (56 - 8 * i));
+        }
+        aad[8] = last ? 1 : 0;
+    }
+
+    /**
+     * @brief 初始化一个块的AES-256-GCM加密或解密，并写入附加认证数据
+     * @param context 上下文
+     * @param key 密钥
+     * @param nonce 块的nonce
+     * @param index 块下标
+     * @param last 是否最后一块
+     * @param encrypt true为加密，false为解密
+     */
+    void gcm_init(EVP_CIPHER_CTX* context, const unsigned char* key, const unsigned char* nonce, size_t index,
+                  bool last, bool encrypt)
+    {
+        unsigned char aad[9];
+        gcm_associated_data(index, last, aad);
+        int out_length = 0;
+        if (EVP_CipherInit_ex(context, EVP_aes_256_gcm(), nullptr, nullptr, nullptr, encrypt ? 1 : 0) != 1 ||
+            EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_SET_IVLEN, encryption::GCM_NONCE_SIZE, nullptr) != 1 ||
+            EVP_CipherInit_ex(context, nullptr, nullptr, key, nonce, encrypt ? 1 : 0) != 1 ||
+            EVP_CipherUpdate(context, nullptr, &out_length, aad, sizeof(aad)) != 1)
+        {
+            throw_openssl_error("Failed to init GCM context");
+        }
+    }
+}
+
+size_t encryption::gcm_plaintext_size(std::span<const data_packet::byte> ciphertext)
+{
+    return parse_gcm_layout(ciphertext).plaintext_size;
+}
+
+size_t encryption::gcm_encrypt_to(std::span<const data_packet::byte> plaintext, const aes_key& key,
+                                  data_packet::byte* out, unsigned int thread_number, size_t chunk_size)
+{
+    if (chunk_size == 0 || chunk_size > GCM_MAX_CHUNK_SIZE)
+    {
+        throw std::invalid_argument("GCM chunk size is out of range.");
+    }
+
+    ERR_clear_error();
+    const size_t size = gcm_encrypted_size(plaintext.size(), chunk_size);
+    std::tie(out[0], out[1], out[2], out[3]) = data_packet::to_bytes(static_cast<data_packet::dword>(chunk_size));
+
+    const gcm_layout layout{chunk_size, plaintext.empty() ? 1 : (plaintext.size() + chunk_size - 1) / chunk_size,
+                            plaintext.size()};
+    data_packet::parallel_for(layout.chunk_count, thread_number, [&](size_t i)
+    {
+        data_packet::byte* chunk = out + layout.offset_of(i);
+        unsigned char* nonce = reinterpret_cast<unsigned char*>(chunk);
+        if (RAND_bytes(nonce, GCM_NONCE_SIZE) != 1)
+        {
+            throw_openssl_error("Failed to generate nonce");
+        }
+
+        cipher_context context;
+        gcm_init(context.get(), key.data(), nonce, i, i + 1 == layout.chunk_count, true);
+        const size_t length = layout.length_of(i);
+        data_packet::byte* body = chunk + GCM_NONCE_SIZE;
+        size_t written = cipher_update(context.get(), plaintext.subspan(i * chunk_size, length), body);
+        int out_length = 0;
+        if (EVP_EncryptFinal_ex(context.get(), reinterpret_cast<unsigned char*>(body + written), &out_length) != 1 ||
+            EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, body + length) != 1)
+        {
+            throw_openssl_error("Failed to finalize GCM encryption");
+        }
+    });
+    return size;
+}
+
+size_t encryption::gcm_decrypt_to(std::span<const data_packet::byte> ciphertext, const aes_key& key,
+                                  data_packet::byte* out, unsigned int thread_number)
+{
+    const auto layout = parse_gcm_layout(ciphertext);
+
+    ERR_clear_error();
+    data_packet::parallel_for(layout.chunk_count, thread_number, [&](size_t i)
+    {
+        const size_t length = layout.length_of(i);
+        const auto chunk = ciphertext.subspan(layout.offset_of(i), GCM_NONCE_SIZE + length + GCM_TAG_SIZE);
+        const auto* nonce = reinterpret_cast<const unsigned char*>(chunk.data());
+
+        cipher_context context;
+        gcm_init(context.get(), key.data(), nonce, i, i + 1 == layout.chunk_count, false);
+        data_packet::byte* destination = out + i * layout.chunk_size;
+        size_t written = cipher_update(context.get(), chunk.subspan(GCM_NONCE_SIZE, length), destination);
+
+        // 标签不匹配时EVP_DecryptFinal_ex失败，已写出的明文由调用方丢弃
+        unsigned char tag[GCM_TAG_SIZE];
+        std::memcpy(tag, chunk.data() + GCM_NONCE_SIZE + length, GCM_TAG_SIZE);
+        int out_length = 0;
+        if (EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, tag) != 1 ||
+            EVP_DecryptFinal_ex(context.get(), reinterpret_cast<unsigned char*>(destination + written),
+                                &out_length) != 1)
+        {
+            ERR_clear_error();
+            throw std::runtime_error("Failed to authenticate data (wrong password or corrupted data)");
+        }
+    });
+    return layout.plaintext_size;
+}
+
+namespace
+{
+    constexpr std::string_view ENTRY_LABEL = "entry";   ///< 文件子密钥的标签
+    constexpr std::string_view CHECK_LABEL = "check";   ///< 密码校验值的标签
+
+    /**
+     * @brief 计算HMAC-SHA256(密钥, 标签 + 盐)，不同用途使用不同的标签
+     * @param key 密钥
+     * @param label 用途标签
+     * @param salt 盐，可以为空
+     * @param salt_size 盐的大小
+     * @param mac 输出：HMAC-SHA256的结果，32字节
+     * @param what 失败时异常信息
+     */
+    void hmac_sha256(const encryption::aes_key& key, std::string_view label, const unsigned char* salt,
+                     size_t salt_size, unsigned char* mac, const char* what)
+    {
+        std::string message(label);
+        message.append(reinterpret_cast<const char*>(salt), salt_size);
+        unsigned int mac_length = 0;
+        if (HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+                 reinterpret_cast<const unsigned char*>(message.data()), message.size(), mac, &mac_length) == nullptr)
+        {
+            throw_openssl_error(what);
+        }
+    }
+}
+
+encryption::aes_key encryption::password_key(const std::string& password)
+{
+    aes_key key{};
+    generate_aes_key(password, key.data());
+    return key;
+}
+
+encryption::kdf_parameters encryption::kdf_parameters::generate(uint32_t iterations)
+{
+    if (iterations < MIN_KDF_ITERATIONS || iterations > MAX_KDF_ITERATIONS)
+    {
+        throw std::invalid_argument("kdf iterations is out of range.");
+    }
+    kdf_parameters parameters;
+    parameters.iterations = iterations;
+    ERR_clear_error();
+    if (RAND_bytes(parameters.salt.data(), KDF_SALT_SIZE) != 1)
+    {
+        throw_openssl_error("Failed to generate kdf salt");
+    }
+    return parameters;
+}
+
+std::string encryption::kdf_parameters::serialize() const
+{
+    std::string data(SIZE, '\0');
+    data[0] = static_cast<char>(PBKDF2_SHA256);
+    std::tie(data[1], data[2], data[3], data[4]) = data_packet::to_bytes(static_cast<data_packet::dword>(iterations));
+    std::memcpy(data.data() + 5, salt.data(), KDF_SALT_SIZE);
+    return data;
+}
+
+encryption::kdf_parameters encryption::kdf_parameters::parse(std::string_view data)
+{
+    if (data.size() != SIZE)
+    {
+        throw std::runtime_error("key derivation parameters are not valid");
+    }
+    if (static_cast<uint8_t>(data[0]) != PBKDF2_SHA256)
+    {
+        throw std::runtime_error("unknown key derivation algorithm");
+    }
+
+    kdf_parameters parameters;
+    parameters.iterations = data_packet::make_dword({data[1], data[2], data[3], data[4]});
+    if (parameters.iterations < MIN_KDF_ITERATIONS || parameters.iterations > MAX_KDF_ITERATIONS)
+    {
+        throw std::runtime_error("kdf iterations is out of range");
+    }
+    std::memcpy(parameters.salt.data(), data.data() + 5, KDF_SALT_SIZE);
+    return parameters;
+}
+
+encryption::aes_key encryption::derive_key(const std::string& password, const kdf_parameters& parameters)
+{
+    ERR_clear_error();
+    aes_key key{};
+    if (PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()), parameters.salt.data(),
+                          KDF_SALT_SIZE, static_cast<int>(parameters.iterations), EVP_sha256(),
+                          static_cast<int>(key.size()), key.data()) != 1)
+    {
+        throw_openssl_error("Failed to derive key");
+    }
+    return key;
+}
+
+encryption::aes_key encryption::derive_subkey(const aes_key& key, std::span<const unsigned char, KDF_SALT_SIZE> salt)
+{
+    ERR_clear_error();
+    aes_key subkey{};
+    hmac_sha256(key, ENTRY_LABEL, salt.data(), salt.size(), subkey.data(), "Failed to derive subkey");
+    return subkey;
+}
+
+encryption::aes_key encryption::derive_subkey(const aes_key& key, std::string_view label)
+{
+    ERR_clear_error();
+    aes_key subkey{};
+    hmac_sha256(key, label, nullptr, 0, subkey.data(), "Failed to derive subkey");
+    return subkey;
+}
+
+std::string encryption::make_key_check(const aes_key& key)
+{
+    ERR_clear_error();
+    unsigned char buffer[KEY_CHECK_SALT_SIZE + SHA256_DIGEST_LENGTH];
+    if (RAND_bytes(buffer, KEY_CHECK_SALT_SIZE) != 1)
+    {
+        throw_openssl_error("Failed to generate key check salt");
+    }
+    hmac_sha256(key, CHECK_LABEL, buffer, KEY_CHECK_SALT_SIZE, buffer + KEY_CHECK_SALT_SIZE,
+                "Failed to compute key check value");
+    return {reinterpret_cast<const char*>(buffer), KEY_CHECK_SIZE};
+}
+
+bool encryption::verify_key_check(std::string_view key_check, const aes_key& key)
+{
+    if (key_check.size() != KEY_CHECK_SIZE)
+    {
+        throw std::runtime_error("key check value is not valid");
+    }
+
+    ERR_clear_error();
+    unsigned char mac[SHA256_DIGEST_LENGTH];
+    hmac_sha256(key, CHECK_LABEL, reinterpret_cast<const unsigned char*>(key_check.data()), KEY_CHECK_SALT_SIZE, mac,
+                "Failed to compute key check value");
+    return CRYPTO_memcmp(mac, key_check.data() + KEY_CHECK_SALT_SIZE, KEY_CHECK_SIZE - KEY_CHECK_SALT_SIZE) == 0;
+}
@@ -4,7 +4,17 @@
 
 #include "../../include/file_system/get_entries.h"
 
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "../../include/utils/parallel.h"
 
 bool data_packet::is_hard_link(const std::filesystem::path& path)
 {
@@ -12,54 +22,243 @@ bool data_packet::is_hard_link(const std::filesystem::path& path)
     return !entry.is_directory()&&entry.hard_link_count() >= 2;
 }
 
-/* 加个filter */
-auto data_packet::get_entries(const std::filesystem::path& path) -> std::multiset<std::filesystem::directory_entry>
+namespace
 {
-    namespace fs = std::filesystem;
-
-    if (!fs::directory_entry(path).exists())
+    /**
+     * @class traversal
+     * @brief 并行遍历目录树的共享状态
+     *
+     * 每个线程有一个目录队列：自己从队尾取，其他线程从队头窃取，深处的目录留给自己，
+     * 靠近根的目录（其下通常还有较多内容）被其他线程取走。
+     * pending记录已入队但尚未读取完的目录数量，降为0时遍历结束。
+     * 过滤器在读取目录时调用，被过滤的目录不会被读取，其下的内容不会出现在结果中。
+     */
+    class traversal
     {
-        return {};
-    }
+    public:
+        /**
+         * @brief 构造遍历状态
+         * @param thread_number 线程数
+         * @param filter 过滤器，可以为空，会被多个线程同时调用
+         */
+        traversal(size_t thread_number, const data_packet::filter_t* filter)
+            : _queues(thread_number), _entries(thread_number), _filter(filter) {}
 
-    // 指定目录迭代器
-    fs::directory_iterator dir_it(path);
+        /**
+         * @brief 将目录放入第index个线程的队列
+         * @param index 线程下标
+         * @param directory 目录
+         */
+        void push(size_t index, std::filesystem::path directory)
+        {
+            ++_pending;
+            {
+                std::lock_guard lock(_queues[index].mutex);
+                _queues[index].directories.emplace_back(std::move(directory));
+            }
+            ++_queued;
+            notify(false);
+        }
 
-    // 最终结果
-    decltype(get_entries(path)) entries;
+        /**
+         * @brief 第index个线程的遍历循环：读取取得的目录，没有目录时等待，直到全部目录读取完或出错
+         * @param index 线程下标
+         */
+        void run(size_t index)
+        {
+            while (!_failed)
+            {
+                auto directory = take(index);
+                if (!directory)
+                {
+                    std::unique_lock lock(_idle_mutex);
+                    _idle.wait(lock, [this] { return _queued > 0 || _pending == 0 || _failed; });
+                    if (_pending == 0 || _failed)
+                    {
+                        return;
+                    }
+                    continue;
+                }
 
-    // 采用层序遍历，使用队列实现
-    std::queue<std::filesystem::directory_iterator> entries_queue;
+                try
+                {
+                    for (const auto& entry : std::filesystem::directory_iterator(*directory))
+                    {
+                        if (_filter != nullptr && (*_filter)(entry))
+                        {
+                            continue;
+                        }
+                        if (entry.is_directory())
+                        {
+                            push(index, entry.path());
+                        }
+                        _entries[index].emplace_back(entry);
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(_idle_mutex);
+                    if (!_error)
+                    {
+                        _error = std::current_exception();
+                    }
+                    _failed = true;
+                }
 
-    entries_queue.push(dir_it);
+                if (--_pending == 0 || _failed)
+                {
+                    notify(true);
+                }
+            }
+        }
 
-    while (!entries_queue.empty())
-    {
-        for (const auto& entry : entries_queue.front())
+        /**
+         * @brief 合并各线程的结果并按路径排序
+         * @return 文件列表
+         * @throws 遍历中第一个抛出的异常
+         */
+        std::vector<std::filesystem::directory_entry> result()
         {
-            if (entry.is_directory())
+            if (_error)
             {
-                entries_queue.emplace(entry.path());
+                std::rethrow_exception(_error);
             }
-            entries.emplace(entry);
+
+            size_t size = 0;
+            for (const auto& entries : _entries)
+            {
+                size += entries.size();
+            }
+            std::vector<std::filesystem::directory_entry> result;
+            result.reserve(size);
+            for (auto& entries : _entries)
+            {
+                std::ranges::move(entries, std::back_inserter(result));
+            }
+            std::ranges::sort(result);
+            return result;
         }
-        entries_queue.pop();
-    }
-    return entries;
+
+    private:
+        /**
+         * @struct work_queue
+         * @brief 一个线程的目录队列
+         */
+        struct work_queue
+        {
+            std::mutex mutex;
+            std::deque<std::filesystem::path> directories;
+        };
+
+        /**
+         * @brief 先从自己的队尾取目录，为空时依次从其他线程的队头窃取
+         * @param index 线程下标
+         * @return 目录，所有队列都为空时为空
+         */
+        std::optional<std::filesystem::path> take(size_t index)
+        {
+            for (size_t i = 0; i < _queues.size(); ++i)
+            {
+                auto& queue = _queues[(index + i) % _queues.size()];
+                std::lock_guard lock(queue.mutex);
+                if (queue.directories.empty())
+                {
+                    continue;
+                }
+                std::filesystem::path directory;
+                if (i == 0)
+                {
+                    directory = std::move(queue.directories.back());
+                    queue.directories.pop_back();
+                }
+                else
+                {
+                    directory = std::move(queue.directories.front());
+                    queue.directories.pop_front();
+                }
+                --_queued;
+                return directory;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief 唤醒等待的线程；先获取等待所用的锁，避免在检查条件与开始等待之间错过通知
+         * @param all 是否唤醒全部线程
+         */
+        void notify(bool all)
+        {
+            {
+                std::lock_guard lock(_idle_mutex);
+            }
+            if (all)
+            {
+                _idle.notify_all();
+            }
+            else
+            {
+                _idle.notify_one();
+            }
+        }
+
+        std::vector<work_queue> _queues;                                      ///< 各线程的目录队列
+        std::vector<std::vector<std::filesystem::directory_entry>> _entries;  ///< 各线程找到的文件
+        const data_packet::filter_t* _filter;                                 ///< 过滤器
+        std::atomic<size_t> _pending{0};                                      ///< 尚未读取完的目录数量
+        std::atomic<size_t> _queued{0};                                       ///< 队列中的目录数量
+        std::atomic<bool> _failed{false};                                     ///< 是否出错
+        std::exception_ptr _error{nullptr};                                   ///< 第一个异常
+        std::mutex _idle_mutex;
+        std::condition_variable _idle;
+    };
 }
 
-auto data_packet::get_entries(const std::filesystem::path& path,
-    const std::function<bool(const std::filesystem::directory_entry&)>& filter) -> std::multiset<std::filesystem::
-    directory_entry>
+namespace
 {
-    auto entries = get_entries(path);
-    for (auto it = entries.begin(); it != entries.end(); ++it)
+    /**
+     * @brief 从根目录开始多线程并行遍历，最后统一排序，结果与遍历顺序无关
+     * @param path 根目录
+     * @param filter 过滤器，可以为空
+     * @param thread_number 线程数，0表示使用全部硬件线程
+     * @return 按路径排序的文件列表
+     */
+    std::vector<std::filesystem::directory_entry> walk(const std::filesystem::path& path,
+                                                       const data_packet::filter_t* filter,
+                                                       unsigned int thread_number)
     {
-        if (filter(*it))
+        if (!std::filesystem::directory_entry(path).exists())
         {
-            it = entries.erase(it);
+            return {};
         }
+
+        const size_t threads = data_packet::resolve_thread_number(thread_number);
+        traversal state(threads, filter);
+        state.push(0, path);
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i)
+        {
+            workers.emplace_back([&state, i] { state.run(i); });
+        }
+        state.run(0);
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        return state.result();
     }
+}
+
+auto data_packet::get_entries(const std::filesystem::path& path, unsigned int thread_number)
+-> std::vector<std::filesystem::directory_entry>
+{
+    return walk(path, nullptr, thread_number);
+}
 
-    return entries;
+auto data_packet::get_entries(const std::filesystem::path& path,
+                              const std::function<bool(const std::filesystem::directory_entry&)>& filter,
+                              unsigned int thread_number) -> std::vector<std::filesystem::directory_entry>
+{
+    return walk(path, filter ? &filter : nullptr, thread_number);
 }
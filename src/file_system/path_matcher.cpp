@@ -0,0 +1,83 @@
+//
+// Created by hyh on 2026/1/22.
+//
+
+#include "../../include/file_system/path_matcher.h"
+
+#include <fnmatch.h>
+
+data_packet::path_matcher::path_matcher(std::string_view patterns)
+{
+    // 按换行符分割，兼容 \r\n
+    while (!patterns.empty())
+    {
+        const auto end = patterns.find('\n');
+        auto line = patterns.substr(0, end);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        add(line);
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        patterns.remove_prefix(end + 1);
+    }
+}
+
+void data_packet::path_matcher::add(std::string_view pattern)
+{
+    while (pattern.starts_with("./"))
+    {
+        pattern.remove_prefix(2);
+    }
+    while (pattern.size() > 1 && pattern.back() == '/')
+    {
+        pattern.remove_suffix(1);
+    }
+    if (pattern.empty())
+    {
+        return;
+    }
+
+    if (pattern.find_first_of("*?[") == std::string_view::npos)
+    {
+        _literals.emplace(pattern);
+    }
+    else
+    {
+        _globs.emplace_back(pattern);
+    }
+}
+
+bool data_packet::path_matcher::match(std::string_view relative_path) const
+{
+    const std::string path(relative_path);
+    if (_literals.contains(path))
+    {
+        return true;
+    }
+    for (const auto& glob : _globs)
+    {
+        if (fnmatch(glob.c_str(), path.c_str(), 0) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool data_packet::path_matcher::match_self_or_parent(std::string_view relative_path) const
+{
+    // 从自身开始逐级检查上级目录
+    for (auto length = relative_path.size(); length != std::string_view::npos && length > 0;
+         length = relative_path.rfind('/', length - 1))
+    {
+        if (match(relative_path.substr(0, length)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -280,6 +280,8 @@ namespace data_packet
             return fs_type::fifo;
         case 7:
             return fs_type::socket;
+        case 8:
+            return fs_type::not_found;
         default:
             return fs_type::unknown;
         }
@@ -317,6 +319,9 @@ namespace data_packet
         case fs_type::socket:
             type_bits = 7;
             break;
+        case fs_type::not_found:
+            type_bits = 8;
+            break;
         default: // 包括fs_type::unknown及其他未定义类型
             type_bits = (byte)0xff; // 使用一个超出已知范围的值表示未知类型
             break;
@@ -379,8 +384,7 @@ namespace data_packet
 
     local_file_header::compression_method local_file_header::get_compression_method() const
     {
-        byte compression_method_bits = compression_and_encryption_ & compression_method_mask;
-        compression_method_bits >>= 4;
+        const auto compression_method_bits = static_cast<uint8_t>(compression_and_encryption_ & compression_method_mask) >> 4;
         switch (compression_method_bits)
         {
         case 0:
@@ -389,6 +393,10 @@ namespace data_packet
             return compression_method::LZ77;
         case 2:
             return compression_method::HUFFMAN;
+        case 3:
+            return compression_method::CANONICAL_HUFFMAN;
+        case 4:
+            return compression_method::LZ77_SEQUENCE;
         default:
             return compression_method::None;
         }
@@ -409,6 +417,12 @@ namespace data_packet
         case compression_method::HUFFMAN:
             compression_method_bits = 2;
             break;
+        case compression_method::CANONICAL_HUFFMAN:
+            compression_method_bits = 3;
+            break;
+        case compression_method::LZ77_SEQUENCE:
+            compression_method_bits = 4;
+            break;
         default:
             compression_method_bits = 0;
         }
@@ -417,6 +431,23 @@ namespace data_packet
         compression_and_encryption_ |= compression_method_bits;
     }
 
+    bool local_file_header::is_chunked() const
+    {
+        return (compression_and_encryption_ & chunked_mask) != 0;
+    }
+
+    void local_file_header::set_chunked(bool chunked)
+    {
+        if (chunked)
+        {
+            compression_and_encryption_ |= chunked_mask;
+        }
+        else
+        {
+            compression_and_encryption_ &= ~chunked_mask;
+        }
+    }
+
     local_file_header::encryption_method local_file_header::get_encryption_method() const
     {
         // 提取低4位（加密方法位）
@@ -430,6 +461,8 @@ namespace data_packet
             return encryption_method::my_method;
         case 2:
             return encryption_method::AES_256_CBC;
+        case 3:
+            return encryption_method::AES_256_GCM;
         default:
             // 对于未知值，返回默认的None
             return encryption_method::None;
@@ -452,6 +485,9 @@ namespace data_packet
         case encryption_method::AES_256_CBC:
             encryption_method_bits = 2;
             break;
+        case encryption_method::AES_256_GCM:
+            encryption_method_bits = 3;
+            break;
         default:
             encryption_method_bits = 0;
         }
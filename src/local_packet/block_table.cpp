@@ -0,0 +1,91 @@
+//
+// Created by hyh on 2026/1/24.
+//
+
+#include "../../include/local_packet/block_table.h"
+
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * @brief 按大端字节序写入双字
+     * @param out 输出位置，写入后后移
+     * @param value 双字
+     */
+    void put(data_packet::byte*& out, data_packet::dword value)
+    {
+        auto [b0, b1, b2, b3] = data_packet::to_bytes(value);
+        out[0] = b0;
+        out[1] = b1;
+        out[2] = b2;
+        out[3] = b3;
+        out += 4;
+    }
+
+    /**
+     * @brief 按大端字节序读取双字
+     * @param in 输入位置，读取后后移
+     * @return 双字
+     */
+    data_packet::dword get(const data_packet::byte*& in)
+    {
+        const auto value = data_packet::make_dword({in[0], in[1], in[2], in[3]});
+        in += 4;
+        return value;
+    }
+}
+
+void data_packet::block_table::serialize(byte* out) const
+{
+    put(out, chunk_size);
+    put(out, static_cast<dword>(blocks.size()));
+    for (const auto& [stored_size, crc_32, stored] : blocks)
+    {
+        put(out, stored_size);
+        put(out, crc_32);
+        *out++ = stored ? 1 : 0;
+    }
+}
+
+data_packet::block_table data_packet::block_table::parse(const byte* in, qword size, qword original_size)
+{
+    if (size < size_of(0))
+    {
+        throw std::runtime_error("block table is incomplete");
+    }
+
+    block_table table;
+    table.chunk_size = get(in);
+    const dword count = get(in);
+    if (table.chunk_size < MIN_CHUNK_SIZE || table.chunk_size > MAX_CHUNK_SIZE ||
+        count != block_count(original_size, table.chunk_size))
+    {
+        throw std::runtime_error("block table is not valid");
+    }
+    if (size < size_of(count))
+    {
+        throw std::runtime_error("block table is incomplete");
+    }
+
+    table.blocks.resize(count);
+    qword stored_size = size_of(count);
+    for (auto& block : table.blocks)
+    {
+        block.stored_size = get(in);
+        block.crc_32 = get(in);
+        const auto flag = *in++;
+        if (flag != 0 && flag != 1)
+        {
+            throw std::runtime_error("block table is not valid");
+        }
+        block.stored = flag == 1;
+        stored_size += block.stored_size;
+    }
+    if (stored_size != size)
+    {
+        throw std::runtime_error("block table does not match the file size");
+    }
+
+    return table;
+}
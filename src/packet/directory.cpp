@@ -0,0 +1,417 @@
+//
+// Created by hyh on 2026/1/20.
+//
+
+#include "../../include/packet/directory.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../include/local_packet/local_packet.h"
+#include "../../include/packet/packet_reader.h"
+#include "../../include/utils/crc_32.h"
+
+namespace
+{
+    /**
+     * @brief 按大端字节序追加整数
+     * @tparam T 整数类型
+     * @param out 输出位置，写入后后移
+     * @param value 整数
+     */
+    template<typename T>
+    void put(data_packet::byte*& out, T value)
+    {
+        for (int i = sizeof(T) - 1; i >= 0; --i)
+        {
+            out[i] = static_cast<data_packet::byte>(value & 0xff);
+            value >>= 8;
+        }
+        out += sizeof(T);
+    }
+
+    /**
+     * @brief 按大端字节序读取整数
+     * @tparam T 整数类型
+     * @param in 输入位置，读取后后移
+     * @return 整数
+     */
+    template<typename T>
+    T get(const data_packet::byte*& in)
+    {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            value = static_cast<T>(value << 8 | static_cast<uint8_t>(in[i]));
+        }
+        in += sizeof(T);
+        return value;
+    }
+
+    /**
+     * @brief 解析并校验尾部
+     * @param in 尾部起始位置，需至少directory_footer::SIZE字节
+     * @param archive_size 包的大小
+     * @return 尾部
+     */
+    data_packet::directory_footer parse_footer(const data_packet::byte* in, data_packet::qword archive_size)
+    {
+        using namespace data_packet;
+
+        // 各字段分别与包的大小比较，避免求和时溢出
+        directory_footer footer;
+        if (archive_size < directory_footer::SIZE || !footer.parse(in) || footer.offset < file_header::SIZE ||
+            footer.offset > archive_size - directory_footer::SIZE ||
+            footer.size != archive_size - directory_footer::SIZE - footer.offset)
+        {
+            throw std::runtime_error("packet directory footer is not valid");
+        }
+        return footer;
+    }
+
+    /**
+     * @brief 校验并解析中央目录
+     * @param in 中央目录起始位置
+     * @param footer 尾部
+     * @param header 总文件头
+     * @param archive_extra 输出：包扩展字段，可以为空指针
+     * @return 中央目录记录
+     */
+    std::vector<data_packet::directory_record> parse_central_directory(const data_packet::byte* in,
+                                                                       const data_packet::directory_footer& footer,
+                                                                       const data_packet::file_header& header,
+                                                                       std::string* archive_extra)
+    {
+        using namespace data_packet;
+
+        if (!CRC_verify(footer.crc_32, reinterpret_cast<const uint8_t*>(in), footer.size))
+        {
+            throw std::runtime_error("packet directory is not valid");
+        }
+
+        std::vector<directory_record> records;
+        records.reserve(header.get_file_number());
+        const byte* end = in + footer.size;
+        for (dword i = 0; i < header.get_file_number(); ++i)
+        {
+            if (end - in < static_cast<std::ptrdiff_t>(8 + 2))
+            {
+                throw std::runtime_error("packet directory is incomplete");
+            }
+            directory_record record;
+            record.offset = get<qword>(in);
+            const auto extra_length = get<word>(in);
+
+            if (end - in < static_cast<std::ptrdiff_t>(extra_length + local_file_header::SIZE))
+            {
+                throw std::runtime_error("packet directory is incomplete");
+            }
+            record.extra.assign(in, extra_length);
+            in += extra_length;
+
+            // 本地文件头定长字段末尾4字节为link_name与file_name的长度
+            const byte* lengths = in + local_file_header::SIZE - 4;
+            const size_t header_size = local_file_header::SIZE + make_word({lengths[0], lengths[1]}) +
+                                       make_word({lengths[2], lengths[3]});
+            if (end - in < static_cast<std::ptrdiff_t>(header_size))
+            {
+                throw std::runtime_error("packet directory is incomplete");
+            }
+            record.header = std::make_unique<local_file_header>();
+            record.header->set_buffer(in);
+            in += header_size;
+
+            // 先分别检查起始位置与数据大小，record.end()的求和不会溢出
+            if (!record.header->check() || record.offset < file_header::SIZE || record.offset > footer.offset ||
+                header_size > footer.offset - record.offset ||
+                record.header->get_file_size() > footer.offset - record.offset - header_size)
+            {
+                throw std::runtime_error("packet directory record is not valid");
+            }
+            records.emplace_back(std::move(record));
+        }
+
+        // 版本3起各记录之后是包扩展字段
+        if (header.get_version() >= ARCHIVE_EXTRA_VERSION)
+        {
+            if (end - in < 2)
+            {
+                throw std::runtime_error("packet directory is incomplete");
+            }
+            const auto extra_length = get<word>(in);
+            if (end - in < static_cast<std::ptrdiff_t>(extra_length))
+            {
+                throw std::runtime_error("packet directory is incomplete");
+            }
+            if (archive_extra != nullptr)
+            {
+                archive_extra->assign(in, extra_length);
+            }
+        }
+
+        return records;
+    }
+
+    /**
+     * @brief 读取版本2及以上的包的中央目录
+     * @param is 输入流
+     * @param begin 包的起始位置
+     * @param header 总文件头
+     * @param archive_extra 输出：包扩展字段，可以为空指针
+     * @return 中央目录记录
+     */
+    std::vector<data_packet::directory_record> read_central_directory(std::istream& is, std::streampos begin,
+                                                                      const data_packet::file_header& header,
+                                                                      std::string* archive_extra)
+    {
+        using namespace data_packet;
+
+        // 读取尾部
+        is.seekg(0, std::ios::end);
+        const auto archive_size = static_cast<qword>(is.tellg() - begin);
+        if (archive_size < file_header::SIZE + directory_footer::SIZE)
+        {
+            throw std::runtime_error("packet directory is incomplete");
+        }
+        byte footer_buffer[directory_footer::SIZE];
+        is.seekg(begin + static_cast<std::streamoff>(archive_size - directory_footer::SIZE));
+        is.read(footer_buffer, directory_footer::SIZE);
+        if (!is.good())
+        {
+            throw std::runtime_error("packet directory footer is not valid");
+        }
+        const auto footer = parse_footer(footer_buffer, archive_size);
+
+        // 读取中央目录
+        std::vector<byte> buffer(footer.size);
+        is.seekg(begin + static_cast<std::streamoff>(footer.offset));
+        is.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!is.good())
+        {
+            throw std::runtime_error("packet directory is incomplete");
+        }
+
+        return parse_central_directory(buffer.data(), footer, header, archive_extra);
+    }
+
+    /**
+     * @brief 逐个读取旧版本包的本地文件头，跳过文件数据
+     * @param is 输入流，位于总文件头之后
+     * @param begin 包的起始位置
+     * @param header 总文件头
+     * @return 中央目录记录
+     */
+    std::vector<data_packet::directory_record> scan_local_headers(std::istream& is, std::streampos begin,
+                                                                  const data_packet::file_header& header)
+    {
+        using namespace data_packet;
+
+        is.seekg(begin);
+        packet_reader reader(is);
+
+        std::vector<directory_record> records;
+        records.reserve(header.get_file_number());
+        local_packet local_pkt;
+        for (auto position = is.tellg(); reader.skip(local_pkt); position = is.tellg())
+        {
+            directory_record record;
+            record.offset = static_cast<qword>(position - begin);
+            record.header = std::make_unique<local_file_header>();
+            record.header->set_buffer(local_pkt.info().get_buffer().get());
+            records.emplace_back(std::move(record));
+        }
+
+        return records;
+    }
+
+    /**
+     * @brief 在内存中逐个解析旧版本包的本地文件头，跳过文件数据
+     * @param data 包的起始位置
+     * @param size 包的大小
+     * @param header 总文件头
+     * @return 中央目录记录
+     */
+    std::vector<data_packet::directory_record> scan_local_headers(const data_packet::byte* data, size_t size,
+                                                                  const data_packet::file_header& header)
+    {
+        using namespace data_packet;
+
+        std::vector<directory_record> records;
+        records.reserve(header.get_file_number());
+        qword offset = file_header::SIZE;
+        for (dword i = 0; i < header.get_file_number(); ++i)
+        {
+            if (size - offset < local_file_header::SIZE)
+            {
+                throw std::runtime_error("local packet file header is incomplete");
+            }
+            const byte* lengths = data + offset + local_file_header::SIZE - 4;
+            const size_t header_size = local_file_header::SIZE + make_word({lengths[0], lengths[1]}) +
+                                       make_word({lengths[2], lengths[3]});
+            if (size - offset < header_size)
+            {
+                throw std::runtime_error("local packet file header is incomplete");
+            }
+
+            directory_record record;
+            record.offset = offset;
+            record.header = std::make_unique<local_file_header>();
+            record.header->set_buffer(data + offset);
+            if (!record.header->check())
+            {
+                throw std::runtime_error("local packet file header is not valid");
+            }
+            if (record.header->get_file_size() > size - offset - header_size)
+            {
+                throw std::runtime_error("local packet data is incomplete: " + record.header->get_file_name());
+            }
+            offset = record.end();
+            records.emplace_back(std::move(record));
+        }
+
+        return records;
+    }
+}
+
+void data_packet::directory_footer::serialize(byte* out) const
+{
+    put(out, SIGNATURE);
+    put(out, offset);
+    put(out, size);
+    put(out, crc_32);
+}
+
+bool data_packet::directory_footer::parse(const byte* in)
+{
+    if (get<dword>(in) != SIGNATURE)
+    {
+        return false;
+    }
+    offset = get<qword>(in);
+    size = get<qword>(in);
+    crc_32 = get<dword>(in);
+    return true;
+}
+
+void data_packet::append_extra_field(std::string& extra, extra_tag tag, std::string_view value)
+{
+    if (value.size() > 0xffff)
+    {
+        throw std::invalid_argument("[append_extra_field] extra field is too long");
+    }
+
+    byte buffer[1 + 2];
+    byte* out = buffer;
+    put(out, static_cast<uint8_t>(tag));
+    put(out, static_cast<word>(value.size()));
+    extra.append(buffer, sizeof(buffer));
+    extra.append(value);
+}
+
+std::optional<std::string_view> data_packet::find_extra_field(std::string_view extra, extra_tag tag)
+{
+    while (!extra.empty())
+    {
+        if (extra.size() < 1 + 2)
+        {
+            throw std::runtime_error("packet directory extra field is not valid");
+        }
+        const byte* in = extra.data();
+        const auto current = get<uint8_t>(in);
+        const auto length = get<word>(in);
+        if (extra.size() < size_t{1} + 2 + length)
+        {
+            throw std::runtime_error("packet directory extra field is not valid");
+        }
+        if (current == static_cast<uint8_t>(tag))
+        {
+            return extra.substr(1 + 2, length);
+        }
+        extra.remove_prefix(1 + 2 + length);
+    }
+    return std::nullopt;
+}
+
+void data_packet::append_directory_record(std::vector<byte>& buffer, qword offset, const local_file_header& header,
+                                          std::string_view extra)
+{
+    if (extra.size() > 0xffff)
+    {
+        throw std::invalid_argument("[append_directory_record] extra field is too long");
+    }
+
+    const size_t header_size = header.header_size();
+    const size_t position = buffer.size();
+    buffer.resize(position + 8 + 2 + extra.size() + header_size);
+
+    byte* out = buffer.data() + position;
+    put(out, offset);
+    put(out, static_cast<word>(extra.size()));
+    out = std::copy(extra.begin(), extra.end(), out);
+    const auto header_buffer = header.get_buffer();
+    std::copy_n(header_buffer.get(), header_size, out);
+}
+
+std::vector<data_packet::directory_record> data_packet::read_directory(std::istream& is, file_header& header,
+                                                                       std::string* archive_extra)
+{
+    if (archive_extra != nullptr)
+    {
+        archive_extra->clear();
+    }
+    if (!is.good())
+    {
+        throw std::runtime_error("Stream is in error state before reading header");
+    }
+
+    // 读取并校验总文件头
+    const auto begin = is.tellg();
+    byte buffer[file_header::SIZE];
+    is.read(buffer, file_header::SIZE);
+    if (is.gcount() != static_cast<std::streamsize>(file_header::SIZE))
+    {
+        throw std::runtime_error("packet header is incomplete");
+    }
+    header.set_buffer(buffer);
+    if (!header.check())
+    {
+        throw std::runtime_error("packet header is not valid");
+    }
+
+    if (header.get_version() >= DIRECTORY_VERSION)
+    {
+        return read_central_directory(is, begin, header, archive_extra);
+    }
+    return scan_local_headers(is, begin, header);
+}
+
+std::vector<data_packet::directory_record> data_packet::read_directory(const byte* data, size_t size,
+                                                                       file_header& header,
+                                                                       std::string* archive_extra)
+{
+    if (archive_extra != nullptr)
+    {
+        archive_extra->clear();
+    }
+    // 读取并校验总文件头
+    if (size < file_header::SIZE)
+    {
+        throw std::runtime_error("packet header is incomplete");
+    }
+    header.set_buffer(data);
+    if (!header.check())
+    {
+        throw std::runtime_error("packet header is not valid");
+    }
+
+    if (header.get_version() >= DIRECTORY_VERSION)
+    {
+        if (size < file_header::SIZE + directory_footer::SIZE)
+        {
+            throw std::runtime_error("packet directory is incomplete");
+        }
+        const auto footer = parse_footer(data + size - directory_footer::SIZE, size);
+        return parse_central_directory(data + footer.offset, footer, header, archive_extra);
+    }
+    return scan_local_headers(data, size, header);
+}
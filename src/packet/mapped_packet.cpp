@@ -0,0 +1,113 @@
+//
+// Created by hyh on 2026/1/23.
+//
+
+#include "../../include/packet/mapped_packet.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../include/local_packet/block_table.h"
+#include "../../include/utils/crc_32.h"
+
+data_packet::mapped_packet::mapped_packet(const std::filesystem::path& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open input file " + path.string());
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path.string());
+    }
+    _size = static_cast<size_t>(file_stat.st_size);
+    if (_size < file_header::SIZE)
+    {
+        close(fd);
+        throw std::runtime_error("packet header is incomplete");
+    }
+
+    // 映射建立后即可关闭文件描述符，映射在munmap前一直有效
+    void* address = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        throw std::runtime_error("cannot map " + path.string());
+    }
+    _data = static_cast<const byte*>(address);
+
+    try
+    {
+        _records = read_directory(_data, _size, _header, &_archive_extra);
+    }
+    catch (...)
+    {
+        munmap(const_cast<byte*>(_data), _size);
+        throw;
+    }
+}
+
+data_packet::mapped_packet::~mapped_packet()
+{
+    munmap(const_cast<byte*>(_data), _size);
+}
+
+std::span<const data_packet::byte> data_packet::mapped_packet::data(size_t index) const
+{
+    const auto& record = _records.at(index);
+    return {_data + record.offset + record.header->header_size(), record.header->get_file_size()};
+}
+
+void data_packet::mapped_packet::verify(size_t index) const
+{
+    const auto& record = _records.at(index);
+    const auto& header = *record.header;
+
+    // 中央目录中的本地文件头是包内本地文件头的副本，二者必须逐字节相同
+    if (_header.get_version() >= DIRECTORY_VERSION)
+    {
+        const auto buffer = header.get_buffer();
+        if (std::memcmp(buffer.get(), _data + record.offset, header.header_size()) != 0)
+        {
+            throw std::runtime_error("packet directory does not match the local file header of " +
+                                     header.get_file_name());
+        }
+    }
+
+    const auto payload = data(index);
+
+    // 分块编码时本地文件头的CRC32只覆盖块表，各块的CRC32记录在块表中
+    if (header.is_chunked())
+    {
+        const auto table = block_table::parse(payload.data(), payload.size(), header.get_original_file_size());
+        if (!CRC_verify(header.get_crc_32(), reinterpret_cast<const uint8_t*>(payload.data()), table.size()))
+        {
+            throw std::runtime_error("local packet data is corrupted: " + header.get_file_name());
+        }
+        const byte* block = payload.data() + table.size();
+        for (const auto& [stored_size, crc_32, stored] : table.blocks)
+        {
+            if (!CRC_verify(crc_32, reinterpret_cast<const uint8_t*>(block), stored_size))
+            {
+                throw std::runtime_error("local packet data is corrupted: " + header.get_file_name());
+            }
+            block += stored_size;
+        }
+        return;
+    }
+
+    if (!payload.empty() &&
+        !CRC_verify(header.get_crc_32(), reinterpret_cast<const uint8_t*>(payload.data()), payload.size()))
+    {
+        throw std::runtime_error("local packet data is corrupted: " + header.get_file_name());
+    }
+}
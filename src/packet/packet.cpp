@@ -7,7 +7,6 @@
 #include <grp.h>
 #include <sys/types.h>
 #include <fstream>
-#include <map>
 #include <sys/sysmacros.h>
 
 #include "../../include/packet/packet.h"
@@ -69,10 +68,12 @@ namespace
      * @param entry 指定访问目录
      * @param root_path 根路径
      * @param file_stat 文件描述符
+     * @param read_content 是否读入常规文件的内容
      */
     void fill_in_local_header_link(data_packet::local_packet& packet,
                                    const std::filesystem::directory_entry& entry,
-                                   const std::filesystem::path& root_path, const struct stat& file_stat)
+                                   const std::filesystem::path& root_path, const struct stat& file_stat,
+                                   bool read_content)
     {
         namespace fs = std::filesystem;
         using namespace data_packet;
@@ -110,10 +111,10 @@ namespace
         case fs::file_type::regular:   // 常规文件
             {
                 // 读取文件内容到缓冲区
-                std::fstream file(entry.path(), std::ios::in | std::ios::binary);
-                auto buffer = std::make_unique<byte[]>(entry.file_size());
-                file.read(reinterpret_cast<char*>(buffer.get()), static_cast<long>(entry.file_size()));
-                packet.set_data(std::move(buffer)); // 设置文件数据
+                if (read_content)
+                {
+                    read_file_content(packet, entry.path());
+                }
                 packet.set_link_name_length(0);
                 packet.set_link_name(std::string{});
                 break;
@@ -203,6 +204,73 @@ void data_packet::packet::refresh_crc_32()
     _header.set_crc_32(CRC_calculate(reinterpret_cast<uint8_t*>(buffer.get()), offset));
 }
 
+void data_packet::read_file_content(local_packet& local_pkt, const std::filesystem::path& path)
+{
+    const auto size = local_pkt.info().get_file_size();
+    std::fstream file(path, std::ios::in | std::ios::binary);
+    auto buffer = std::make_unique<byte[]>(size);
+    file.read(buffer.get(), static_cast<long>(size));
+    local_pkt.set_data(std::move(buffer)); // 设置文件数据
+}
+
+/**
+ * @brief 根据单个目录项创建本地数据包
+ * @param root_path 打包根路径
+ * @param entry 需要打包的目录项
+ * @param hard_links 硬链接映射表
+ * @param read_content 是否读入常规文件的内容
+ * @return 本地数据包
+ * @throws std::runtime_error 当无法获取文件状态时抛出异常
+ */
+data_packet::local_packet data_packet::make_local_packet(const std::filesystem::path& root_path,
+                                                         const std::filesystem::directory_entry& entry,
+                                                         hard_link_map_t& hard_links,
+                                                         bool read_content)
+{
+    local_packet tmp;
+    struct stat file_stat{};
+
+    // 获取文件状态信息（不跟随软链接）
+    if (lstat(entry.path().c_str(), &file_stat) != 0)
+    {
+        throw std::runtime_error("cannot stat " + entry.path().string());
+    }
+
+    // 填写包文件头，不包括软链接
+    fill_in_local_header(tmp, file_stat, entry.path(), root_path);
+
+    if (hard_links.find(file_stat.st_ino) != hard_links.end())
+    {
+        // 处理硬链接
+        auto buffer = std::make_unique<byte[]>(11);
+        memcpy(buffer.get(), "\nhard_link\n", 11);
+        tmp.set_file_size(11);
+        tmp.set_original_file_size(11);
+        tmp.set_data(std::move(buffer));
+        tmp.set_link_name_length(hard_links.at(file_stat.st_ino).string().size());
+        tmp.set_link_name(hard_links.at(file_stat.st_ino).string());
+    }
+    else
+    {
+        // 仅记录可能被再次访问到的inode，避免映射表随文件数量无限增长
+        if (!S_ISDIR(file_stat.st_mode) && file_stat.st_nlink >= 2)
+        {
+            hard_links.insert({file_stat.st_ino, tmp.info().get_file_name()});
+        }
+        // 根据文件类型处理不同类型的数据（非硬链接）
+        fill_in_local_header_link(tmp, entry, root_path, file_stat, read_content);
+    }
+
+    // 刷新当前本地数据包的CRC32和校验和，未读入的文件内容由调用方计算CRC32
+    if (tmp.get_data() != nullptr || tmp.info().get_file_size() == 0)
+    {
+        tmp.refresh_crc_32();
+    }
+    tmp.refresh_checksum();
+
+    return tmp;
+}
+
 /**
  * @brief 根据指定路径创建数据包
  * @param path 要打包的文件或目录路径
@@ -214,8 +282,6 @@ void data_packet::packet::refresh_crc_32()
  */
 data_packet::packet data_packet::make_packet(const std::filesystem::path& path)
 {
-    namespace fs = std::filesystem;
-
     packet pkt; // 创建主数据包
 
     // 获取路径下的所有条目（不跟随软链接）
@@ -225,48 +291,12 @@ data_packet::packet data_packet::make_packet(const std::filesystem::path& path)
     pkt.packets().reserve(entries.size());
 
     // 处理硬链接的映射表
-    std::map<decltype(stat::st_ino),fs::path> files;
+    hard_link_map_t hard_links;
 
     // 遍历每个条目并创建对应的本地数据包
     for (const auto& entry : entries)
     {
-        local_packet tmp;
-        struct stat file_stat{};
-
-        // 获取文件状态信息（不跟随软链接）
-        if (lstat(entry.path().c_str(), &file_stat) != 0)
-        {
-            throw std::runtime_error("cannot stat " + path.string());
-        }
-
-        // 填写包文件头，不包括软链接
-        fill_in_local_header(tmp, file_stat, entry.path(), path);
-
-        if (files.find(file_stat.st_ino) != files.end())
-        {
-            // 处理硬链接
-            auto buffer = std::make_unique<byte[]>(11);
-            memcpy(buffer.get(), "\nhard_link\n", 11);
-            tmp.set_file_size(11);
-            tmp.set_original_file_size(11);
-            tmp.set_data(std::move(buffer));
-            tmp.set_link_name_length(files.at(file_stat.st_ino).string().size());
-            tmp.set_link_name(files.at(file_stat.st_ino).string());
-        }
-        else
-        {
-            // 记录inode以及其对应路径
-            files.insert({file_stat.st_ino,tmp.info().get_file_name()});
-            // 根据文件类型处理不同类型的数据（非硬链接）
-            fill_in_local_header_link(tmp, entry, path, file_stat);
-        }
-
-        // 刷新当前本地数据包的CRC32和校验和
-        tmp.refresh_crc_32();
-        tmp.refresh_checksum();
-
-        // 将本地数据包添加到主数据包中
-        pkt.packets().emplace_back(std::move(tmp));
+        pkt.packets().emplace_back(make_local_packet(path, entry, hard_links));
     }
 
     // 设置主数据包的元数据信息
@@ -363,107 +393,177 @@ std::istream& data_packet::operator>>(std::istream& is, packet& packet)
     return is;
 }
 
-void data_packet::unpack_packet(const std::filesystem::path& path, const packet& pkt)
+void data_packet::unpacker::unpack(const local_packet& local_pkt)
+{
+    unpack(local_pkt.info(), local_pkt.get_data().get(), local_pkt.info().get_file_size());
+}
+
+void data_packet::unpacker::unpack(const local_file_header& info, const byte* data, size_t size)
 {
     namespace fs = std::filesystem;
 
-    // 优先还原目录结构，若文件存在则删除
-    for (const auto& local_pkt : pkt.packets())
+    const auto file_path = _path / info.get_file_name();
+
+    // 若文件存在则删除（不跟随软链接），已存在的目录保留，只还原权限，使还原部分文件时不影响目录下的其余内容
+    const auto status = fs::symlink_status(file_path);
+    const bool keep_directory = fs::is_directory(status) && info.get_link_name_length() == 0 &&
+                                info.get_file_type() == fs::file_type::directory;
+    if (fs::exists(status) && !keep_directory)
+    {
+        fs::remove_all(file_path);
+    }
+
+    // 链接延后到finish时还原，保证链接目标已经存在
+    if (info.get_link_name_length() > 0)
     {
-        if (fs::exists(path / local_pkt.info().get_file_name()))
+        if (info.get_file_size() > 0)
         {
-            fs::remove_all(path / local_pkt.info().get_file_name());
+            _hard_links.emplace_back(info.get_link_name(), info.get_file_name());
         }
-        if (local_pkt.info().get_file_type() == fs::file_type::directory)
+        else
         {
-            fs::create_directory(path / local_pkt.info().get_file_name());
-            fs::permissions(path / local_pkt.info().get_file_name(),local_pkt.info().get_permissions());
+            _symlinks.emplace_back(info.get_link_name(), info.get_file_name());
         }
+        return;
     }
 
-    // 还原正常文件
-    for (const auto& local_pkt : pkt.packets())
+    switch (info.get_file_type())
     {
-        if (local_pkt.info().get_link_name_length() > 0 || local_pkt.info().get_file_type() == fs::file_type::directory)
+    case fs::file_type::directory:
         {
-            continue;
+            fs::create_directory(file_path);
+            _directories.emplace_back(file_path, info.get_permissions());
+            break;
         }
-        switch (local_pkt.info().get_file_type())
+    case fs::file_type::regular:
         {
-        case fs::file_type::regular:
+            // 创建文件并写入数据
+            std::ofstream file(file_path, std::ios::binary);
+            file.write(data, static_cast<long>(size));
+            file.close();
+
+            // 设置文件权限
+            fs::permissions(file_path, info.get_permissions());
+            break;
+        }
+    case fs::file_type::character:
+    case fs::file_type::block:
+        {
+            // 读取主设备号与次设备号
+            if (size < 8)
             {
-                // 创建文件并写入数据
-                std::ofstream file(path / local_pkt.info().get_file_name(), std::ios::binary);
-                file.write(local_pkt.get_data().get(), static_cast<long>(local_pkt.info().get_file_size()));
-                file.close();
-
-                // 设置文件权限
-                fs::permissions(path / local_pkt.info().get_file_name(),local_pkt.info().get_permissions());
-                break;
+                throw std::runtime_error("device number is incomplete " + info.get_file_name());
             }
-        case fs::file_type::character:
-        case fs::file_type::block:
-            {
-                // 读取主设备号与次设备号
-                auto buffer = local_pkt.get_data().get();
-                uint32_t main_dev = make_dword({buffer[0],buffer[1],buffer[2],buffer[3]});
-                uint32_t sub_dev = make_dword({buffer[4],buffer[5],buffer[6],buffer[7]});
+            auto buffer = data;
+            uint32_t main_dev = make_dword({buffer[0],buffer[1],buffer[2],buffer[3]});
+            uint32_t sub_dev = make_dword({buffer[4],buffer[5],buffer[6],buffer[7]});
 
-                // 读取文件名
-                auto file_name = (path / local_pkt.info().get_file_name()).string();
+            // 确认文件类型
+            int type = info.get_file_type() == fs::file_type::character? S_IFCHR : S_IFBLK;
 
-                // 确认文件类型
-                int type = local_pkt.info().get_file_type() == fs::file_type::character? S_IFCHR : S_IFBLK;
+            // 创建设备文件
+            mknod(file_path.c_str(), type, makedev(main_dev, sub_dev));
 
-                // 创建设备文件
-                mknod(file_name.c_str(), type, makedev(main_dev, sub_dev));
+            // 设置权限
+            fs::permissions(file_path, info.get_permissions());
+            break;
+        }
+    case fs::file_type::fifo:
+        {
+            mkfifo(file_path.c_str(), 0000);
+            fs::permissions(file_path, info.get_permissions());
+            break;
+        }
+    case fs::file_type::not_found:
+        {
+            // 增量备份中已删除的文件，在上面已经删除
+            break;
+        }
+    default:
+        throw std::runtime_error("File type not recognized " + info.get_file_name());
+    }
+}
 
-                // 设置权限
-                fs::permissions(file_name,local_pkt.info().get_permissions());
+void data_packet::unpacker::unpack(const local_file_header& info, const std::function<void(std::ostream&)>& write)
+{
+    namespace fs = std::filesystem;
 
-                break;
-            }
-        case fs::file_type::fifo:
-            {
-                auto file_name = (path / local_pkt.info().get_file_name()).string();
-                mkfifo(file_name.c_str(), 0000);
-                fs::permissions(file_name,local_pkt.info().get_permissions());
-                break;
-            }
-        default:
-            throw std::runtime_error("File type not recognized " + local_pkt.info().get_file_name());
-        }
+    if (info.get_link_name_length() > 0 || info.get_file_type() != fs::file_type::regular)
+    {
+        throw std::invalid_argument("[unpacker::unpack] only regular files can be written in pieces: " +
+                                    info.get_file_name());
     }
 
+    const auto file_path = _path / info.get_file_name();
+    if (fs::exists(fs::symlink_status(file_path)))
+    {
+        fs::remove_all(file_path);
+    }
+
+    // 创建文件并由调用方写入数据
+    std::ofstream file(file_path, std::ios::binary);
+    write(file);
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("cannot write " + file_path.string());
+    }
+
+    // 设置文件权限
+    fs::permissions(file_path, info.get_permissions());
+}
+
+void data_packet::unpacker::finish()
+{
+    namespace fs = std::filesystem;
+
     // 还原硬链接关系
-    for (const auto& local_pkt : pkt.packets())
+    for (const auto& [target, link] : _hard_links)
     {
-        if (local_pkt.info().get_link_name_length() <= 0)
-        {
-            continue;
-        }
-        if (local_pkt.info().get_file_size() > 0)
-        {
-            // 还原硬链接
-            auto target_name = path / local_pkt.info().get_link_name();
-            auto link_name = path / local_pkt.info().get_file_name();
-            fs::create_hard_link(target_name,link_name);
-        }
+        fs::create_hard_link(_path / target, _path / link);
     }
 
     // 还原软链接
+    for (const auto& [target, link] : _symlinks)
+    {
+        fs::create_symlink(target, _path / link);
+    }
+
+    // 由深到浅设置目录权限
+    for (auto it = _directories.rbegin(); it != _directories.rend(); ++it)
+    {
+        fs::permissions(it->first, it->second);
+    }
+
+    _hard_links.clear();
+    _symlinks.clear();
+    _directories.clear();
+}
+
+void data_packet::unpack_packet(const std::filesystem::path& path, const packet& pkt)
+{
+    namespace fs = std::filesystem;
+
+    unpacker unpack(path);
+
+    // 优先还原目录结构
     for (const auto& local_pkt : pkt.packets())
     {
-        if (local_pkt.info().get_link_name_length() <= 0)
+        if (local_pkt.info().get_file_type() == fs::file_type::directory)
         {
-            continue;
+            unpack.unpack(local_pkt);
         }
-        if (local_pkt.info().get_file_size() == 0)
+    }
+
+    // 还原其余文件，链接延后处理
+    for (const auto& local_pkt : pkt.packets())
+    {
+        if (local_pkt.info().get_file_type() != fs::file_type::directory)
         {
-            // 还原软链接
-            auto target_name = local_pkt.info().get_link_name();
-            auto link_name = path / local_pkt.info().get_file_name();
-            fs::create_symlink(target_name,link_name);
+            unpack.unpack(local_pkt);
         }
     }
+
+    // 还原硬链接、软链接与目录权限
+    unpack.finish();
 }
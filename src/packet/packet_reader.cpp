@@ -0,0 +1,118 @@
+//
+// Created by hyh on 2026/1/14.
+//
+
+#include "../../include/packet/packet_reader.h"
+
+#include <stdexcept>
+
+data_packet::packet_reader::packet_reader(std::istream& is) : _is(is)
+{
+    // 读取总文件头前检查
+    if (!_is.good())
+    {
+        throw std::runtime_error("Stream is in error state before reading header");
+    }
+    _begin = _is.tellg();
+
+    byte buffer[file_header::SIZE];
+    _is.read(buffer, file_header::SIZE);
+    if (_is.gcount() != static_cast<std::streamsize>(file_header::SIZE))
+    {
+        throw std::runtime_error("packet header is incomplete");
+    }
+    _header.set_buffer(buffer);
+
+    if (!_header.check())
+    {
+        throw std::runtime_error("packet header is not valid");
+    }
+}
+
+bool data_packet::packet_reader::next(local_packet& local_pkt)
+{
+    if (_read_number >= _header.get_file_number())
+    {
+        return false;
+    }
+
+    read_header(local_pkt);
+    read_data(local_pkt);
+
+    ++_read_number;
+    return true;
+}
+
+void data_packet::packet_reader::read(qword offset, local_packet& local_pkt)
+{
+    _is.clear();
+    _is.seekg(_begin + static_cast<std::streamoff>(offset));
+    if (!_is.good())
+    {
+        throw std::runtime_error("local packet offset is out of range");
+    }
+
+    read_header(local_pkt);
+    read_data(local_pkt);
+}
+
+bool data_packet::packet_reader::skip(local_packet& local_pkt)
+{
+    if (_read_number >= _header.get_file_number())
+    {
+        return false;
+    }
+
+    read_header(local_pkt);
+
+    // 跳过文件数据
+    _is.seekg(static_cast<std::streamoff>(local_pkt.info().get_file_size()), std::ios::cur);
+    if (!_is.good())
+    {
+        throw std::runtime_error("local packet data is incomplete: " + local_pkt.info().get_file_name());
+    }
+
+    ++_read_number;
+    return true;
+}
+
+void data_packet::packet_reader::read_header(local_packet& local_pkt)
+{
+    local_pkt = local_packet{};
+
+    // 读取本地文件头定长字段信息，末尾4字节为link_name与file_name的长度
+    _buffer.resize(local_file_header::SIZE);
+    _is.read(_buffer.data(), local_file_header::SIZE);
+    const byte* lengths = _buffer.data() + local_file_header::SIZE - 4;
+    const size_t link_name_length = make_word({lengths[0], lengths[1]});
+    const size_t file_name_length = make_word({lengths[2], lengths[3]});
+
+    // 读取变长字段link_name 与 file_name，与定长字段一起反序列化
+    _buffer.resize(local_file_header::SIZE + link_name_length + file_name_length);
+    _is.read(_buffer.data() + local_file_header::SIZE, static_cast<long>(link_name_length + file_name_length));
+
+    if (!_is.good())
+    {
+        throw std::runtime_error("local packet file header is incomplete");
+    }
+    local_pkt.set_header_buffer(_buffer.data());
+
+    // 校验
+    if (!local_pkt.info().check())
+    {
+        throw std::runtime_error("local packet file header is not valid");
+    }
+}
+
+void data_packet::packet_reader::read_data(local_packet& local_pkt)
+{
+    // 读取文件数据，内容会被完整覆盖，无需初始化
+    const auto size = local_pkt.info().get_file_size();
+    auto buffer = std::make_unique_for_overwrite<byte[]>(size);
+    _is.read(buffer.get(), static_cast<long>(size));
+    if (static_cast<qword>(_is.gcount()) != size)
+    {
+        throw std::runtime_error("local packet data is incomplete: " + local_pkt.info().get_file_name());
+    }
+    local_pkt.set_data(std::move(buffer));
+}
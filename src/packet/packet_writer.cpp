@@ -0,0 +1,179 @@
+//
+// Created by hyh on 2026/1/12.
+//
+
+#include "../../include/packet/packet_writer.h"
+
+#include <stdexcept>
+
+#include "../../include/packet/directory.h"
+#include "../../include/utils/crc_32.h"
+
+data_packet::packet_writer::packet_writer(std::ostream& os)
+    : _os(os), _begin(os.tellp()), _crc(INIT)
+{
+    if (!_os.good() || _begin == std::streampos(-1))
+    {
+        throw std::runtime_error("[packet_writer] output stream is not seekable");
+    }
+
+    _file_size = _header.header_size();
+    _original_file_size = _header.header_size();
+
+    // 写入占位总文件头，finish时回填
+    _os.write(_header.get_buffer().get(), static_cast<long>(_header.header_size()));
+}
+
+void data_packet::packet_writer::write(const local_packet& local_pkt, std::string_view extra)
+{
+    if (_finished || _entry != std::streampos(-1))
+    {
+        throw std::logic_error("[packet_writer::write] writer has been finished or an entry is being written");
+    }
+
+    const auto& info = local_pkt.info();
+
+    _os.write(info.get_buffer().get(), static_cast<long>(info.header_size()));
+    _os.write(local_pkt.get_data().get(), static_cast<long>(info.get_file_size()));
+
+    if (!_os.good())
+    {
+        throw std::runtime_error("[packet_writer::write] failed to write " + info.get_file_name());
+    }
+
+    record(info, extra);
+}
+
+void data_packet::packet_writer::begin(const local_file_header& info)
+{
+    if (_finished || _entry != std::streampos(-1))
+    {
+        throw std::logic_error("[packet_writer::begin] writer has been finished or an entry is being written");
+    }
+
+    _entry = _os.tellp();
+    _entry_header_size = info.header_size();
+    _entry_size = 0;
+    _os.write(info.get_buffer().get(), static_cast<long>(_entry_header_size));
+
+    if (!_os.good())
+    {
+        throw std::runtime_error("[packet_writer::begin] failed to write " + info.get_file_name());
+    }
+}
+
+void data_packet::packet_writer::append(const byte* data, size_t size)
+{
+    if (_entry == std::streampos(-1))
+    {
+        throw std::logic_error("[packet_writer::append] no entry is being written");
+    }
+
+    _os.write(data, static_cast<long>(size));
+    _entry_size += size;
+
+    if (!_os.good())
+    {
+        throw std::runtime_error("[packet_writer::append] failed to write file data");
+    }
+}
+
+void data_packet::packet_writer::end(const local_file_header& info, std::span<const byte> prefix,
+                                     std::string_view extra)
+{
+    if (_entry == std::streampos(-1))
+    {
+        throw std::logic_error("[packet_writer::end] no entry is being written");
+    }
+    if (info.header_size() != _entry_header_size || info.get_file_size() != _entry_size ||
+        prefix.size() > _entry_size)
+    {
+        throw std::logic_error("[packet_writer::end] header does not match the written data of " +
+                               info.get_file_name());
+    }
+
+    // 回到本地文件头处重写头部与数据开头，再回到末尾
+    const auto end = _os.tellp();
+    _os.seekp(_entry);
+    _os.write(info.get_buffer().get(), static_cast<long>(info.header_size()));
+    _os.write(prefix.data(), static_cast<long>(prefix.size()));
+    _os.seekp(end);
+
+    if (!_os.good())
+    {
+        throw std::runtime_error("[packet_writer::end] failed to write " + info.get_file_name());
+    }
+
+    _entry = -1;
+    record(info, extra);
+}
+
+void data_packet::packet_writer::record(const local_file_header& info, std::string_view extra)
+{
+    // 记录中央目录，_file_size即当前本地文件头相对包起始位置的偏移
+    append_directory_record(_directory, _file_size, info, extra);
+
+    // 与packet::refresh_*保持一致的累加方式
+    ++_file_number;
+    _file_size += info.get_file_size() + info.header_size();
+    _original_file_size += info.get_original_file_size() + info.header_size();
+
+    auto bytes = to_bytes(info.get_crc_32());
+    const byte crc_bytes[4]{std::get<0>(bytes), std::get<1>(bytes), std::get<2>(bytes), std::get<3>(bytes)};
+    _crc = CRC_update(_crc, reinterpret_cast<const uint8_t*>(crc_bytes), sizeof(crc_bytes));
+}
+
+void data_packet::packet_writer::finish(std::string_view archive_extra)
+{
+    if (_finished)
+    {
+        return;
+    }
+    if (_entry != std::streampos(-1))
+    {
+        throw std::logic_error("[packet_writer::finish] an entry is still being written");
+    }
+    if (archive_extra.size() > 0xffff)
+    {
+        throw std::invalid_argument("[packet_writer::finish] archive extra field is too long");
+    }
+
+    // 包扩展字段位于各记录之后，由中央目录的CRC32一并校验
+    const auto length = to_bytes(static_cast<word>(archive_extra.size()));
+    _directory.push_back(std::get<0>(length));
+    _directory.push_back(std::get<1>(length));
+    _directory.insert(_directory.end(), archive_extra.begin(), archive_extra.end());
+
+    // 在末尾写出中央目录与尾部，总文件头中的大小不包含这两部分
+    directory_footer footer;
+    footer.offset = _file_size;
+    footer.size = _directory.size();
+    footer.crc_32 = CRC_calculate(reinterpret_cast<const uint8_t*>(_directory.data()), _directory.size());
+    byte footer_buffer[directory_footer::SIZE];
+    footer.serialize(footer_buffer);
+    _os.write(_directory.data(), static_cast<long>(_directory.size()));
+    _os.write(footer_buffer, directory_footer::SIZE);
+
+    _header.set_version(ARCHIVE_EXTRA_VERSION);
+    _header.refresh_creation_time();
+    _header.set_file_number(_file_number);
+    _header.set_file_size(_file_size);
+    _header.set_original_file_size(_original_file_size);
+    _header.set_crc_32(_crc ^ FINALXOR);
+    _header.refresh_checksum();
+
+    // 回到起始位置重写总文件头，再回到末尾
+    const auto end = _os.tellp();
+    _os.seekp(_begin);
+    _os.write(_header.get_buffer().get(), static_cast<long>(_header.header_size()));
+    _os.seekp(end);
+    _os.flush();
+
+    if (!_os.good())
+    {
+        throw std::runtime_error("[packet_writer::finish] failed to write packet header");
+    }
+
+    _directory = {};
+    _finished = true;
+}
@@ -4,9 +4,243 @@
 
 #include "../../include/utils/crc_32.h"
 
+#include <array>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DATA_BACK_UP_CRC_32_CLMUL 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// 分片查表的表组类型
+    using slicing_table_t = std::array<std::array<uint32_t, 256>, 8>;
+
+    /**
+     * @brief 生成slicing-by-8所需的8张表
+     * @details 第k张表为某字节之后再跟随k个0字节时对CRC的贡献，第0张即crc32_table
+     * @return 表组
+     */
+    constexpr slicing_table_t make_slicing_table()
+    {
+        slicing_table_t table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            table[0][i] = data_packet::crc32_table[i];
+        }
+        for (size_t k = 1; k < 8; ++k)
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+        return table;
+    }
+
+    constexpr slicing_table_t slicing_table = make_slicing_table();
+
+    /**
+     * @brief 按小端字节序读取4字节
+     * @param data 数据指针
+     * @return 双字
+     */
+    inline uint32_t load_little_endian(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+               static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+    }
+
+    /**
+     * @brief 逐字节查表累加CRC中间状态，作为各实现的尾部处理及最终回退路径
+     */
+    uint32_t crc_update_byte(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            crc = (crc >> 8) ^ data_packet::crc32_table[(crc ^ data[i]) & 0xFF];
+        }
+        return crc;
+    }
+
+    /**
+     * @brief slicing-by-8查表累加CRC中间状态，每次处理8字节
+     */
+    uint32_t crc_update_slicing(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        const auto& t = slicing_table;
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            const uint32_t one = load_little_endian(data) ^ crc;
+            const uint32_t two = load_little_endian(data + 4);
+            crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+                  t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+        }
+        return crc_update_byte(crc, data, size);
+    }
+
+#ifdef DATA_BACK_UP_CRC_32_CLMUL
+    /**
+     * @brief 使用PCLMULQDQ指令折叠计算CRC中间状态
+     * @details 算法与常量来自Intel白皮书《Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+     * Instruction》，与Chromium zlib的crc32_sse42_simd_相同：4路并行折叠64字节块，再折叠到128位，
+     * 最后经Barrett归约得到32位结果。输入输出均为未取反的中间状态。
+     * @param crc 当前中间状态
+     * @param data 数据指针
+     * @param size 数据长度，需不小于64且为16的整数倍
+     * @return 新的中间状态
+     */
+    __attribute__((target("pclmul,sse4.1")))
+    uint32_t crc_fold_clmul(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        alignas(16) static constexpr uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+        alignas(16) static constexpr uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+        alignas(16) static constexpr uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+        alignas(16) static constexpr uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+        // 读入第一个64字节块，并将中间状态异或到最低32位
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+        x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+        x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+        data += 64;
+        size -= 64;
+
+        // 4路并行折叠后续64字节块
+        while (size >= 64)
+        {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+            y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+            y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+            y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+            y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+            data += 64;
+            size -= 64;
+        }
+
+        // 将4路结果折叠为128位
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        // 逐个折叠剩余的16字节块
+        while (size >= 16)
+        {
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+            data += 16;
+            size -= 16;
+        }
+
+        // 128位折叠为64位
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+
+        x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett归约到32位
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    }
+
+    /**
+     * @brief 折叠处理16字节对齐长度的主体部分，剩余不足16字节的尾部用查表处理
+     */
+    uint32_t crc_update_clmul(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        if (size >= 64)
+        {
+            const uint64_t chunk_size = size & ~uint64_t{15};
+            crc = crc_fold_clmul(crc, data, chunk_size);
+            data += chunk_size;
+            size -= chunk_size;
+        }
+        return crc_update_slicing(crc, data, size);
+    }
+#endif
+
+    /// CRC中间状态累加函数类型
+    using crc_update_t = uint32_t (*)(uint32_t, const uint8_t*, uint64_t);
+
+    /**
+     * @brief 根据运行时CPU特性选择最快的实现
+     * @return 累加函数
+     */
+    crc_update_t select_crc_update()
+    {
+#ifdef DATA_BACK_UP_CRC_32_CLMUL
+        if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+        {
+            return crc_update_clmul;
+        }
+#endif
+        return crc_update_slicing;
+    }
+}
+
 uint32_t data_packet::CRC_calculate(const uint8_t* data, uint64_t size)
 {
-    return CRC_calculate(data, data+size);
+    return CRC_update(INIT, data, size) ^ FINALXOR;
+}
+
+uint32_t data_packet::CRC_update(uint32_t crc, const uint8_t* data, uint64_t size)
+{
+    static const crc_update_t update = select_crc_update();
+    return update(crc, data, size);
+}
+
+uint32_t data_packet::detail::CRC_update_portable(uint32_t crc, const uint8_t* data, uint64_t size)
+{
+    return crc_update_slicing(crc, data, size);
 }
 
 bool data_packet::CRC_verify(uint32_t CRC_code, const uint8_t* data, uint64_t size)
@@ -2,9 +2,14 @@
 #include <catch2/catch_test_macros.hpp>
 // 引入待测试的头文件
 #include "../../include/back_up/back_up.h"
+#include "../../include/local_packet/block_table.h"
+#include "../../include/packet/mapped_packet.h"
 // 辅助头文件
+#include <array>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -12,6 +17,16 @@
 namespace fs = std::filesystem;
 namespace dp = data_packet;
 
+namespace
+{
+    // 读取整个文件的内容
+    std::string read_all(const fs::path& path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        return std::string{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    }
+}
+
 // 测试套件：数据备份核心功能测试（修正destination为文件路径 + 前置清理）
 TEST_CASE("DataBackup Core Functionality Tests (Destination as File Path + Pre-Cleanup)", "[backup][restore][info]") {
     // ========== 新增：测试前置清理逻辑（核心修改点） ==========
@@ -113,6 +128,611 @@ TEST_CASE("DataBackup Core Functionality Tests (Destination as File Path + Pre-C
         }
     }
 
+    // ========== 小内存预算：每个文件单独成批写出 ==========
+    SECTION("Backup with a tiny memory budget") {
+        fs::path budget_backup_file = test_dest_dir / "budget_backup.backup";
+        dp::back_up_options options;
+        options.memory_budget = 1;
+
+        std::string backup_result = dp::back_up(
+            test_source_dir,
+            budget_backup_file,
+            "HUFFMAN",
+            "AES_256_CBC",
+            "budget",
+            "exclude_1.txt",
+            options
+        );
+        REQUIRE(backup_result == "OK");
+
+        fs::path budget_restore_dir = temp_root / "budget_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(budget_restore_dir));
+        REQUIRE(dp::restore_backup(budget_backup_file, budget_restore_dir, "budget") == "OK");
+
+        std::ifstream ifs_restored(budget_restore_dir / "subdir" / "include_2.txt");
+        std::string restored_content{std::istreambuf_iterator<char>(ifs_restored), std::istreambuf_iterator<char>()};
+        REQUIRE(restored_content == "This subdir file should be included in backup.");
+        REQUIRE_FALSE(fs::exists(budget_restore_dir / "exclude_1.txt"));
+    }
+
+    // ========== 多线程压缩：结果与单线程一致 ==========
+    SECTION("Parallel backup matches sequential backup") {
+        fs::path sequential_file = test_dest_dir / "sequential.backup";
+        fs::path parallel_file = test_dest_dir / "parallel.backup";
+        dp::back_up_options options;
+        options.memory_budget = 1 << 20;
+
+        options.thread_number = 1;
+        REQUIRE(dp::back_up(test_source_dir, sequential_file, "LZ77", "NONE", "", "", options) == "OK");
+        options.thread_number = 4;
+        REQUIRE(dp::back_up(test_source_dir, parallel_file, "LZ77", "NONE", "", "", options) == "OK");
+
+        // 除各级头部中的创建时间与校验和外，两份备份的大小与文件内容完全一致
+        REQUIRE(fs::file_size(sequential_file) == fs::file_size(parallel_file));
+        std::string sequential_info = dp::info(sequential_file);
+        std::string parallel_info = dp::info(parallel_file);
+        auto strip_time = [](const std::string& text)
+        {
+            auto begin = text.find("creation time:");
+            return text.substr(0, begin) + text.substr(text.find('\n', begin));
+        };
+        REQUIRE(strip_time(sequential_info) == strip_time(parallel_info));
+
+        fs::path parallel_restore_dir = temp_root / "parallel_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(parallel_restore_dir));
+        REQUIRE(dp::restore_backup(parallel_file, parallel_restore_dir, "") == "OK");
+        std::ifstream ifs_restored(parallel_restore_dir / "include_1.txt");
+        std::string restored_content{std::istreambuf_iterator<char>(ifs_restored), std::istreambuf_iterator<char>()};
+        REQUIRE(restored_content == "This file should be included in backup.");
+    }
+
+    // ========== 排除列表：排除的文件与目录在遍历时跳过，排除的目录不会被读取 ==========
+    SECTION("Excluded directories and patterns are skipped during traversal") {
+        fs::path cache_dir = include_subdir / ".cache";
+        REQUIRE_NOTHROW(fs::create_directories(cache_dir / "nested"));
+        std::ofstream(cache_dir / "nested" / "blob.bin") << "cached";
+        std::ofstream(include_subdir / "build.log") << "log";
+        std::ofstream(include_subdir / "keep.txt") << "keep";
+
+        // 不可读的目录被排除后不会被打开，备份依然成功
+        fs::path locked_dir = test_source_dir / "node_modules";
+        REQUIRE_NOTHROW(fs::create_directories(locked_dir / "pkg"));
+        fs::permissions(locked_dir, fs::perms::none);
+        const bool locked = !fs::directory_entry(locked_dir / "pkg").exists();
+
+        dp::back_up_options parallel;
+        parallel.thread_number = 4;
+        fs::path excluded_backup_file = test_dest_dir / "excluded.backup";
+        const auto result = dp::back_up(test_source_dir, excluded_backup_file, "LZ77", "NONE", "",
+                                        "exclude_1.txt\nsubdir/.cache/\n*.log\r\n./node_modules", parallel);
+        fs::permissions(locked_dir, fs::perms::owner_all);
+        REQUIRE(result == "OK");
+
+        std::set<std::string> names;
+        {
+            const dp::mapped_packet archive(excluded_backup_file);
+            for (const auto& record : archive.records())
+            {
+                names.insert(record.header->get_file_name());
+            }
+        }
+        CHECK(names == std::set<std::string>{"include_1.txt", "subdir", "subdir/include_2.txt", "subdir/keep.txt"});
+
+        // 目录确实不可读（非root用户）时，不排除它则遍历失败，说明排除的目录没有被打开
+        if (locked)
+        {
+            fs::permissions(locked_dir, fs::perms::none);
+            CHECK(dp::back_up(test_source_dir, excluded_backup_file, "LZ77", "NONE", "", "") != "OK");
+            fs::permissions(locked_dir, fs::perms::owner_all);
+        }
+    }
+
+    // ========== 部分还原：只还原选中的文件及其上级目录与硬链接目标 ==========
+    SECTION("Restore selected files") {
+        fs::path deep_dir = include_subdir / "deep";
+        REQUIRE_NOTHROW(fs::create_directories(deep_dir));
+        std::ofstream(deep_dir / "deep.log") << "deep log";
+        std::ofstream(include_subdir / "other.txt") << "other";
+        fs::create_hard_link(include_file1, test_source_dir / "link_to_include_1.txt");
+
+        fs::path selected_backup_file = test_dest_dir / "selected.backup";
+        REQUIRE(dp::back_up(test_source_dir, selected_backup_file, "HUFFMAN", "AES_256_CBC", "selected", "") == "OK");
+
+        // 通配符匹配任意层级的文件，只还原匹配的文件与所需的上级目录
+        fs::path glob_restore_dir = temp_root / "glob_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(glob_restore_dir));
+        REQUIRE(dp::restore_selected(selected_backup_file, glob_restore_dir, "selected", "*.log") == "OK");
+        std::ifstream ifs_log(glob_restore_dir / "subdir" / "deep" / "deep.log");
+        std::string log_content{std::istreambuf_iterator<char>(ifs_log), std::istreambuf_iterator<char>()};
+        REQUIRE(log_content == "deep log");
+        REQUIRE_FALSE(fs::exists(glob_restore_dir / "subdir" / "include_2.txt"));
+        REQUIRE_FALSE(fs::exists(glob_restore_dir / "include_1.txt"));
+
+        // 选中目录时还原其下全部内容；已存在的目录中的其余文件不受影响
+        REQUIRE(dp::restore_selected(selected_backup_file, glob_restore_dir, "selected", "./subdir/\n") == "OK");
+        REQUIRE(fs::exists(glob_restore_dir / "subdir" / "include_2.txt"));
+        REQUIRE(fs::exists(glob_restore_dir / "subdir" / "other.txt"));
+        REQUIRE(fs::exists(glob_restore_dir / "subdir" / "deep" / "deep.log"));
+        REQUIRE_FALSE(fs::exists(glob_restore_dir / "exclude_1.txt"));
+
+        // 硬链接的目标一并还原
+        fs::path link_restore_dir = temp_root / "link_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(link_restore_dir));
+        REQUIRE(dp::restore_selected(selected_backup_file, link_restore_dir, "selected", "link_to_include_1.txt") == "OK");
+        REQUIRE(fs::exists(link_restore_dir / "include_1.txt"));
+        REQUIRE(fs::exists(link_restore_dir / "link_to_include_1.txt"));
+        REQUIRE(fs::hard_link_count(link_restore_dir / "include_1.txt") == 2);
+
+        // 没有匹配的文件或密码错误时报错
+        REQUIRE_NOTHROW(fs::create_directories(temp_root / "none_restore_dir"));
+        REQUIRE(dp::restore_selected(selected_backup_file, temp_root / "none_restore_dir", "selected", "*.none") != "OK");
+        REQUIRE(dp::restore_selected(selected_backup_file, temp_root / "none_restore_dir", "wrong", "*.log") != "OK");
+        REQUIRE(dp::restore_selected(selected_backup_file, temp_root / "none_restore_dir", "selected", "") != "OK");
+    }
+
+    // ========== 分块编码：大文件按块独立压缩、加密，还原结果一致 ==========
+    SECTION("Chunked encoding of large files") {
+        // 约2.5 MiB的半可压缩数据，按64 KiB分块
+        std::string large(5 * 512 * 1024, '\0');
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < large.size(); ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            large[i] = (i / 4096) % 2 == 0 ? static_cast<char>('a' + i % 7) : static_cast<char>(seed >> 24);
+        }
+        std::ofstream(include_subdir / "large.bin", std::ios::binary) << large;
+        fs::create_hard_link(include_subdir / "large.bin", test_source_dir / "large_link.bin");
+
+        dp::back_up_options options;
+        options.chunk_size = dp::MIN_CHUNK_SIZE;
+        options.memory_budget = 4 * dp::MIN_CHUNK_SIZE;
+        options.thread_number = 4;
+
+        for (const auto& [compression, encryption] : {std::pair{"LZ77", "AES_256_CBC"}, std::pair{"HUFFMAN", "NONE"},
+                                                      std::pair{"NONE", "NONE"}, std::pair{"LZ77", "AES_256_GCM"}})
+        {
+            fs::path chunked_file = test_dest_dir / "chunked.backup";
+            REQUIRE(dp::back_up(test_source_dir, chunked_file, compression, encryption, "chunk", "", options) == "OK");
+            {
+                const dp::mapped_packet archive(chunked_file);
+                size_t chunked_number = 0;
+                for (const auto& record : archive.records())
+                {
+                    chunked_number += record.header->is_chunked() ? 1 : 0;
+                }
+                REQUIRE(chunked_number == 1);
+            }
+
+            fs::path chunked_restore_dir = temp_root / "chunked_restore_dir";
+            fs::remove_all(chunked_restore_dir);
+            REQUIRE_NOTHROW(fs::create_directories(chunked_restore_dir));
+            REQUIRE(dp::restore_backup(chunked_file, chunked_restore_dir, "chunk", options) == "OK");
+            REQUIRE(read_all(chunked_restore_dir / "subdir" / "large.bin") == large);
+            REQUIRE(fs::hard_link_count(chunked_restore_dir / "subdir" / "large.bin") == 2);
+            REQUIRE(read_all(chunked_restore_dir / "include_1.txt") == "This file should be included in backup.");
+
+            // 单线程还原与部分还原
+            fs::path selected_restore_dir = temp_root / "chunked_selected_dir";
+            fs::remove_all(selected_restore_dir);
+            REQUIRE_NOTHROW(fs::create_directories(selected_restore_dir));
+            REQUIRE(dp::restore_selected(chunked_file, selected_restore_dir, "chunk", "*.bin") == "OK");
+            REQUIRE(read_all(selected_restore_dir / "subdir" / "large.bin") == large);
+        }
+
+        // 数据块损坏时还原失败
+        fs::path chunked_file = test_dest_dir / "chunked.backup";
+        {
+            std::fstream corrupt(chunked_file, std::ios::in | std::ios::out | std::ios::binary);
+            const auto size = static_cast<std::streamoff>(fs::file_size(chunked_file));
+            corrupt.seekp(size / 2);
+            corrupt.put('\x5a');
+        }
+        fs::path corrupted_restore_dir = temp_root / "chunked_corrupted_dir";
+        REQUIRE_NOTHROW(fs::create_directories(corrupted_restore_dir));
+        REQUIRE(dp::restore_backup(chunked_file, corrupted_restore_dir, "chunk", options) != "OK");
+
+        // 块大小超出范围
+        options.chunk_size = 1024;
+        REQUIRE(dp::back_up(test_source_dir, chunked_file, "NONE", "NONE", "", "", options) != "OK");
+    }
+
+    SECTION("Incremental backup against a previous archive") {
+        auto data_entries = [](const fs::path& archive_file)
+        {
+            // 返回带有文件数据（不在基准备份中）的常规文件
+            std::set<std::string> names;
+            const dp::mapped_packet archive(archive_file);
+            for (const auto& record : archive.records())
+            {
+                if (record.header->get_file_type() == fs::file_type::regular && !record.has(dp::extra_tag::in_base))
+                {
+                    names.insert(record.header->get_file_name());
+                }
+            }
+            return names;
+        };
+
+        fs::path full_file = test_dest_dir / "full.backup";
+        REQUIRE(dp::back_up(test_source_dir, full_file, "LZ77", "AES_256_CBC", "inc", "") == "OK");
+
+        // 修改、新增、删除各一个文件；修改时间精确到秒，显式推后
+        std::ofstream(include_file2) << "This subdir file was modified after the full backup.";
+        fs::last_write_time(include_file2, fs::last_write_time(include_file2) + std::chrono::seconds(2));
+        std::ofstream(test_source_dir / "added.txt") << "This file was added after the full backup.";
+        fs::remove(exclude_file1);
+
+        dp::back_up_options options;
+        options.base_archive = full_file;
+        fs::path incremental_file = test_dest_dir / "incremental.backup";
+        REQUIRE(dp::back_up(test_source_dir, incremental_file, "LZ77", "AES_256_CBC", "inc", "", options) == "OK");
+        REQUIRE(data_entries(incremental_file) == std::set<std::string>{"subdir/include_2.txt", "added.txt"});
+        {
+            const dp::mapped_packet archive(incremental_file);
+            size_t deleted_number = 0;
+            for (const auto& record : archive.records())
+            {
+                if (record.header->get_file_type() == fs::file_type::not_found)
+                {
+                    REQUIRE(record.header->get_file_name() == "exclude_1.txt");
+                    ++deleted_number;
+                }
+            }
+            REQUIRE(deleted_number == 1);
+        }
+
+        // 第二次增量备份以第一次增量备份为基准，未变化时不含任何文件数据
+        fs::path second_file = test_dest_dir / "second.backup";
+        options.base_archive = incremental_file;
+        REQUIRE(dp::back_up(test_source_dir, second_file, "LZ77", "AES_256_CBC", "inc", "", options) == "OK");
+        REQUIRE(data_entries(second_file).empty());
+
+        // 依次在同一目录上还原完整备份与增量备份
+        fs::path incremental_restore_dir = temp_root / "incremental_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(incremental_restore_dir));
+        for (const auto& archive_file : {full_file, incremental_file, second_file})
+        {
+            REQUIRE(dp::restore_backup(archive_file, incremental_restore_dir, "inc") == "OK");
+        }
+        REQUIRE(read_all(incremental_restore_dir / "subdir" / "include_2.txt") ==
+                "This subdir file was modified after the full backup.");
+        REQUIRE(read_all(incremental_restore_dir / "added.txt") == "This file was added after the full backup.");
+        REQUIRE(read_all(incremental_restore_dir / "include_1.txt") == "This file should be included in backup.");
+        REQUIRE_FALSE(fs::exists(incremental_restore_dir / "exclude_1.txt"));
+
+        // 基准备份不能与目标相同
+        options.base_archive = second_file;
+        REQUIRE(dp::back_up(test_source_dir, second_file, "NONE", "NONE", "", "", options) != "OK");
+        REQUIRE(data_entries(second_file).empty());
+    }
+
+    SECTION("Deduplicating chunk store") {
+        auto chunk_number = [](const fs::path& store)
+        {
+            size_t number = 0;
+            for (const auto& entry : fs::recursive_directory_iterator(store))
+            {
+                number += entry.is_regular_file() ? 1 : 0;
+            }
+            return number;
+        };
+
+        // 约1 MiB的伪随机数据，另一份副本中间插入少量数据
+        std::string large(1024 * 1024, '\0');
+        uint32_t seed = 2026;
+        for (auto& c : large)
+        {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<char>(seed >> 24);
+        }
+        auto edited = large;
+        edited.insert(300 * 1024, "edited");
+        std::ofstream(include_subdir / "large.bin", std::ios::binary) << large;
+        std::ofstream(test_source_dir / "copy.bin", std::ios::binary) << large;
+
+        dp::back_up_options options;
+        options.chunk_store = temp_root / "chunk_store";
+        options.memory_budget = 512 * 1024;   // large.bin分段读取
+        options.thread_number = 4;
+
+        fs::path first_file = test_dest_dir / "dedup_1.backup";
+        REQUIRE(dp::back_up(test_source_dir, first_file, "LZ77", "AES_256_CBC", "dedup", "", options) == "OK");
+        const auto first_number = chunk_number(options.chunk_store);
+        REQUIRE(fs::file_size(first_file) < large.size() / 10);
+
+        // 完全相同的第二次备份不增加任何块，修改后的文件只增加插入位置附近的块
+        fs::path second_file = test_dest_dir / "dedup_2.backup";
+        REQUIRE(dp::back_up(test_source_dir, second_file, "LZ77", "AES_256_CBC", "dedup", "", options) == "OK");
+        REQUIRE(chunk_number(options.chunk_store) == first_number);
+
+        std::ofstream(test_source_dir / "copy.bin", std::ios::binary) << edited;
+        REQUIRE(dp::back_up(test_source_dir, second_file, "LZ77", "AES_256_CBC", "dedup", "", options) == "OK");
+        REQUIRE(chunk_number(options.chunk_store) > first_number);
+        REQUIRE(chunk_number(options.chunk_store) <= first_number + 3);
+
+        // 还原两个备份
+        for (const auto& [archive_file, copy] : {std::pair{first_file, large}, std::pair{second_file, edited}})
+        {
+            fs::path dedup_restore_dir = temp_root / "dedup_restore_dir";
+            fs::remove_all(dedup_restore_dir);
+            REQUIRE_NOTHROW(fs::create_directories(dedup_restore_dir));
+            REQUIRE(dp::restore_backup(archive_file, dedup_restore_dir, "dedup", options) == "OK");
+            REQUIRE(read_all(dedup_restore_dir / "subdir" / "large.bin") == large);
+            REQUIRE(read_all(dedup_restore_dir / "copy.bin") == copy);
+            REQUIRE(read_all(dedup_restore_dir / "include_1.txt") == "This file should be included in backup.");
+        }
+
+        // 没有块存储、密码错误时还原失败
+        fs::path failed_restore_dir = temp_root / "dedup_failed_dir";
+        REQUIRE_NOTHROW(fs::create_directories(failed_restore_dir));
+        REQUIRE(dp::restore_backup(second_file, failed_restore_dir, "dedup") != "OK");
+        REQUIRE(dp::restore_backup(second_file, failed_restore_dir, "wrong", options) != "OK");
+
+        // 加密块的密钥与标识由块存储根目录中的密钥派生参数派生：同样的数据与密码在另一个块存储中得到不同的块
+        REQUIRE(fs::is_regular_file(options.chunk_store / "kdf"));
+        auto other_options = options;
+        other_options.chunk_store = temp_root / "chunk_store_2";
+        fs::remove_all(other_options.chunk_store);
+        fs::path other_file = test_dest_dir / "dedup_3.backup";
+        REQUIRE(dp::back_up(test_source_dir, other_file, "LZ77", "AES_256_CBC", "dedup", "", other_options) == "OK");
+        for (const auto& entry : fs::recursive_directory_iterator(other_options.chunk_store))
+        {
+            if (entry.is_regular_file() && entry.path().filename() != "kdf")
+            {
+                REQUIRE_FALSE(fs::exists(options.chunk_store /
+                                         entry.path().lexically_relative(other_options.chunk_store)));
+            }
+        }
+
+        // 块存储中没有密钥派生参数时无法还原
+        fs::remove(other_options.chunk_store / "kdf");
+        REQUIRE(dp::restore_backup(other_file, failed_restore_dir, "dedup", other_options) ==
+                "chunk store has no key derivation parameters");
+    }
+
+    // ========== 不压缩存储：难以压缩的文件（或块）不压缩，还原结果一致 ==========
+    SECTION("Incompressible files fall back to stored mode") {
+        // 1 MiB伪随机数据无法压缩，同样大小的重复文本可以压缩
+        std::string random(1024 * 1024, '\0');
+        uint32_t seed = 7;
+        for (auto& c : random)
+        {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<char>(seed >> 24);
+        }
+        std::string text;
+        while (text.size() < random.size())
+        {
+            text += "stored mode is only used when compression does not pay off. ";
+        }
+        std::ofstream(include_subdir / "random.bin", std::ios::binary) << random;
+        std::ofstream(test_source_dir / "text.txt", std::ios::binary) << text;
+
+        for (const auto& [compression, chunk_size] : {std::pair{"LZ77", size_t{0}}, std::pair{"HUFFMAN", size_t{0}},
+                                                      std::pair{"LZ77", size_t{dp::MIN_CHUNK_SIZE}}})
+        {
+            dp::back_up_options options;
+            options.chunk_size = chunk_size;
+            options.memory_budget = 4 * dp::MIN_CHUNK_SIZE;
+            options.thread_number = 4;
+
+            fs::path stored_file = test_dest_dir / "stored.backup";
+            REQUIRE(dp::back_up(test_source_dir, stored_file, compression, "AES_256_CBC", "stored", "", options) == "OK");
+            {
+                const dp::mapped_packet archive(stored_file);
+                for (const auto& record : archive.records())
+                {
+                    const auto& name = record.header->get_file_name();
+                    if (name.ends_with("random.bin"))
+                    {
+                        REQUIRE(record.header->get_compression_method() ==
+                                dp::local_file_header::compression_method::None);
+                        REQUIRE(record.header->get_file_size() < random.size() + random.size() / 50);
+                    }
+                    else if (name.ends_with("text.txt"))
+                    {
+                        REQUIRE(record.header->get_compression_method() !=
+                                dp::local_file_header::compression_method::None);
+                    }
+                }
+            }
+
+            // 即使部分文件不压缩存储，备份信息仍报告所用的压缩方法
+            REQUIRE(dp::info(stored_file).find("compression method:NONE") == std::string::npos);
+            REQUIRE(dp::info(stored_file).find("encryption method:AES 256 CBC\n") != std::string::npos);
+
+            fs::path stored_restore_dir = temp_root / "stored_restore_dir";
+            fs::remove_all(stored_restore_dir);
+            REQUIRE_NOTHROW(fs::create_directories(stored_restore_dir));
+            REQUIRE(dp::restore_backup(stored_file, stored_restore_dir, "stored", options) == "OK");
+            REQUIRE(read_all(stored_restore_dir / "subdir" / "random.bin") == random);
+            REQUIRE(read_all(stored_restore_dir / "text.txt") == text);
+        }
+
+        // 分块编码时逐块判断：开头可以压缩、后面无法压缩的文件只有后面的块不压缩存储
+        {
+            fs::remove(include_subdir / "random.bin");
+            const auto mixed = text.substr(0, 4 * dp::MIN_CHUNK_SIZE) + random;
+            std::ofstream(test_source_dir / "mixed.bin", std::ios::binary) << mixed;
+
+            dp::back_up_options options;
+            options.chunk_size = dp::MIN_CHUNK_SIZE;
+            fs::path mixed_file = test_dest_dir / "mixed.backup";
+            REQUIRE(dp::back_up(test_source_dir, mixed_file, "LZ77", "AES_256_CBC", "stored", "", options) == "OK");
+            {
+                const dp::mapped_packet archive(mixed_file);
+                for (size_t i = 0; i < archive.records().size(); ++i)
+                {
+                    const auto& header = *archive.records()[i].header;
+                    if (header.get_file_name() != "mixed.bin")
+                    {
+                        continue;
+                    }
+                    REQUIRE(header.is_chunked());
+                    REQUIRE(header.get_compression_method() != dp::local_file_header::compression_method::None);
+                    REQUIRE(header.get_file_size() < random.size() + 8 * 1024);
+                    const auto payload = archive.data(i);
+                    const auto table = dp::block_table::parse(payload.data(), payload.size(),
+                                                              header.get_original_file_size());
+                    size_t stored = 0;
+                    for (const auto& block : table.blocks)
+                    {
+                        stored += block.stored ? 1 : 0;
+                    }
+                    REQUIRE(table.blocks.size() == 20);
+                    REQUIRE_FALSE(table.blocks.front().stored);
+                    REQUIRE(stored == 16);
+                }
+            }
+            fs::path mixed_restore_dir = temp_root / "mixed_restore_dir";
+            REQUIRE_NOTHROW(fs::create_directories(mixed_restore_dir));
+            REQUIRE(dp::restore_backup(mixed_file, mixed_restore_dir, "stored", options) == "OK");
+            REQUIRE(read_all(mixed_restore_dir / "mixed.bin") == mixed);
+            fs::remove(test_source_dir / "mixed.bin");
+        }
+
+        // 目录与空文件不会因为压缩结果比原始数据大而改为不压缩
+        std::ofstream(test_source_dir / "empty.txt").close();
+        fs::path small_file = test_dest_dir / "small.backup";
+        REQUIRE(dp::back_up(test_source_dir, small_file, "LZ77", "NONE", "", "text.txt") == "OK");
+        {
+            const dp::mapped_packet archive(small_file);
+            for (const auto& record : archive.records())
+            {
+                if (record.header->get_original_file_size() == 0)
+                {
+                    REQUIRE(record.header->get_compression_method() != dp::local_file_header::compression_method::None);
+                }
+            }
+        }
+        REQUIRE(dp::info(small_file).find("compression method:NONE") == std::string::npos);
+        fs::path small_restore_dir = temp_root / "small_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(small_restore_dir));
+        REQUIRE(dp::restore_backup(small_file, small_restore_dir, "") == "OK");
+        REQUIRE(fs::is_regular_file(small_restore_dir / "empty.txt"));
+        REQUIRE(fs::file_size(small_restore_dir / "empty.txt") == 0);
+
+        // 压缩比上限必须为正数
+        dp::back_up_options options;
+        options.max_compression_ratio = 0;
+        REQUIRE(dp::back_up(test_source_dir, test_dest_dir / "stored.backup", "LZ77", "NONE", "", "", options) != "OK");
+    }
+
+    SECTION("Long distance matching") {
+        // 同一段伪随机数据在文件中相隔1 MiB重复出现
+        auto random = [](size_t size, uint32_t seed)
+        {
+            std::string data(size, '\0');
+            for (auto& c : data)
+            {
+                seed = seed * 1103515245 + 12345;
+                c = static_cast<char>(seed >> 24);
+            }
+            return data;
+        };
+        const auto repeated = random(256 * 1024, 11);
+        const auto dump = repeated + random(1024 * 1024, 12) + repeated;
+        std::ofstream(include_subdir / "dump.bin", std::ios::binary) << dump;
+
+        dp::back_up_options options;
+        fs::path near_file = test_dest_dir / "near.backup";
+        REQUIRE(dp::back_up(test_source_dir, near_file, "LZ77", "NONE", "", "", options) == "OK");
+
+        options.long_distance_window_log = 21;
+        fs::path far_file = test_dest_dir / "far.backup";
+        REQUIRE(dp::back_up(test_source_dir, far_file, "LZ77", "NONE", "", "", options) == "OK");
+        // 默认参数下：没有长距离匹配时压缩没有收益而不压缩存储，启用后重复的部分被压缩
+        REQUIRE(fs::file_size(far_file) + repeated.size() * 3 / 4 < fs::file_size(near_file));
+        for (const auto& [archive_file, stored] : {std::pair{near_file, true}, std::pair{far_file, false}})
+        {
+            const dp::mapped_packet archive(archive_file);
+            for (const auto& record : archive.records())
+            {
+                if (record.header->get_file_name().ends_with("dump.bin"))
+                {
+                    CHECK((record.header->get_compression_method() ==
+                           dp::local_file_header::compression_method::None) == stored);
+                }
+            }
+        }
+
+        // 窗口大小记录在中央目录中
+        {
+            const dp::mapped_packet archive(far_file);
+            for (const auto& record : archive.records())
+            {
+                const auto window_log = dp::find_extra_field(record.extra, dp::extra_tag::window_log);
+                REQUIRE(window_log.has_value() == record.header->get_file_name().ends_with("dump.bin"));
+                if (window_log)
+                {
+                    CHECK(*window_log == std::string(1, '\x15'));
+                }
+            }
+        }
+        CHECK(dp::info(far_file).find("long distance window:2097152\n") != std::string::npos);
+        CHECK(dp::info(near_file).find("long distance window") == std::string::npos);
+
+        fs::path far_restore_dir = temp_root / "far_restore_dir";
+        fs::remove_all(far_restore_dir);
+        REQUIRE_NOTHROW(fs::create_directories(far_restore_dir));
+        REQUIRE(dp::restore_backup(far_file, far_restore_dir, "") == "OK");
+        REQUIRE(read_all(far_restore_dir / "subdir" / "dump.bin") == dump);
+
+        // 窗口超出范围
+        options.long_distance_window_log = 12;
+        REQUIRE(dp::back_up(test_source_dir, far_file, "LZ77", "NONE", "", "", options) != "OK");
+    }
+
+    SECTION("Compression levels") {
+        std::string text;
+        for (int i = 0; i < 20000; ++i)
+        {
+            text += "entry " + std::to_string(i * 7919 % 1000) + (i % 3 == 0 ? " archived\n" : " pending\n");
+        }
+        std::ofstream(test_source_dir / "levels.txt", std::ios::binary) << text;
+
+        dp::back_up_options options;
+        std::vector<uintmax_t> sizes;
+        for (const unsigned int level : {1u, 3u, 9u})
+        {
+            options.compression_level = level;
+            fs::path level_file = test_dest_dir / ("level_" + std::to_string(level) + ".backup");
+            REQUIRE(dp::back_up(test_source_dir, level_file, "LZ77", "NONE", "", "", options) == "OK");
+            sizes.push_back(fs::file_size(level_file));
+
+            // 压缩级别记录在中央目录中
+            {
+                const dp::mapped_packet archive(level_file);
+                for (const auto& record : archive.records())
+                {
+                    if (record.header->get_file_name() == "levels.txt")
+                    {
+                        CHECK(dp::find_extra_field(record.extra, dp::extra_tag::level) ==
+                              std::string(1, static_cast<char>(level)));
+                    }
+                }
+            }
+            CHECK(dp::info(level_file).find("compression level:" + std::to_string(level) + "\n") != std::string::npos);
+
+            fs::path level_restore_dir = temp_root / "level_restore_dir";
+            fs::remove_all(level_restore_dir);
+            REQUIRE_NOTHROW(fs::create_directories(level_restore_dir));
+            REQUIRE(dp::restore_backup(level_file, level_restore_dir, "") == "OK");
+            std::ifstream ifs(level_restore_dir / "levels.txt", std::ios::binary);
+            REQUIRE(std::string{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()} == text);
+        }
+        CHECK(sizes[2] < sizes[1]);
+        CHECK(sizes[1] < sizes[0]);
+
+        // 哈夫曼压缩不记录压缩级别；级别超出范围时备份失败
+        fs::path huffman_file = test_dest_dir / "level_huffman.backup";
+        REQUIRE(dp::back_up(test_source_dir, huffman_file, "HUFFMAN", "NONE", "", "", options) == "OK");
+        CHECK(dp::info(huffman_file).find("compression level") == std::string::npos);
+        options.compression_level = 10;
+        REQUIRE(dp::back_up(test_source_dir, huffman_file, "LZ77", "NONE", "", "", options) != "OK");
+        options.compression_level = 0;
+        REQUIRE(dp::back_up(test_source_dir, huffman_file, "LZ77", "NONE", "", "", options) != "OK");
+    }
+
     // ========== Test Case 4: 异常场景 - 源目录不存在 ==========
     SECTION("Exception: Source Directory Not Exists") {
         fs::path nonexist_source = temp_root / "nonexist_source_dir";
@@ -174,5 +794,54 @@ TEST_CASE("DataBackup Core Functionality Tests (Destination as File Path + Pre-C
             wrong_password
         );
         REQUIRE(wrong_pwd_restore_result != "OK");
+
+        // 密码校验值在解密任何文件之前发现错误的密码，目标目录保持为空
+        CHECK(wrong_pwd_restore_result == "Wrong password");
+        CHECK(fs::is_empty(wrong_pwd_restore_dir));
+        CHECK(dp::restore_selected(encrypted_backup_file, wrong_pwd_restore_dir, wrong_password, "*") ==
+              "Wrong password");
+        CHECK(dp::info(encrypted_backup_file).find("password check:yes") != std::string::npos);
+        CHECK(dp::verify_password(encrypted_backup_file, password) == "OK");
+        CHECK(dp::verify_password(encrypted_backup_file, wrong_password) == "Wrong password");
+
+        // 备份包的密钥只派生一次，各加密文件在本地文件头中记录各自的随机盐
+        CHECK(dp::info(encrypted_backup_file).find("key derivation:PBKDF2-SHA256 (200000 iterations)") !=
+              std::string::npos);
+        {
+            const dp::mapped_packet archive(encrypted_backup_file);
+            std::set<std::array<uint8_t, 16>> salts;
+            size_t encrypted = 0;
+            for (const auto& record : archive.records())
+            {
+                if (record.header->get_encryption_method() != dp::local_file_header::encryption_method::None)
+                {
+                    ++encrypted;
+                    CHECK(record.header->get_salt() != std::array<uint8_t, 16>{});
+                    salts.insert(record.header->get_salt());
+                }
+            }
+            CHECK(encrypted > 1);
+            CHECK(salts.size() == encrypted);
+        }
+
+        dp::back_up_options cheap_kdf;
+        cheap_kdf.kdf_iterations = 1000;
+        fs::path cheap_backup_file = test_dest_dir / "cheap_kdf_backup.backup";
+        REQUIRE(dp::back_up(test_source_dir, cheap_backup_file, "LZ77", "AES_256_GCM", password, "", cheap_kdf) ==
+                "OK");
+        CHECK(dp::info(cheap_backup_file).find("(1000 iterations)") != std::string::npos);
+        fs::path cheap_restore_dir = temp_root / "cheap_kdf_restore_dir";
+        REQUIRE_NOTHROW(fs::create_directories(cheap_restore_dir));
+        CHECK(dp::restore_backup(cheap_backup_file, cheap_restore_dir, password) == "OK");
+        CHECK(dp::restore_backup(cheap_backup_file, wrong_pwd_restore_dir, wrong_password) == "Wrong password");
+
+        cheap_kdf.kdf_iterations = 999;
+        CHECK(dp::back_up(test_source_dir, cheap_backup_file, "LZ77", "AES_256_CBC", password, "", cheap_kdf) ==
+              "kdf iterations is out of range.");
+
+        fs::path plain_backup_file = test_dest_dir / "plain_test_backup.backup";
+        REQUIRE(dp::back_up(test_source_dir, plain_backup_file, "LZ77", "NONE", "", "") == "OK");
+        CHECK(dp::info(plain_backup_file).find("password check") == std::string::npos);
+        CHECK(dp::verify_password(plain_backup_file, "anything") == "OK");
     }
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+//
+// Created by hyh on 2026/1/25.
+//
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../../include/dedup/chunk_store.h"
+#include "../../include/dedup/content_chunker.h"
+
+using namespace data_packet;
+
+namespace
+{
+    /**
+     * @brief 生成确定的伪随机数据
+     * @param size 数据大小
+     * @param seed 种子
+     * @return 数据
+     */
+    std::string make_data(size_t size, uint32_t seed)
+    {
+        std::string data(size, '\0');
+        for (auto& c : data)
+        {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<char>(seed >> 24);
+        }
+        return data;
+    }
+
+    /**
+     * @brief 切分数据，返回各块的内容
+     * @param chunker 分块器
+     * @param data 数据
+     * @return 各块的内容
+     */
+    std::vector<std::string> split(const content_chunker& chunker, const std::string& data)
+    {
+        std::vector<std::string> chunks;
+        for (size_t offset = 0; offset < data.size();)
+        {
+            const auto length = chunker.cut(data.data() + offset, data.size() - offset);
+            chunks.push_back(data.substr(offset, length));
+            offset += length;
+        }
+        return chunks;
+    }
+}
+
+TEST_CASE("content defined chunking", "[dedup][content_chunker]")
+{
+    const content_chunker chunker;
+    const auto data = make_data(4 * 1024 * 1024, 7);
+
+    SECTION("chunk sizes stay within bounds")
+    {
+        const auto chunks = split(chunker, data);
+        REQUIRE(chunks.size() > 16);
+        for (size_t i = 0; i + 1 < chunks.size(); ++i)
+        {
+            CHECK(chunks[i].size() > CDC_MIN_SIZE);
+            CHECK(chunks[i].size() <= CDC_MAX_SIZE);
+        }
+        CHECK(chunker.cut(data.data(), 100) == 100);
+    }
+
+    SECTION("boundaries survive an insertion")
+    {
+        auto shifted = data;
+        shifted.insert(1024 * 1024, "a few inserted bytes");
+
+        const auto before = split(chunker, data);
+        const auto after = split(chunker, shifted);
+        const std::set<std::string> known(before.begin(), before.end());
+        size_t reused = 0;
+        for (const auto& chunk : after)
+        {
+            reused += known.contains(chunk) ? 1 : 0;
+        }
+        // 只有插入位置附近的块发生变化
+        CHECK(reused + 2 >= after.size());
+    }
+
+    SECTION("invalid sizes")
+    {
+        CHECK_THROWS_AS(content_chunker(1024, 3000, 8192), std::invalid_argument);
+        CHECK_THROWS_AS(content_chunker(4096, 4096, 8192), std::invalid_argument);
+        CHECK_THROWS_AS(content_chunker(32, 1024, 8192), std::invalid_argument);
+    }
+}
+
+TEST_CASE("chunk store", "[dedup][chunk_store]")
+{
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "chunk_store_test";
+    fs::remove_all(root);
+
+    const chunk_store store(root);
+    const std::string chunk = "chunk content";
+    const auto id = chunk_store::make_id(chunk.data(), chunk.size());
+
+    SECTION("identifiers depend on the content and the key")
+    {
+        CHECK(id == chunk_store::make_id(chunk.data(), chunk.size()));
+        CHECK(id != chunk_store::make_id(chunk.data(), chunk.size() - 1));
+        CHECK(id != chunk_store::make_id(chunk.data(), chunk.size(), "key"));
+        CHECK(chunk_store::make_id(chunk.data(), chunk.size(), "key") !=
+              chunk_store::make_id(chunk.data(), chunk.size(), "key2"));
+    }
+
+    SECTION("key derivation parameters are saved once")
+    {
+        REQUIRE_FALSE(store.load_key_derivation().has_value());
+        CHECK(store.save_key_derivation("first") == "first");
+        CHECK(store.save_key_derivation("second") == "first");
+        CHECK(chunk_store(root).load_key_derivation() == "first");
+
+        // 只留下参数文件，没有临时文件
+        size_t files = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(root))
+        {
+            files += entry.is_regular_file() ? 1 : 0;
+        }
+        CHECK(files == 1);
+    }
+
+    SECTION("chunks are written once and read back")
+    {
+        REQUIRE_FALSE(store.contains(id));
+        store.put(id, local_file_header::compression_method::LZ77, local_file_header::encryption_method::None,
+                  static_cast<dword>(chunk.size()), "stored", 6);
+        REQUIRE(store.contains(id));
+        store.put(id, local_file_header::compression_method::None, local_file_header::encryption_method::None,
+                  static_cast<dword>(chunk.size()), chunk.data(), chunk.size());
+
+        const auto stored = store.get(id);
+        CHECK(stored.compression == local_file_header::compression_method::LZ77);
+        CHECK(stored.encryption == local_file_header::encryption_method::None);
+        CHECK(stored.original_size == chunk.size());
+        CHECK(std::string(stored.data.get(), stored.size) == "stored");
+
+        // 块文件损坏或缺失
+        {
+            std::fstream file(store.path_of(id), std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(-1, std::ios::end);
+            file.put('x');
+        }
+        CHECK_THROWS_AS(store.get(id), std::runtime_error);
+        CHECK_THROWS_AS(store.get(chunk_store::make_id("missing", 7)), std::runtime_error);
+    }
+
+    SECTION("reference lists")
+    {
+        const std::vector<chunk_reference> references{{id, 13}, {chunk_store::make_id("x", 1), 1}};
+        const auto list = chunk_reference::serialize(references);
+        REQUIRE(list.size() == 2 * chunk_reference::SIZE);
+
+        const auto parsed = chunk_reference::parse(list.data(), list.size(), 14);
+        REQUIRE(parsed.size() == 2);
+        CHECK(parsed[0].id == id);
+        CHECK(parsed[1].size == 1);
+        CHECK_THROWS_AS(chunk_reference::parse(list.data(), list.size(), 15), std::runtime_error);
+        CHECK_THROWS_AS(chunk_reference::parse(list.data(), list.size() - 1, 14), std::runtime_error);
+    }
+
+    fs::remove_all(root);
+}
@@ -6,6 +6,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <list>
+#include <vector>
+
 TEST_CASE("calculate and verify crc_32 code","[crc_32][utils]")
 {
     // 计算得到crc为0xC07A9F32
@@ -18,4 +21,36 @@ TEST_CASE("calculate and verify crc_32 code","[crc_32][utils]")
 
     result += 1;
     REQUIRE(!data_packet::CRC_verify(result, str.begin(), str.end()));
-}
\ No newline at end of file
+}
+
+TEST_CASE("accelerated crc_32 matches the byte table","[crc_32][utils]")
+{
+    // 覆盖小于64字节、非16整数倍及多个64字节块的长度，并使用非对齐的起始位置
+    std::vector<uint8_t> data(4096 + 17);
+    uint32_t seed = 12345;
+    for (auto& value : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<uint8_t>(seed >> 16);
+    }
+
+    for (size_t offset : {0, 1, 7})
+    {
+        for (size_t size : {0, 1, 15, 16, 63, 64, 65, 79, 80, 127, 128, 200, 1000, 4096})
+        {
+            const uint8_t* begin = data.data() + offset;
+            std::list<uint8_t> list(begin, begin + size);
+            const uint32_t expected = data_packet::CRC_calculate(list.begin(), list.end());
+
+            CHECK(data_packet::CRC_calculate(begin, size) == expected);
+            CHECK((data_packet::detail::CRC_update_portable(data_packet::INIT, begin, size)
+                   ^ data_packet::FINALXOR) == expected);
+
+            // 分段累加与一次计算结果相同
+            const size_t half = size / 3;
+            uint32_t crc = data_packet::CRC_update(data_packet::INIT, begin, half);
+            crc = data_packet::CRC_update(crc, begin + half, size - half);
+            CHECK((crc ^ data_packet::FINALXOR) == expected);
+        }
+    }
+}
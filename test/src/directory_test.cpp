@@ -0,0 +1,247 @@
+//
+// Created by hyh on 2026/1/20.
+//
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "../../include/packet/directory.h"
+#include "../../include/packet/mapped_packet.h"
+#include "../../include/packet/packet.h"
+#include "../../include/packet/packet_writer.h"
+#include "../../include/utils/crc_32.h"
+
+TEST_CASE("central directory lists entries without reading payloads", "[packet][directory]")
+{
+    namespace dp = data_packet;
+    namespace fs = std::filesystem;
+
+    fs::path root = fs::temp_directory_path() / "directory_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "dir");
+    std::ofstream(root / "a.txt") << "first file content";
+    std::ofstream(root / "dir" / "b.txt") << std::string(5000, 'b');
+    fs::create_symlink("a.txt", root / "link");
+
+    auto pkt = dp::make_packet(root);
+
+    std::stringstream streamed;
+    {
+        dp::packet_writer writer(streamed);
+        for (const auto& local_pkt : pkt.packets())
+        {
+            writer.write(local_pkt);
+        }
+        writer.finish();
+    }
+    const auto bytes = streamed.str();
+
+    SECTION("records match the written entries")
+    {
+        dp::file_header header;
+        auto records = dp::read_directory(streamed, header);
+
+        CHECK(header.get_version() == dp::ARCHIVE_EXTRA_VERSION);
+        REQUIRE(records.size() == pkt.packets().size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const auto& expected = pkt.packets()[i].info();
+            CHECK(records[i].header->get_file_name() == expected.get_file_name());
+            CHECK(records[i].header->get_link_name() == expected.get_link_name());
+            CHECK(records[i].header->get_file_size() == expected.get_file_size());
+            CHECK(records[i].header->get_crc_32() == expected.get_crc_32());
+
+            // 偏移处是同一个本地文件头
+            dp::local_file_header at_offset;
+            at_offset.set_buffer(bytes.data() + records[i].offset);
+            CHECK(at_offset.get_file_name() == expected.get_file_name());
+        }
+    }
+
+    SECTION("extra fields are stored in the records")
+    {
+        std::string extra;
+        dp::append_extra_field(extra, static_cast<dp::extra_tag>(0x7f), "unknown");
+        dp::append_extra_field(extra, dp::extra_tag::in_base);
+        CHECK(dp::find_extra_field(extra, dp::extra_tag::in_base) == std::string_view{});
+        CHECK_FALSE(dp::find_extra_field("", dp::extra_tag::in_base).has_value());
+        CHECK_THROWS_AS(dp::find_extra_field(extra.substr(0, 5), dp::extra_tag::in_base), std::runtime_error);
+
+        std::stringstream with_extra;
+        {
+            dp::packet_writer writer(with_extra);
+            writer.write(pkt.packets()[0], extra);
+            writer.write(pkt.packets()[1]);
+            writer.finish();
+        }
+        dp::file_header header;
+        const auto records = dp::read_directory(with_extra, header);
+        REQUIRE(records.size() == 2);
+        CHECK(records[0].has(dp::extra_tag::in_base));
+        CHECK_FALSE(records[1].has(dp::extra_tag::in_base));
+    }
+
+    SECTION("archive extra field follows the records")
+    {
+        std::string archive_extra;
+        dp::append_extra_field(archive_extra, dp::extra_tag::key_check, "check value");
+
+        std::stringstream with_extra;
+        {
+            dp::packet_writer writer(with_extra);
+            writer.write(pkt.packets()[0]);
+            writer.finish(archive_extra);
+        }
+        const auto archive_bytes = with_extra.str();
+
+        dp::file_header header;
+        std::string read_extra = "stale";
+        auto records = dp::read_directory(with_extra, header, &read_extra);
+        REQUIRE(records.size() == 1);
+        CHECK(read_extra == archive_extra);
+        CHECK(dp::find_extra_field(read_extra, dp::extra_tag::key_check) == "check value");
+
+        records = dp::read_directory(archive_bytes.data(), archive_bytes.size(), header, &read_extra);
+        CHECK(read_extra == archive_extra);
+
+        // 版本2的包没有包扩展字段
+        std::stringstream whole;
+        whole << pkt;
+        dp::read_directory(whole, header, &read_extra);
+        CHECK(read_extra.empty());
+
+        const fs::path archive_path = fs::temp_directory_path() / "directory_extra_test.backup";
+        std::ofstream(archive_path, std::ios::binary) << archive_bytes;
+        {
+            const dp::mapped_packet archive(archive_path);
+            CHECK(archive.archive_extra() == archive_extra);
+        }
+        fs::remove(archive_path);
+    }
+
+    SECTION("version 1 archives are scanned")
+    {
+        std::stringstream whole;
+        whole << pkt;
+
+        dp::file_header header;
+        auto records = dp::read_directory(whole, header);
+
+        CHECK(header.get_version() == 1);
+        REQUIRE(records.size() == pkt.packets().size());
+        dp::qword offset = dp::file_header::SIZE;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            CHECK(records[i].header->get_file_name() == pkt.packets()[i].info().get_file_name());
+            CHECK(records[i].offset == offset);
+            offset = records[i].end();
+        }
+    }
+
+    SECTION("corrupted directory")
+    {
+        auto corrupted = bytes;
+        corrupted[corrupted.size() - dp::directory_footer::SIZE - 1] ^= 0x55;
+        std::stringstream stream(corrupted);
+
+        dp::file_header header;
+        CHECK_THROWS_AS(dp::read_directory(stream, header), std::runtime_error);
+
+        std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+        CHECK_THROWS_AS(dp::read_directory(truncated, header), std::runtime_error);
+
+        // 偏移与大小之和溢出的尾部、结束位置溢出的记录都不能通过校验
+        const fs::path archive_path = fs::temp_directory_path() / "directory_overflow.backup";
+        auto check_rejected = [&](const std::string& content)
+        {
+            std::stringstream crafted(content);
+            CHECK_THROWS_AS(dp::read_directory(crafted, header), std::runtime_error);
+            std::ofstream(archive_path, std::ios::binary) << content;
+            CHECK_THROWS_AS(dp::mapped_packet(archive_path), std::runtime_error);
+        };
+
+        const size_t footer_position = bytes.size() - dp::directory_footer::SIZE;
+        dp::directory_footer footer;
+        REQUIRE(footer.parse(bytes.data() + footer_position));
+        {
+            auto crafted = bytes;
+            auto wrapped = footer;
+            wrapped.offset = dp::qword{1} << 63;
+            wrapped.size = (dp::qword{1} << 63) + bytes.size() - dp::directory_footer::SIZE;
+            wrapped.serialize(crafted.data() + footer_position);
+            check_rejected(crafted);
+        }
+        {
+            std::stringstream stream(bytes);
+            const auto records = dp::read_directory(stream, header);
+            const dp::qword length = records[0].end() - records[0].offset;
+
+            // 第一条记录的偏移使 偏移 + 头部大小 + 数据大小 回绕到包的开头
+            auto crafted = bytes;
+            const dp::qword offset = dp::file_header::SIZE - length;
+            for (size_t i = 0; i < 8; ++i)
+            {
+                crafted[footer.offset + i] = static_cast<char>(offset >> (56 - 8 * i));
+            }
+            auto resigned = footer;
+            resigned.crc_32 = dp::CRC_calculate(reinterpret_cast<const uint8_t*>(crafted.data() + footer.offset),
+                                                footer.size);
+            resigned.serialize(crafted.data() + footer_position);
+            check_rejected(crafted);
+        }
+        fs::remove(archive_path);
+    }
+
+    SECTION("mapped archive exposes payload views")
+    {
+        const fs::path archive_path = fs::temp_directory_path() / "directory_test.backup";
+        std::stringstream whole;
+        whole << pkt;
+        for (const auto& content : {bytes, whole.str()})
+        {
+            std::ofstream(archive_path, std::ios::binary) << content;
+
+            const dp::mapped_packet archive(archive_path);
+            REQUIRE(archive.records().size() == pkt.packets().size());
+            for (size_t i = 0; i < archive.records().size(); ++i)
+            {
+                const auto& expected = pkt.packets()[i];
+                CHECK(archive.records()[i].header->get_file_name() == expected.info().get_file_name());
+                const auto data = archive.data(i);
+                REQUIRE(data.size() == expected.info().get_file_size());
+                CHECK(std::equal(data.begin(), data.end(), expected.get_data().get()));
+                CHECK_NOTHROW(archive.verify(i));
+            }
+        }
+
+        // 文件数据损坏时校验失败，映射与中央目录仍可读取
+        auto corrupted = bytes;
+        const auto last = pkt.packets().size();
+        {
+            dp::file_header header;
+            std::stringstream stream(bytes);
+            const auto records = dp::read_directory(stream, header);
+            for (size_t i = 0; i < last; ++i)
+            {
+                if (records[i].header->get_file_size() > 0)
+                {
+                    corrupted[records[i].offset + records[i].header->header_size()] ^= 0x55;
+                    std::ofstream(archive_path, std::ios::binary) << corrupted;
+                    const dp::mapped_packet archive(archive_path);
+                    CHECK_THROWS_AS(archive.verify(i), std::runtime_error);
+                    break;
+                }
+            }
+        }
+
+        std::ofstream(archive_path, std::ios::binary) << bytes.substr(0, bytes.size() - 1);
+        CHECK_THROWS_AS(dp::mapped_packet(archive_path), std::runtime_error);
+        CHECK_THROWS_AS(dp::mapped_packet(root / "missing.backup"), std::runtime_error);
+        fs::remove(archive_path);
+    }
+
+    fs::remove_all(root);
+}
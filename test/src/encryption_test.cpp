@@ -72,4 +72,246 @@ TEST_CASE("Data Packet Encryption/Decryption", "[data_packet]") {
         std::cout<<"encrypt/decrypt is tested."<< std::endl;
 
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Streaming AES encryption", "[data_packet]") {
+    const std::string password = "PacketTestPassword";
+
+    // 旧版本的加密：手动PKCS7填充后再由EVP填充
+    auto legacy_encrypt = [&](const std::string& plaintext)
+    {
+        unsigned char key[AES_KEY_SIZE_256];
+        unsigned char iv[AES_BLOCK_SIZE];
+        encryption::generate_aes_key(password, key);
+        encryption::generate_iv(iv);
+        const std::string padded = encryption::pkcs7_pad(plaintext, AES_BLOCK_SIZE);
+
+        std::string ciphertext(AES_BLOCK_SIZE + padded.size() + AES_BLOCK_SIZE, '\0');
+        std::memcpy(ciphertext.data(), iv, AES_BLOCK_SIZE);
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        int length = 0;
+        int total = 0;
+        EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv);
+        EVP_EncryptUpdate(ctx, reinterpret_cast<unsigned char*>(&ciphertext[AES_BLOCK_SIZE]), &length,
+                          reinterpret_cast<const unsigned char*>(padded.data()), static_cast<int>(padded.size()));
+        total += length;
+        EVP_EncryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(&ciphertext[AES_BLOCK_SIZE + total]), &length);
+        total += length;
+        EVP_CIPHER_CTX_free(ctx);
+        ciphertext.resize(AES_BLOCK_SIZE + total);
+        return ciphertext;
+    };
+
+    std::string content;
+    for (int i = 0; i < 200000; ++i)
+    {
+        content.push_back(static_cast<char>(i * 31 + i / 7));
+    }
+
+    SECTION("output matches the legacy format") {
+        for (size_t size : {size_t{0}, size_t{1}, size_t{15}, size_t{16}, size_t{17}, size_t{100000}}) {
+            const std::string plaintext = content.substr(0, size);
+
+            const std::string legacy = legacy_encrypt(plaintext);
+            auto decrypted = data_packet::decrypt(legacy.begin(), legacy.end(), password);
+            REQUIRE(decrypted.first != nullptr);
+            CHECK(std::string(decrypted.first.get(), decrypted.second) == plaintext);
+
+            auto encrypted = data_packet::encrypt(plaintext.begin(), plaintext.end(), password);
+            CHECK(encrypted.second == legacy.size());
+            std::string restored;
+            REQUIRE(encryption::aes_decrypt(std::string(encrypted.first.get(), encrypted.second), password, restored));
+            CHECK(restored == plaintext);
+        }
+    }
+
+    SECTION("pieces of any size") {
+        for (size_t piece : {size_t{1}, size_t{5}, size_t{16}, size_t{33}, size_t{70000}}) {
+            encryption::cbc_encryptor encryptor(password);
+            std::vector<data_packet::byte> ciphertext(encryption::encrypted_size(content.size()));
+            std::memcpy(ciphertext.data(), encryptor.iv().data(), AES_BLOCK_SIZE);
+            size_t written = AES_BLOCK_SIZE;
+            for (size_t offset = 0; offset < content.size(); offset += piece) {
+                const size_t length = std::min(piece, content.size() - offset);
+                written += encryptor.update({content.data() + offset, length}, ciphertext.data() + written);
+            }
+            written += encryptor.finish(ciphertext.data() + written);
+            REQUIRE(written == ciphertext.size());
+
+            encryption::cbc_decryptor decryptor(password, std::span(ciphertext).first<AES_BLOCK_SIZE>());
+            std::vector<data_packet::byte> plaintext(ciphertext.size());
+            size_t produced = 0;
+            for (size_t offset = AES_BLOCK_SIZE; offset < ciphertext.size(); offset += piece) {
+                const size_t length = std::min(piece, ciphertext.size() - offset);
+                produced += decryptor.update({ciphertext.data() + offset, length}, plaintext.data() + produced);
+            }
+            produced += decryptor.finish(plaintext.data() + produced);
+            REQUIRE(produced == content.size());
+            CHECK(std::equal(content.begin(), content.end(), plaintext.begin()));
+        }
+    }
+
+    SECTION("truncated ciphertext is rejected") {
+        auto encrypted = data_packet::encrypt(content.data(), 100, password);
+        CHECK(data_packet::decrypt(encrypted.first.get(), encrypted.second - 1, password).first == nullptr);
+        CHECK(data_packet::decrypt(encrypted.first.get(), encrypted.second - AES_BLOCK_SIZE, password).first == nullptr);
+        CHECK(data_packet::decrypt(encrypted.first.get(), AES_BLOCK_SIZE, password).first == nullptr);
+    }
+}
+
+TEST_CASE("Parallel AES-GCM encryption", "[data_packet]") {
+    const std::string password = "PacketTestPassword";
+    std::string content;
+    for (int i = 0; i < 300000; ++i)
+    {
+        content.push_back(static_cast<char>(i * 13 + i / 11));
+    }
+
+    SECTION("chunks encrypted and decrypted on many threads") {
+        for (size_t size : {size_t{0}, size_t{1}, size_t{4096}, size_t{4097}, content.size()}) {
+            for (unsigned int threads : {1u, 4u}) {
+                std::vector<data_packet::byte> ciphertext(encryption::gcm_encrypted_size(size, 4096));
+                REQUIRE(encryption::gcm_encrypt_to({content.data(), size}, password, ciphertext.data(), threads, 4096) ==
+                        ciphertext.size());
+                REQUIRE(encryption::gcm_plaintext_size(ciphertext) == size);
+
+                std::vector<data_packet::byte> plaintext(size);
+                REQUIRE(encryption::gcm_decrypt_to(ciphertext, password, plaintext.data(), 5 - threads) == size);
+                CHECK(std::equal(plaintext.begin(), plaintext.end(), content.begin()));
+            }
+        }
+
+        auto encrypted = data_packet::gcm_encrypt(content.data(), content.size(), password, 0);
+        REQUIRE(encrypted.first != nullptr);
+        auto decrypted = data_packet::gcm_decrypt(encrypted.first.get(), encrypted.second, password, 0);
+        REQUIRE(decrypted.second == content.size());
+        CHECK(std::equal(content.begin(), content.end(), decrypted.first.get()));
+    }
+
+    SECTION("every chunk is authenticated") {
+        constexpr size_t chunk_size = 4096;
+        constexpr size_t stride = chunk_size + encryption::GCM_NONCE_SIZE + encryption::GCM_TAG_SIZE;
+        const size_t size = 3 * chunk_size + 100;
+        std::vector<data_packet::byte> ciphertext(encryption::gcm_encrypted_size(size, chunk_size));
+        encryption::gcm_encrypt_to({content.data(), size}, password, ciphertext.data(), 2, chunk_size);
+        std::vector<data_packet::byte> plaintext(size);
+
+        CHECK_THROWS(encryption::gcm_decrypt_to(ciphertext, "wrong_pass", plaintext.data(), 2));
+
+        auto tampered = ciphertext;
+        tampered[encryption::GCM_HEADER_SIZE + stride + 100] ^= 1;
+        CHECK_THROWS(encryption::gcm_decrypt_to(tampered, password, plaintext.data(), 2));
+
+        // 调换两个完整块
+        tampered = ciphertext;
+        std::swap_ranges(tampered.begin() + encryption::GCM_HEADER_SIZE,
+                         tampered.begin() + encryption::GCM_HEADER_SIZE + stride,
+                         tampered.begin() + encryption::GCM_HEADER_SIZE + stride);
+        CHECK_THROWS(encryption::gcm_decrypt_to(tampered, password, plaintext.data(), 2));
+
+        // 截掉最后一块后，剩余各块都不是最后一块
+        tampered.assign(ciphertext.begin(), ciphertext.begin() + encryption::GCM_HEADER_SIZE + 3 * stride);
+        CHECK_THROWS(encryption::gcm_decrypt_to(tampered, password, plaintext.data(), 2));
+
+        tampered.assign(ciphertext.begin(), ciphertext.end() - 1);
+        CHECK_THROWS(encryption::gcm_decrypt_to(tampered, password, plaintext.data(), 2));
+
+        CHECK(data_packet::gcm_decrypt(ciphertext.data(), 10, password).first == nullptr);
+    }
+}
+
+TEST_CASE("Password key check value", "[data_packet]") {
+    const std::string check = encryption::make_key_check("PacketTestPassword");
+    REQUIRE(check.size() == encryption::KEY_CHECK_SIZE);
+    CHECK(encryption::verify_key_check(check, "PacketTestPassword"));
+    CHECK_FALSE(encryption::verify_key_check(check, "PacketTestPassword2"));
+    CHECK_FALSE(encryption::verify_key_check(check, ""));
+
+    // 随机盐使相同密码的校验值不同
+    CHECK(encryption::make_key_check("PacketTestPassword") != check);
+
+    auto tampered = check;
+    tampered.back() ^= 1;
+    CHECK_FALSE(encryption::verify_key_check(tampered, "PacketTestPassword"));
+    CHECK_THROWS(encryption::verify_key_check(check.substr(1), "PacketTestPassword"));
+}
+
+
+TEST_CASE("Archive key derivation", "[data_packet]") {
+    const auto parameters = encryption::kdf_parameters::generate(encryption::MIN_KDF_ITERATIONS);
+    const auto key = encryption::derive_key("PacketTestPassword", parameters);
+
+    SECTION("parameters survive serialization") {
+        const auto serialized = parameters.serialize();
+        REQUIRE(serialized.size() == encryption::kdf_parameters::SIZE);
+        const auto parsed = encryption::kdf_parameters::parse(serialized);
+        CHECK(parsed.iterations == parameters.iterations);
+        CHECK(parsed.salt == parameters.salt);
+        CHECK(encryption::derive_key("PacketTestPassword", parsed) == key);
+
+        CHECK_THROWS(encryption::kdf_parameters::parse(serialized.substr(1)));
+        auto unknown = serialized;
+        unknown[0] = 2;
+        CHECK_THROWS(encryption::kdf_parameters::parse(unknown));
+        CHECK_THROWS(encryption::kdf_parameters::generate(encryption::MIN_KDF_ITERATIONS - 1));
+    }
+
+    SECTION("key depends on password, salt and iterations") {
+        CHECK(encryption::derive_key("PacketTestPassword2", parameters) != key);
+        CHECK(key != encryption::password_key("PacketTestPassword"));
+
+        auto other = parameters;
+        other.salt[0] ^= 1;
+        CHECK(encryption::derive_key("PacketTestPassword", other) != key);
+        other = parameters;
+        ++other.iterations;
+        CHECK(encryption::derive_key("PacketTestPassword", other) != key);
+
+        // 由新的随机盐派生的密钥不同
+        const auto regenerated = encryption::kdf_parameters::generate(encryption::MIN_KDF_ITERATIONS);
+        CHECK(encryption::derive_key("PacketTestPassword", regenerated) != key);
+    }
+
+    SECTION("subkeys encrypt independently") {
+        std::array<unsigned char, encryption::KDF_SALT_SIZE> salt{};
+        const auto first = encryption::derive_subkey(key, salt);
+        salt[15] = 1;
+        const auto second = encryption::derive_subkey(key, salt);
+        CHECK(first != second);
+        CHECK(first != key);
+        CHECK(encryption::derive_subkey(key, salt) == second);
+
+        const std::string message = "hello subkey";
+        auto encrypted = data_packet::encrypt(message.data(), message.size(), first);
+        REQUIRE(encrypted.first != nullptr);
+        auto decrypted = data_packet::decrypt(encrypted.first.get(), encrypted.second, first);
+        REQUIRE(decrypted.first != nullptr);
+        CHECK(std::string(decrypted.first.get(), decrypted.second) == message);
+        CHECK(data_packet::decrypt(encrypted.first.get(), encrypted.second, second).first == nullptr);
+
+        auto sealed = data_packet::gcm_encrypt(message.data(), message.size(), second);
+        REQUIRE(sealed.first != nullptr);
+        CHECK(data_packet::gcm_decrypt(sealed.first.get(), sealed.second, second).second == message.size());
+        CHECK(data_packet::gcm_decrypt(sealed.first.get(), sealed.second, first).first == nullptr);
+
+        const auto check = encryption::make_key_check(key);
+        CHECK(encryption::verify_key_check(check, key));
+        CHECK_FALSE(encryption::verify_key_check(check, first));
+    }
+
+    SECTION("key check does not reveal subkeys") {
+        // 校验值与子密钥使用不同的标签：同一个盐得到的校验值不是子密钥的前缀
+        const auto check = encryption::make_key_check(key);
+        REQUIRE(check.size() == encryption::KEY_CHECK_SIZE);
+        std::array<unsigned char, encryption::KDF_SALT_SIZE> salt{};
+        std::memcpy(salt.data(), check.data(), salt.size());
+        const auto subkey = encryption::derive_subkey(key, salt);
+        CHECK(std::memcmp(subkey.data(), check.data() + encryption::KDF_SALT_SIZE, encryption::KDF_SALT_SIZE) != 0);
+
+        const auto labeled = encryption::derive_subkey(key, "chunk-id");
+        CHECK(labeled != key);
+        CHECK(labeled != subkey);
+        CHECK(encryption::derive_subkey(key, "chunk-id") == labeled);
+        CHECK(encryption::derive_subkey(key, "chunk-id2") != labeled);
+    }
+}
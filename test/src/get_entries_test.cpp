@@ -4,6 +4,8 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_session.hpp>
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <set>
@@ -68,16 +70,16 @@ TEST_CASE("Linux get_entries tests", "[data_packet][file_system]") {
         REQUIRE(entries.size() == 6);
 
         // 验证普通文件存在
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file1.txt")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file1.txt")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
 
         // 验证隐藏文件存在
-        CHECK(entries.count(fs::directory_entry(test_dir / ".hidden_file")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / ".config")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".hidden_file")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".config")) == 1);
 
         // 验证子目录
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 1);
     }
 
     SECTION("Handle non-existent path") {
@@ -98,7 +100,7 @@ TEST_CASE("Linux get_entries tests", "[data_packet][file_system]") {
         fs::create_symlink(test_dir / "normal_file1.txt", link_path);
 
         auto entries = get_entries(test_dir);
-        CHECK(entries.count(fs::directory_entry(link_path)) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(link_path)) == 1);
     }
 
     SECTION("Filter test")
@@ -109,34 +111,101 @@ TEST_CASE("Linux get_entries tests", "[data_packet][file_system]") {
         REQUIRE(entries.size() == 6);
 
         // 验证普通文件存在
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file1.txt")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file1.txt")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
 
         // 验证隐藏文件存在
-        CHECK(entries.count(fs::directory_entry(test_dir / ".hidden_file")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / ".config")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".hidden_file")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".config")) == 1);
 
         // 验证子目录
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 1);
 
         entries = get_entries(test_dir,
             [](const std::filesystem::directory_entry& entry)
             {return entry.path().string().find(".txt") != std::string::npos; });
 
         // 验证普通文件部分存在
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file1.txt")) == 0);
-        CHECK(entries.count(fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file1.txt")) == 0);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "normal_file2.dat")) == 1);
 
         // 验证隐藏文件存在
-        CHECK(entries.count(fs::directory_entry(test_dir / ".hidden_file")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / ".config")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".hidden_file")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / ".config")) == 1);
 
         // 验证子目录，文件部分存在
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory")) == 1);
-        CHECK(entries.count(fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 0);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 0);
 
     }
 
+    SECTION("Parallel traversal is deterministic")
+    {
+        // 构造较宽且较深的目录树，使多个线程之间发生窃取
+        for (int i = 0; i < 8; ++i)
+        {
+            auto branch = test_dir / ("branch_" + std::to_string(i));
+            for (int depth = 0; depth < 4; ++depth)
+            {
+                branch /= "level_" + std::to_string(depth);
+                fs::create_directories(branch);
+                std::ofstream(branch / "leaf.txt").put('f');
+            }
+        }
+
+        const auto sequential = get_entries(test_dir);
+        REQUIRE(sequential.size() == 6 + 8 * (1 + 4 * 2));
+        CHECK(std::ranges::is_sorted(sequential));
+        for (const unsigned int threads : {2u, 4u, 0u})
+        {
+            CHECK(get_entries(test_dir, threads) == sequential);
+        }
+
+        // 父目录总在其中的文件之前
+        for (size_t i = 0; i < sequential.size(); ++i)
+        {
+            const auto parent = sequential[i].path().parent_path();
+            if (parent != test_dir)
+            {
+                const auto it = std::ranges::find(sequential, fs::directory_entry(parent));
+                REQUIRE(it != sequential.end());
+                CHECK(static_cast<size_t>(it - sequential.begin()) < i);
+            }
+        }
+    }
+
+    SECTION("Filter removes adjacent entries")
+    {
+        // 相邻的被过滤文件都应被移除
+        auto entries = get_entries(test_dir,
+            [](const std::filesystem::directory_entry& entry)
+            {return entry.path().filename().string().starts_with(".") ||
+                    entry.path().filename().string().starts_with("normal"); }, 2);
+        CHECK(entries.size() == 2);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory")) == 1);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 1);
+    }
+
+    SECTION("Filtered directories are not descended into")
+    {
+        fs::create_directories(test_dir / "subdirectory" / "nested");
+        std::ofstream(test_dir / "subdirectory" / "nested" / "deep.txt").put('g');
+
+        std::atomic<size_t> calls{0};
+        auto entries = get_entries(test_dir,
+            [&](const std::filesystem::directory_entry& entry)
+            {
+                ++calls;
+                return entry.path().filename() == "subdirectory";
+            }, 2);
+
+        // 被排除的目录及其下的全部内容都不在结果中，其中的文件也不会交给过滤器
+        CHECK(entries.size() == 4);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory")) == 0);
+        CHECK(std::ranges::count(entries, fs::directory_entry(test_dir / "subdirectory" / "subfile.txt")) == 0);
+        CHECK(calls == 5);
+    }
+
     cleanup();
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <cstring>
 #include <algorithm>
 #include <utility>
+#include <list>
+#include <stdexcept>
+#include <tuple>
 #include "../../include/compression_method/huffman.h"
 
 using namespace data_packet;
@@ -49,12 +52,12 @@ TEST_CASE("Huffman Coding Generation", "[huffman_code]") {
         huff.times['x'] = 1;
         huff.times['y'] = 1;
         auto tree = huff.Create_Huffman_Tree();
-        huff.encoding_dfs(tree.get(), "");
+        huff.encoding_dfs(tree.get());
         
         // 两个字符应该生成长度为1的不同编码
-        REQUIRE(huff.Huffman_coding['x'].size() == 1);
-        REQUIRE(huff.Huffman_coding['y'].size() == 1);
-        REQUIRE(huff.Huffman_coding['x'] != huff.Huffman_coding['y']);
+        REQUIRE(huff.Huffman_coding['x'].length == 1);
+        REQUIRE(huff.Huffman_coding['y'].length == 1);
+        REQUIRE(huff.Huffman_coding['x'].code != huff.Huffman_coding['y'].code);
     }
 
     SECTION("Uneven frequencies") {
@@ -68,8 +71,8 @@ TEST_CASE("Huffman Coding Generation", "[huffman_code]") {
         huff.times['h'] = 1;
         
         auto tree = huff.Create_Huffman_Tree();
-        huff.encoding_dfs(tree.get(), "");
-        REQUIRE(huff.Huffman_coding['a'].size() <= huff.Huffman_coding['b'].size());
+        huff.encoding_dfs(tree.get());
+        REQUIRE(huff.Huffman_coding['a'].length <= huff.Huffman_coding['b'].length);
     }
 }
 
@@ -126,6 +129,59 @@ TEST_CASE("Huffman Compression and Decompression", "[huffman_io]") {
     }
 }
 
+TEST_CASE("Huffman table decoding", "[huffman_io]") {
+    SECTION("Codes longer than the lookup table") {
+        // 斐波那契词频使哈夫曼树退化为链，最长编码远超查找表位数
+        std::vector<byte> input;
+        size_t a = 1, b = 1;
+        for (int symbol = 0; symbol < 22; ++symbol) {
+            input.insert(input.end(), a, static_cast<byte>('a' + symbol));
+            std::tie(a, b) = std::make_pair(b, a + b);
+        }
+        std::rotate(input.begin(), input.begin() + input.size() / 3, input.end());
+
+        auto [compressed, comp_size] = Huffman_compress(input.begin(), input.end());
+        auto [decompressed, decom_size] = Huffman_decompress(compressed.get(), comp_size);
+
+        REQUIRE(decom_size == input.size());
+        REQUIRE(compare_bytes(decompressed.get(), decompressed.get() + decom_size,
+                            input.begin(), input.end()));
+    }
+
+    SECTION("Bit layout") {
+        // 'b'编码为0，'a'编码为1，"aab"编码为110，补5位
+        const std::string input = "aab";
+        auto [compressed, comp_size] = Huffman_compress(input.begin(), input.end());
+
+        REQUIRE(comp_size == 2050);
+        CHECK(compressed[0] == 5);
+        CHECK(compressed[1 + 'a' * 8 + 7] == 2);
+        CHECK(compressed[1 + 'b' * 8 + 7] == 1);
+        CHECK(static_cast<uint8_t>(compressed[2049]) == 0xC0);
+    }
+
+    SECTION("Non-contiguous input") {
+        const std::string input = "table driven decoder";
+        auto [compressed, comp_size] = Huffman_compress(input.begin(), input.end());
+        std::list<byte> list(compressed.get(), compressed.get() + comp_size);
+        auto [decompressed, decom_size] = Huffman_decompress(list.begin(), list.end());
+
+        REQUIRE(std::string(decompressed.get(), decom_size) == input);
+    }
+
+    SECTION("Truncated or corrupted data") {
+        const std::string input = "Hello, Huffman Compression! This is a test string with various characters...";
+        auto [compressed, comp_size] = Huffman_compress(input.begin(), input.end());
+
+        CHECK_THROWS_AS(Huffman_decompress(compressed.get(), comp_size - 4), std::runtime_error);
+        CHECK_THROWS_AS(Huffman_decompress(compressed.get(), 100), std::runtime_error);
+
+        // 词频总和超过数据位数
+        compressed[1] = static_cast<byte>(0x7f);
+        CHECK_THROWS_AS(Huffman_decompress(compressed.get(), comp_size), std::runtime_error);
+    }
+}
+
 TEST_CASE("Huffman Compression Ratio", "[huffman_ratio]") {
     SECTION("High redundancy data") {
         const std::string input(1024, 'A');  // 高冗余数据应压缩
@@ -143,4 +199,97 @@ TEST_CASE("Huffman Compression Ratio", "[huffman_ratio]") {
         // 包含所有字节类型时，头信息2049字节+数据可能膨胀
         REQUIRE(comp_size > 1024);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Canonical Huffman", "[huffman_io][canonical_huffman]") {
+    auto round_trip = [](const std::vector<byte>& input) {
+        auto [compressed, comp_size] = canonical_Huffman_compress(input.begin(), input.end());
+        auto [decompressed, decom_size] = canonical_Huffman_decompress(compressed.get(), compressed.get() + comp_size);
+        REQUIRE(decom_size == input.size());
+        REQUIRE(compare_bytes(decompressed.get(), decompressed.get() + decom_size, input.begin(), input.end()));
+        return comp_size;
+    };
+
+    SECTION("Round trip") {
+        CHECK(round_trip({}) == 1);
+        CHECK(round_trip(std::vector<byte>(1000, 'x')) < 1000 / 8 + 16);
+        round_trip({'a'});
+
+        std::vector<byte> all(4096);
+        for (size_t i = 0; i < all.size(); ++i) {
+            all[i] = static_cast<byte>(i * 7 % 256);
+        }
+        // 256个字符各出现16次，每个码长为8位
+        CHECK(round_trip(all) == 2 + 1 + 128 + all.size());
+
+        uint32_t seed = 1;
+        std::vector<byte> text(100000);
+        for (auto& c : text) {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<byte>("etaoin shrdlu"[(seed >> 16) % 13]);
+        }
+        CHECK(round_trip(text) < text.size() / 2);
+    }
+
+    SECTION("Header is much smaller than the frequency table") {
+        const std::string input = "Hello, Huffman Compression! This is a small file.";
+        auto [canonical, canonical_size] = canonical_Huffman_compress(input.begin(), input.end());
+        auto [full, full_size] = Huffman_compress(input.begin(), input.end());
+        CHECK(canonical_size < 64);
+        CHECK(canonical_size + 2000 < full_size);
+    }
+
+    SECTION("Bit layout") {
+        // 码长 a:1 b:1，范式编码a为0，b为1："aab"编码为001
+        const std::string input = "aab";
+        auto [compressed, comp_size] = canonical_Huffman_compress(input.begin(), input.end());
+        const std::vector<uint8_t> expected = {
+            3,                                          // 原始长度
+            'b',                                        // 最大字符
+            0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x00,   // 字符0~96未出现：6个16字符的游程与1个1字符的游程
+            0x11,                                       // a、b的码长
+            0x20,                                       // 编码数据001，补5位
+        };
+        REQUIRE(comp_size == expected.size());
+        CHECK(std::equal(expected.begin(), expected.end(), reinterpret_cast<const uint8_t*>(compressed.get())));
+    }
+
+    SECTION("Code lengths are limited") {
+        // 斐波那契词频使哈夫曼树退化为链，码长超过上限时需要减小词频后重建
+        std::vector<byte> input;
+        size_t a = 1, b = 1;
+        for (int symbol = 0; symbol < 22; ++symbol) {
+            input.insert(input.end(), a, static_cast<byte>('a' + symbol));
+            std::tie(a, b) = std::make_pair(b, a + b);
+        }
+        std::rotate(input.begin(), input.begin() + input.size() / 3, input.end());
+        round_trip(input);
+    }
+
+    SECTION("Non-contiguous input") {
+        const std::string input = "table driven decoder";
+        std::list<byte> list(input.begin(), input.end());
+        auto [compressed, comp_size] = canonical_Huffman_compress(list.begin(), list.end());
+        std::list<byte> compressed_list(compressed.get(), compressed.get() + comp_size);
+        auto [decompressed, decom_size] = canonical_Huffman_decompress(compressed_list.begin(), compressed_list.end());
+        REQUIRE(std::string(decompressed.get(), decom_size) == input);
+    }
+
+    SECTION("Truncated or corrupted data") {
+        const std::string input = "Hello, Huffman Compression! This is a test string with various characters...";
+        auto [compressed, comp_size] = canonical_Huffman_compress(input.begin(), input.end());
+
+        CHECK_THROWS_AS(canonical_Huffman_decompress(compressed.get(), compressed.get() + comp_size - 4),
+                        std::runtime_error);
+        CHECK_THROWS_AS(canonical_Huffman_decompress(compressed.get(), compressed.get() + 3), std::runtime_error);
+
+        // 原始长度超过数据位数
+        auto corrupted = std::vector<byte>(compressed.get(), compressed.get() + comp_size);
+        corrupted[0] = static_cast<byte>(0x7f);
+        CHECK_THROWS_AS(canonical_Huffman_decompress(corrupted.begin(), corrupted.end()), std::runtime_error);
+
+        // 码长不满足前缀码条件
+        const std::vector<byte> invalid = {2, 2, 0x11, 0x10, 0x00};
+        CHECK_THROWS_AS(canonical_Huffman_decompress(invalid.begin(), invalid.end()), std::runtime_error);
+    }
+}
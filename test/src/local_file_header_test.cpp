@@ -117,6 +117,29 @@ TEST_CASE("local_file_header set and get methods", "[local_file_header]") {
 
         CHECK(header.get_compression_method() == comp_method::None);
         CHECK(header.get_encryption_method() == enc_method::None);
+
+        // 分块编码标志与压缩、加密方法互不影响
+        CHECK_FALSE(header.is_chunked());
+        header.set_chunked(true);
+        header.set_compression_method(comp_method::HUFFMAN);
+        header.set_encryption_method(enc_method::AES_256_CBC);
+        CHECK(header.is_chunked());
+        CHECK(header.get_compression_method() == comp_method::HUFFMAN);
+        CHECK(header.get_encryption_method() == enc_method::AES_256_CBC);
+        header.set_chunked(false);
+        CHECK_FALSE(header.is_chunked());
+        CHECK(header.get_compression_method() == comp_method::HUFFMAN);
+
+        header.set_compression_method(comp_method::CANONICAL_HUFFMAN);
+        CHECK(header.get_compression_method() == comp_method::CANONICAL_HUFFMAN);
+        CHECK(header.get_encryption_method() == enc_method::AES_256_CBC);
+
+        header.set_compression_method(comp_method::LZ77_SEQUENCE);
+        CHECK(header.get_compression_method() == comp_method::LZ77_SEQUENCE);
+        header.set_encryption_method(enc_method::AES_256_GCM);
+        CHECK(header.get_encryption_method() == enc_method::AES_256_GCM);
+        CHECK(header.get_compression_method() == comp_method::LZ77_SEQUENCE);
+        CHECK(header.is_chunked() == false);
     }
 
     SECTION("Salt operations") {
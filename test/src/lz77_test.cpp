@@ -4,6 +4,7 @@
 
 #include "../../include/compression_method/lz77.h"
 #include <fstream>
+#include <list>
 #include <iostream>
 #include <sstream>
 #include <catch2/catch_test_macros.hpp>
@@ -12,46 +13,78 @@ TEST_CASE("compression position test","[lz77][compression]")
 {
     using namespace data_packet;
 
+    // 将content加入索引后，查找紧随其后的pattern
+    auto find = [](const std::string& content, const std::string& pattern)
+    {
+        static std::string buffer;
+        buffer = content + pattern;
+        detail::match_finder finder(buffer.data(), buffer.data() + buffer.size());
+        for (size_t i = 0; i < content.size(); ++i)
+        {
+            finder.insert(buffer.data() + i);
+        }
+        return finder.find(buffer.data() + content.size());
+    };
+
     std::string content{"abcabcdaaabcdddabc"};
     std::string pattern{"abcd"};
 
-    auto info = detail::compression_tuple
-    ({content.begin(),content.end()},{pattern.begin(),pattern.end()},'x');
-
-    CHECK(std::get<0>(info) == 9);
-    CHECK(std::get<1>(info) == 4);
-    CHECK(std::get<2>(info) == 'x');
+    auto info = find(content, pattern);
+    CHECK(info.first == 9);
+    CHECK(info.second == 4);
 
     pattern.pop_back();
-    info = detail::compression_tuple
-    ({content.begin(),content.end()},{pattern.begin(),pattern.end()},'x');
-
-    CHECK(std::get<0>(info) == 3);
-    CHECK(std::get<1>(info) == 3);
-    CHECK(std::get<2>(info) == 'x');
+    info = find(content, pattern);
+    CHECK(info.first == 3);
+    CHECK(info.second == 3);
 
     pattern.pop_back();
-    info = detail::compression_tuple
-    ({content.begin(),content.end()},{pattern.begin(),pattern.end()},'x');
-
-    CHECK(std::get<0>(info) == 3);
-    CHECK(std::get<1>(info) == 2);
-    CHECK(std::get<2>(info) == 'x');
+    info = find(content, pattern);
+    CHECK(info.first == 3);
+    CHECK(info.second == 2);
 
     pattern = "abcde";
-    info = detail::compression_tuple
-    ({content.begin(),content.end()},{pattern.begin(),pattern.end()},'x');
-    CHECK(std::get<0>(info) == 9);
-    CHECK(std::get<1>(info) == 4);
-    CHECK(std::get<2>(info) == 'e');
+    info = find(content, pattern);
+    CHECK(info.first == 9);
+    CHECK(info.second == 4);
 
+    pattern = "xyz";
+    info = find(content, pattern);
+    CHECK(info.first == 0);
+    CHECK(info.second == 0);
+
+    // 匹配长度不超过偏移
     content = "aaaaa";
     pattern = "aaaaaaaaaaaa";
-    info = detail::compression_tuple
-    ({content.begin(),content.end()},{pattern.begin(),pattern.end()},'x');
-    CHECK(std::get<0>(info) == 5);
-    CHECK(std::get<1>(info) == 5);
-    CHECK(std::get<2>(info) == 'a');
+    info = find(content, pattern);
+    CHECK(info.first == 5);
+    CHECK(info.second == 5);
+
+    SECTION("full length match in the middle of the data")
+    {
+        content.clear();
+        for (int i = 0; i < 1000; ++i)
+        {
+            content.push_back(static_cast<char>('a' + i % 7 + i / 300));
+        }
+        content += std::string(600, 'z') + "tail";
+
+        auto result = lz77_compress(content.begin(),content.end());
+        auto str = lz77_decompress(result.first.get(),result.first.get() + result.second);
+
+        REQUIRE(str.second == content.size());
+        CHECK(std::string(str.first.get(),str.second) == content);
+        CHECK(result.second < content.size());
+    }
+
+    SECTION("non-contiguous input")
+    {
+        std::list<char> list{'a','b','a','b','a','b','c'};
+        auto result = lz77_compress(list.begin(),list.end());
+        auto str = lz77_decompress(result.first.get(),result.first.get() + result.second);
+
+        CHECK(std::string(str.first.get(),str.second) == "abababc");
+    }
 
     SECTION("compress short content")
     {
@@ -98,4 +131,240 @@ TEST_CASE("compression position test","[lz77][compression]")
         std::cout<<"Compressing rate is "<< static_cast<double>(str.second) / static_cast<double>(result.second) <<std::endl;
 
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("lz77 presized decompression","[lz77][compression]")
+{
+    using namespace data_packet;
+
+    SECTION("decode into a buffer of the original size")
+    {
+        std::string content;
+        for (int i = 0; i < 20000; ++i)
+        {
+            content.push_back(static_cast<char>('a' + (i * 7 + i / 97) % 23));
+        }
+        auto result = lz77_compress(content.begin(),content.end());
+        auto str = lz77_decompress(result.first.get(),result.first.get() + result.second,content.size());
+
+        REQUIRE(str.second == content.size());
+        CHECK(std::string(str.first.get(),str.second) == content);
+
+        std::list<char> list(result.first.get(),result.first.get() + result.second);
+        str = lz77_decompress(list.begin(),list.end(),content.size());
+        CHECK(std::string(str.first.get(),str.second) == content);
+    }
+
+    SECTION("overlapping copies with every short period")
+    {
+        // 偏移1到17的匹配与自身重叠，长度覆盖整块复制的各种余数
+        for (unsigned int offset = 1; offset <= 17; ++offset)
+        {
+            for (unsigned int length : {1u, 7u, 8u, 9u, 16u, 31u, 255u})
+            {
+                std::string tokens;
+                std::string expected;
+                for (unsigned int i = 0; i < offset; ++i)
+                {
+                    tokens += std::string{'\0', '\0', '\0', static_cast<char>('a' + i)};
+                    expected.push_back(static_cast<char>('a' + i));
+                }
+                tokens += std::string{'\0', static_cast<char>(offset), static_cast<char>(length), '\0'};
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    expected.push_back(expected[expected.size() - offset]);
+                }
+
+                auto str = lz77_decompress(tokens.begin(),tokens.end(),expected.size());
+                REQUIRE(str.second == expected.size());
+                CHECK(std::string(str.first.get(),str.second) == expected);
+                CHECK(lz77_decompress(tokens.begin(),tokens.end()).second == expected.size());
+            }
+        }
+    }
+
+    SECTION("malformed data is rejected")
+    {
+        using tokens = std::string;
+        auto decompress = [](const tokens& data, size_t size)
+        {
+            return lz77_decompress(data.begin(),data.end(),size);
+        };
+
+        // 长度不是4的整数倍
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0'}, 0));
+        CHECK_THROWS(decompress(tokens{}, 0));
+        // 匹配源早于数据开头
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0', 'a', '\0', '\2', '\3', '\0'}, 4));
+        // 偏移为0的匹配
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0', 'a', '\0', '\0', '\3', '\0'}, 4));
+        // 还原的长度与原始长度不符
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0', 'a', '\0', '\1', '\3', '\0'}, 3));
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0', 'a', '\0', '\1', '\3', '\0'}, 5));
+        // 原始长度远超压缩数据所能还原的长度
+        CHECK_THROWS(decompress(tokens{'\0', '\0', '\0', '\0'}, size_t{1} << 40));
+
+        auto str = decompress(tokens{'\0', '\0', '\0', 'a', '\0', '\1', '\3', '\0'}, 4);
+        CHECK(std::string(str.first.get(),str.second) == "aaaa");
+    }
+}
+
+TEST_CASE("lz77 sequence format","[lz77][compression]")
+{
+    using namespace data_packet;
+
+    auto round_trip = [](const std::string& content)
+    {
+        auto result = lz77_sequence_compress(content.begin(),content.end());
+        auto str = lz77_sequence_decompress(result.first.get(),result.first.get() + result.second);
+        REQUIRE(str.second == content.size());
+        CHECK(std::string(str.first.get(),str.second) == content);
+        return result.second;
+    };
+
+    SECTION("round trip")
+    {
+        CHECK(round_trip("") == 1);
+        CHECK(round_trip("a") == 3);
+        round_trip("abcabcaaaabccccbcd");
+        round_trip("A Comprehensive Exploration of Digital Technology and Its Societal Impacts");
+
+        std::list<char> list{'a','b','a','b','a','b','a','b','c'};
+        auto result = lz77_sequence_compress(list.begin(),list.end());
+        auto str = lz77_sequence_decompress(result.first.get(),result.first.get() + result.second);
+        CHECK(std::string(str.first.get(),str.second) == "ababababc");
+    }
+
+    SECTION("literal runs and long matches")
+    {
+        // 随机字面量每字节只增加很少的开销，长游程由重叠匹配表示
+        std::string random(100000, '\0');
+        uint32_t seed = 1;
+        for (auto& c : random)
+        {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<char>(seed >> 24);
+        }
+        const auto random_size = round_trip(random);
+        CHECK(random_size < random.size() + random.size() / 200);
+        CHECK(random_size + random.size() / 2 < lz77_compress(random.begin(),random.end()).second);
+        CHECK(round_trip(std::string(1000000, 'z')) < 4100);
+
+        // 相同的记录之间插入不同的字段，匹配沿用上一个偏移
+        std::string records;
+        for (int i = 0; i < 2000; ++i)
+        {
+            records += "name=backup;size=" + std::to_string(i % 10) + ";state=done;owner=root;\n";
+        }
+        CHECK(round_trip(records) < records.size() / 20);
+    }
+
+    SECTION("long distance matching")
+    {
+        // 相隔1 MiB的两段相同的随机数据，超出match_finder的窗口
+        auto random = [](size_t size, uint32_t seed)
+        {
+            std::string data(size, '\0');
+            for (auto& c : data)
+            {
+                seed = seed * 1103515245 + 12345;
+                c = static_cast<char>(seed >> 24);
+            }
+            return data;
+        };
+        const auto repeated = random(200000, 3);
+        const auto content = repeated + random(1 << 20, 4) + repeated.substr(1000) + "tail";
+
+        auto near = lz77_sequence_compress(content.begin(),content.end());
+        auto far = lz77_sequence_compress(content.begin(),content.end(),lz77_parameters{21});
+        CHECK(near.second > content.size() - 1000);
+        CHECK(far.second + repeated.size() - 2000 < near.second);
+
+        auto str = lz77_sequence_decompress(far.first.get(),far.first.get() + far.second);
+        REQUIRE(str.second == content.size());
+        CHECK(std::string(str.first.get(),str.second) == content);
+
+        // 窗口小于重复内容的距离时找不到匹配
+        auto small = lz77_sequence_compress(content.begin(),content.end(),lz77_parameters{MIN_WINDOW_LOG});
+        CHECK(small.second > content.size() - 1000);
+    }
+
+    SECTION("compression levels")
+    {
+        std::ifstream file(R"(../test/static/test.txt)");
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        const auto text = buffer.str() + buffer.str().substr(100) + buffer.str().substr(0, 5000);
+
+        std::vector<size_t> sizes;
+        for (unsigned int level = MIN_LEVEL; level <= MAX_LEVEL; ++level)
+        {
+            auto result = lz77_sequence_compress(text.begin(),text.end(),lz77_parameters{0, level});
+            auto str = lz77_sequence_decompress(result.first.get(),result.first.get() + result.second);
+            REQUIRE(str.second == text.size());
+            CHECK(std::string(str.first.get(),str.second) == text);
+            sizes.push_back(result.second);
+        }
+        CHECK(sizes.back() < sizes.front());
+        CHECK(sizes[DEFAULT_LEVEL - 1] == lz77_sequence_compress(text.begin(),text.end()).second);
+        CHECK(sizes[6] <= sizes[5]);
+
+        // 最优划分与长距离匹配组合，以及长游程
+        const auto runs = std::string(100000, 'a') + text + std::string(70000, 'a') + text;
+        for (const unsigned int level : {MIN_LEVEL, 5u, MAX_LEVEL})
+        {
+            auto result = lz77_sequence_compress(runs.begin(),runs.end(),lz77_parameters{MIN_WINDOW_LOG, level});
+            auto str = lz77_sequence_decompress(result.first.get(),result.first.get() + result.second);
+            REQUIRE(str.second == runs.size());
+            CHECK(std::string(str.first.get(),str.second) == runs);
+            CHECK(result.second < sizes[level - 1] + 1500);
+        }
+    }
+
+    SECTION("binary tree candidates")
+    {
+        const std::string content = "abcdxabcdeyabcdefzabcdefg";
+        detail::binary_tree_finder finder(content.data(), content.data() + content.size(), 16, 64);
+        std::vector<std::pair<unsigned int, unsigned int>> matches;
+        for (size_t i = 0; i + 1 < content.size() - 6; ++i)
+        {
+            finder.insert(content.data() + i);
+        }
+        // 在"abcdefg"处：abcdef（偏移7）最长，abcde（偏移14）与abcd（偏移21）更短且更远，不会作为候选
+        finder.find(content.data() + content.size() - 7, matches);
+        REQUIRE(!matches.empty());
+        CHECK(matches.back() == std::pair<unsigned int, unsigned int>{7, 6});
+        for (size_t i = 1; i < matches.size(); ++i)
+        {
+            CHECK(matches[i].second > matches[i - 1].second);
+        }
+    }
+
+    SECTION("byte layout")
+    {
+        // 4个字面量 + 偏移为4、长度为8的匹配，最后一个序列只含字面量x
+        const std::string content = "abcdabcdabcdx";
+        auto result = lz77_sequence_compress(content.begin(),content.end());
+        const std::vector<uint8_t> expected = {13, 0x44, 'a', 'b', 'c', 'd', 4, 0x10, 'x'};
+        REQUIRE(result.second == expected.size());
+        CHECK(std::equal(expected.begin(), expected.end(), reinterpret_cast<const uint8_t*>(result.first.get())));
+    }
+
+    SECTION("corrupted data")
+    {
+        auto decompress = [](const std::vector<uint8_t>& data)
+        {
+            const auto* begin = reinterpret_cast<const char*>(data.data());
+            return lz77_sequence_decompress(begin, begin + data.size());
+        };
+
+        CHECK_THROWS(decompress({}));
+        CHECK_THROWS(decompress({5, 0x20, 'a'}));                  // 字面量不完整
+        CHECK_THROWS(decompress({8, 0x10, 'a', 2, 0x00}));         // 偏移超出已还原的数据
+        CHECK_THROWS(decompress({8, 0x10, 'a', 0}));               // 没有可沿用的偏移
+        CHECK_THROWS(decompress({2, 0x20, 'a', 'b', 'c'}));        // 字面量超出原始长度
+        CHECK_THROWS(decompress({1, 0x10, 'a', 0x00}));            // 多余的数据
+        CHECK_THROWS(decompress({0xff, 0xff, 0xff, 0xff, 0x0f}));  // 原始长度与数据不相称
+        CHECK(std::string(decompress({5, 0x10, 'a', 1}).first.get(), 5) == "aaaaa");
+    }
+}
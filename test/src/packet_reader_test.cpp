@@ -0,0 +1,114 @@
+//
+// Created by hyh on 2026/1/14.
+//
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "../../include/packet/packet.h"
+#include "../../include/packet/packet_reader.h"
+
+TEST_CASE("packet_reader reads entries one at a time", "[packet][packet_reader]")
+{
+    namespace dp = data_packet;
+    namespace fs = std::filesystem;
+
+    fs::path root = fs::temp_directory_path() / "packet_reader_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "dir");
+    std::ofstream(root / "a.txt") << "first file content";
+    std::ofstream(root / "dir" / "b.txt") << "second file content";
+    fs::create_hard_link(root / "a.txt", root / "dir" / "a_link.txt");
+
+    auto pkt = dp::make_packet(root);
+    std::stringstream stream;
+    stream << pkt;
+    const auto bytes = stream.str();
+
+    SECTION("same entries as operator>>")
+    {
+        dp::packet_reader reader(stream);
+        CHECK(reader.info().get_file_number() == pkt.info().get_file_number());
+
+        dp::local_packet local_pkt;
+        size_t index = 0;
+        while (reader.next(local_pkt))
+        {
+            REQUIRE(index < pkt.packets().size());
+            const auto& expected = pkt.packets()[index].info();
+            CHECK(local_pkt.info().get_file_name() == expected.get_file_name());
+            CHECK(local_pkt.info().get_link_name() == expected.get_link_name());
+            CHECK(local_pkt.info().get_crc_32() == expected.get_crc_32());
+            CHECK(local_pkt.info().get_file_size() == expected.get_file_size());
+
+            bool same_data = std::equal(local_pkt.get_data().get(),
+                                        local_pkt.get_data().get() + local_pkt.info().get_file_size(),
+                                        pkt.packets()[index].get_data().get());
+            CHECK(same_data);
+            ++index;
+        }
+        CHECK(index == pkt.packets().size());
+        CHECK(reader.read_number() == pkt.info().get_file_number());
+    }
+
+    SECTION("read an entry at an offset")
+    {
+        dp::packet_reader reader(stream);
+        dp::local_packet local_pkt;
+        dp::qword offset = dp::file_header::SIZE;
+        std::vector<dp::qword> offsets;
+        while (reader.skip(local_pkt))
+        {
+            offsets.push_back(offset);
+            offset += local_pkt.info().header_size() + local_pkt.info().get_file_size();
+        }
+
+        // 倒序读取，与顺序读取的结果相同
+        for (size_t index = offsets.size(); index-- > 0;)
+        {
+            reader.read(offsets[index], local_pkt);
+            const auto& expected = pkt.packets()[index];
+            CHECK(local_pkt.info().get_file_name() == expected.info().get_file_name());
+            CHECK(std::equal(local_pkt.get_data().get(),
+                             local_pkt.get_data().get() + local_pkt.info().get_file_size(),
+                             expected.get_data().get()));
+        }
+        CHECK_THROWS_AS(reader.read(bytes.size() - 2, local_pkt), std::runtime_error);
+    }
+
+    SECTION("truncated stream")
+    {
+        std::stringstream truncated(bytes.substr(0, bytes.size() - 3));
+        dp::packet_reader reader(truncated);
+        dp::local_packet local_pkt;
+        CHECK_THROWS_AS([&]{ while (reader.next(local_pkt)) {} }(), std::runtime_error);
+    }
+
+    SECTION("unpacker restores links after files")
+    {
+        fs::path unpack_path = root.parent_path() / "packet_reader_unpack";
+        fs::remove_all(unpack_path);
+        fs::create_directories(unpack_path);
+
+        dp::packet_reader reader(stream);
+        dp::unpacker unpack(unpack_path);
+        dp::local_packet local_pkt;
+        while (reader.next(local_pkt))
+        {
+            unpack.unpack(local_pkt);
+        }
+        unpack.finish();
+
+        std::ifstream file(unpack_path / "dir" / "a_link.txt");
+        std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        CHECK(content == "first file content");
+        CHECK(fs::hard_link_count(unpack_path / "a.txt") == 2);
+
+        fs::remove_all(unpack_path);
+    }
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,113 @@
+//
+// Created by hyh on 2026/1/12.
+//
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "../../include/packet/packet.h"
+#include "../../include/packet/directory.h"
+#include "../../include/packet/packet_writer.h"
+
+namespace
+{
+    data_packet::word writer_version(const std::string& bytes)
+    {
+        data_packet::file_header header;
+        header.set_buffer(bytes.data());
+        return header.get_version();
+    }
+}
+
+TEST_CASE("packet_writer produces the same layout as operator<<", "[packet][packet_writer]")
+{
+    namespace dp = data_packet;
+    namespace fs = std::filesystem;
+
+    fs::path root = fs::temp_directory_path() / "packet_writer_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "dir");
+    std::ofstream(root / "a.txt") << "first file content";
+    std::ofstream(root / "dir" / "b.txt") << "second file content, a little longer";
+    fs::create_hard_link(root / "a.txt", root / "dir" / "a_link.txt");
+
+    auto pkt = dp::make_packet(root);
+
+    std::stringstream whole;
+    whole << pkt;
+
+    std::stringstream streamed;
+    {
+        dp::packet_writer writer(streamed);
+        for (const auto& local_pkt : pkt.packets())
+        {
+            writer.write(local_pkt);
+        }
+        writer.finish();
+
+        CHECK(writer.info().get_file_number() == pkt.info().get_file_number());
+        CHECK(writer.info().get_file_size() == pkt.info().get_file_size());
+        CHECK(writer.info().get_original_file_size() == pkt.info().get_original_file_size());
+        CHECK(writer.info().get_crc_32() == pkt.info().get_crc_32());
+    }
+
+    auto whole_bytes = whole.str();
+    auto streamed_bytes = streamed.str();
+    REQUIRE(whole_bytes.size() < streamed_bytes.size());
+
+    // 本地文件包部分逐字节相同（总文件头的版本与创建时间不同，末尾追加了中央目录与尾部）
+    const size_t entries_size = whole_bytes.size() - dp::file_header::SIZE;
+    bool same_entries = whole_bytes.compare(dp::file_header::SIZE, entries_size,
+                                            streamed_bytes, dp::file_header::SIZE, entries_size) == 0;
+    CHECK(same_entries);
+    CHECK(writer_version(streamed_bytes) == dp::ARCHIVE_EXTRA_VERSION);
+
+    // 流式写出的结果可以被原有的operator>>读取
+    dp::packet in_pkt;
+    streamed.seekg(0);
+    REQUIRE_NOTHROW(streamed >> in_pkt);
+    CHECK(in_pkt.info().check());
+    CHECK(in_pkt.packets().size() == pkt.packets().size());
+
+    SECTION("entries written in pieces")
+    {
+        std::stringstream pieces;
+        dp::packet_writer writer(pieces);
+        for (const auto& local_pkt : pkt.packets())
+        {
+            const auto& info = local_pkt.info();
+            const auto size = info.get_file_size();
+            writer.begin(info);
+            if (size == 0)
+            {
+                writer.end(info);
+                continue;
+            }
+            // 第一个字节先写占位，结束时回填
+            const dp::byte placeholder = 0;
+            writer.append(&placeholder, 1);
+            writer.append(local_pkt.get_data().get() + 1, size - 1);
+            CHECK_THROWS_AS(writer.write(local_pkt), std::logic_error);
+            writer.end(info, std::span<const dp::byte>(local_pkt.get_data().get(), 1));
+        }
+        writer.finish();
+
+        // 与整体写出的结果逐字节相同（创建时间除外）
+        const auto pieces_bytes = pieces.str();
+        REQUIRE(pieces_bytes.size() == streamed_bytes.size());
+        CHECK(pieces_bytes.compare(dp::file_header::SIZE, std::string::npos,
+                                   streamed_bytes, dp::file_header::SIZE, std::string::npos) == 0);
+
+        // 头部与数据量不符时报错
+        std::stringstream mismatch;
+        dp::packet_writer mismatch_writer(mismatch);
+        const auto& info = pkt.packets().back().info();
+        mismatch_writer.begin(info);
+        CHECK_THROWS_AS(mismatch_writer.end(info), std::logic_error);
+    }
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,57 @@
+//
+// Created by hyh on 2026/1/22.
+//
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../../include/file_system/path_matcher.h"
+
+using namespace data_packet;
+
+TEST_CASE("path_matcher", "[path_matcher]")
+{
+    SECTION("empty matcher")
+    {
+        const path_matcher matcher("\n\n");
+        REQUIRE(matcher.empty());
+        REQUIRE_FALSE(matcher.match("a.txt"));
+    }
+
+    SECTION("literal paths match exactly")
+    {
+        const path_matcher matcher("a.txt\n./dir/b.txt\r\nsub/\n");
+        REQUIRE_FALSE(matcher.empty());
+        REQUIRE(matcher.match("a.txt"));
+        REQUIRE(matcher.match("dir/b.txt"));
+        REQUIRE(matcher.match("sub"));
+        REQUIRE_FALSE(matcher.match("dir/a.txt"));
+        REQUIRE_FALSE(matcher.match("b.txt"));
+    }
+
+    SECTION("glob patterns match the whole relative path")
+    {
+        path_matcher matcher;
+        matcher.add("*.log");
+        matcher.add("doc/?.md");
+        matcher.add("img/[ab]*");
+        REQUIRE(matcher.match("x.log"));
+        REQUIRE(matcher.match("a/b/c.log"));
+        REQUIRE(matcher.match("doc/1.md"));
+        REQUIRE_FALSE(matcher.match("doc/12.md"));
+        REQUIRE(matcher.match("img/a.png"));
+        REQUIRE(matcher.match("img/b/c.png"));
+        REQUIRE_FALSE(matcher.match("img/c.png"));
+        REQUIRE_FALSE(matcher.match("x.log.bak"));
+    }
+
+    SECTION("parent directories select their contents")
+    {
+        const path_matcher matcher("dir/sub");
+        REQUIRE(matcher.match_self_or_parent("dir/sub"));
+        REQUIRE(matcher.match_self_or_parent("dir/sub/a.txt"));
+        REQUIRE(matcher.match_self_or_parent("dir/sub/deep/a.txt"));
+        REQUIRE_FALSE(matcher.match_self_or_parent("dir"));
+        REQUIRE_FALSE(matcher.match_self_or_parent("dir/subway"));
+        REQUIRE_FALSE(matcher.match_self_or_parent("other/dir/sub"));
+    }
+}
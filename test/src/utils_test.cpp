@@ -4,6 +4,11 @@
 
 #include "../../include/utils/byte_conversion.h"
 #include "../../include/utils/checksum.h"
+#include "../../include/utils/parallel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 
@@ -81,4 +86,22 @@ TEST_CASE("checksum","[utils]")
     auto result = calculate_checksum(datas);
 
     REQUIRE(result == 0xfbfcfdfe);
-}
\ No newline at end of file
+}
+TEST_CASE("parallel for","[utils][parallel]")
+{
+    using namespace data_packet;
+
+    SECTION("every index is visited exactly once")
+    {
+        std::vector<int> visited(1000, 0);
+        parallel_for(visited.size(), 4, [&](size_t i){ visited[i]++; });
+        bool all_once = std::all_of(visited.begin(), visited.end(), [](int v){ return v == 1; });
+        REQUIRE(all_once);
+    }
+
+    SECTION("exceptions are rethrown")
+    {
+        auto run = []{ parallel_for(100, 4, [](size_t i){ if (i == 42) throw std::runtime_error("42"); }); };
+        REQUIRE_THROWS_AS(run(), std::runtime_error);
+    }
+}